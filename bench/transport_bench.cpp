@@ -0,0 +1,214 @@
+// Transport throughput benchmark: echoes messages through StdioAdapter,
+// UringAdapter and ShmAdapter and reports messages per second.
+//
+//   transport_bench [messages] [payload_bytes]
+//
+// A feeder thread writes every message into the adapter's input, the main
+// thread echoes each one back with readMessage()/writeMessage(), and a
+// drain thread reads the output until all replies have arrived. StdioAdapter
+// only works on fds 0/1, so those are redirected to pipes for its run; it
+// also appends every message to bridge_stdio.log, which is part of its cost,
+// so the benchmark runs from a temporary directory. The shared-memory run
+// talks to its adapter through ShmClient.
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "mcp_logger.h"
+#include "shm_adapter.h"
+#include "shm_client.h"
+#include "stdio_adapter.h"
+#include "uring_adapter.h"
+
+namespace {
+
+struct Result {
+  size_t echoed = 0;
+  double seconds = 0;
+};
+
+void writeAll(int fd, const std::string &data) {
+  size_t offset = 0;
+  while (offset < data.size()) {
+    ssize_t n = ::write(fd, data.data() + offset, data.size() - offset);
+    if (n <= 0) return;
+    offset += static_cast<size_t>(n);
+  }
+}
+
+size_t countLines(int fd, size_t expected) {
+  char buffer[64 * 1024];
+  size_t lines = 0;
+  while (lines < expected) {
+    ssize_t n = ::read(fd, buffer, sizeof(buffer));
+    if (n <= 0) break;
+    for (ssize_t i = 0; i < n; ++i) lines += buffer[i] == '\n';
+  }
+  return lines;
+}
+
+// Feed 'messages' lines into inFd and end the stream, echo them through
+// 'adapter' and count the replies arriving on outFd
+Result run(ITransportAdapter &adapter, int inFd, int outFd, size_t messages,
+           const std::string &line) {
+  Result result;
+  auto start = std::chrono::steady_clock::now();
+  std::thread feeder([&] {
+    std::string batch;
+    for (size_t i = 0; i < messages; ++i) {
+      batch += line;
+      if (batch.size() >= 64 * 1024) {
+        writeAll(inFd, batch);
+        batch.clear();
+      }
+    }
+    writeAll(inFd, batch);
+    // A socket stays open for the replies; a pipe end can just be closed
+    if (::shutdown(inFd, SHUT_WR) != 0) ::close(inFd);
+  });
+  size_t received = 0;
+  std::thread drain([&] { received = countLines(outFd, messages); });
+
+  std::string message;
+  while (adapter.readMessage(message)) {
+    adapter.writeMessage(message);
+    ++result.echoed;
+  }
+  feeder.join();
+  drain.join();
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  if (received != messages) {
+    std::cerr << "warning: " << received << " of " << messages
+              << " replies arrived\n";
+  }
+  return result;
+}
+
+void report(const char *name, const Result &result) {
+  std::printf("%-28s %10zu msgs %8.3f s %12.0f msgs/s\n", name, result.echoed,
+              result.seconds, result.echoed / result.seconds);
+}
+
+Result benchStdio(size_t messages, const std::string &line) {
+  int in[2], out[2];
+  if (pipe(in) != 0 || pipe(out) != 0) std::exit(1);
+  std::fflush(stdout);
+  int savedIn = dup(0), savedOut = dup(1);
+  dup2(in[0], 0);
+  dup2(out[1], 1);
+  ::close(in[0]);
+  ::close(out[1]);
+  Result result;
+  {
+    StdioAdapter adapter;
+    result = run(adapter, in[1], out[0], messages, line);
+    std::cout.flush();
+  }
+  dup2(savedIn, 0);
+  dup2(savedOut, 1);
+  ::close(savedIn);
+  ::close(savedOut);
+  ::close(out[0]);
+  std::cin.clear();
+  return result;
+}
+
+Result benchUringPipes(size_t messages, const std::string &line) {
+  int in[2], out[2];
+  if (pipe(in) != 0 || pipe(out) != 0) std::exit(1);
+  Result result;
+  {
+    UringAdapter adapter(in[0], out[1]);
+    result = run(adapter, in[1], out[0], messages, line);
+  }
+  ::close(in[0]);
+  ::close(out[1]);
+  ::close(out[0]);
+  return result;
+}
+
+// One socketpair end is both input and output, as for a local client
+Result benchUringSocket(size_t messages, const std::string &line,
+                        bool &multishot) {
+  int fds[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) std::exit(1);
+  Result result;
+  {
+    UringAdapter adapter(fds[0], fds[0]);
+    result = run(adapter, fds[1], fds[1], messages, line);
+    // Checked afterwards: the adapter drops to single reads if the kernel
+    // cannot use the provided buffers
+    multishot = adapter.usingMultishot();
+  }
+  ::close(fds[0]);
+  ::close(fds[1]);
+  return result;
+}
+
+Result benchShm(size_t messages, const std::string &line) {
+  std::string name = "/mcp_transport_bench." + std::to_string(getpid());
+  std::string payload = line.substr(0, line.size() - 1);
+  ShmAdapter adapter(name);
+  ShmClient client(name);
+
+  Result result;
+  auto start = std::chrono::steady_clock::now();
+  std::thread feeder([&] {
+    for (size_t i = 0; i < messages; ++i) client.send(payload);
+  });
+  size_t received = 0;
+  std::thread drain([&] {
+    std::string reply;
+    while (received < messages && client.receive(reply)) ++received;
+  });
+  std::string message;
+  while (result.echoed < messages && adapter.readMessage(message)) {
+    adapter.writeMessage(message);
+    ++result.echoed;
+  }
+  feeder.join();
+  drain.join();
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return result;
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  size_t messages = argc > 1 ? std::stoul(argv[1]) : 200000;
+  size_t payload = argc > 2 ? std::stoul(argv[2]) : 256;
+  std::string line = "{\"jsonrpc\":\"2.0\",\"method\":\"bench\",\"params\":\"" +
+                     std::string(payload, 'x') + "\"}\n";
+
+  auto dir = std::filesystem::temp_directory_path() / "mcp_transport_bench";
+  std::filesystem::create_directories(dir);
+  std::filesystem::current_path(dir);
+
+  spdlog::set_level(spdlog::level::warn);
+  std::printf("%zu messages of %zu bytes\n", messages, line.size());
+  report("StdioAdapter (pipes)", benchStdio(messages, line));
+  if (!UringAdapter::available()) {
+    std::printf("io_uring unavailable; UringAdapter uses read()/write()\n");
+  }
+  report("UringAdapter (pipes)", benchUringPipes(messages, line));
+  bool multishot = false;
+  Result socket = benchUringSocket(messages, line, multishot);
+  report(multishot ? "UringAdapter (socket, multishot)"
+                   : "UringAdapter (socket)",
+         socket);
+  report("ShmAdapter (shared memory)", benchShm(messages, line));
+  std::filesystem::current_path(std::filesystem::temp_directory_path());
+  std::filesystem::remove_all(dir);
+  return 0;
+}
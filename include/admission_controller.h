@@ -0,0 +1,188 @@
+#pragma once
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using json = nlohmann::json;
+
+// JSON-RPC error code returned when a call is rejected by admission control
+constexpr int kServerBusyError = -32001;
+
+// Thrown when a call cannot be admitted because its wait queue is full
+class ServerBusyError : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+// Per-tool limits (0 = unlimited concurrency / no waiting)
+struct AdmissionLimits {
+  size_t maxConcurrency = 0;
+  size_t maxQueued = 0;
+};
+
+// Admission control for tool calls: per-tool concurrency caps with bounded
+// wait queues, plus a global in-flight limit with its own queue bound.
+//
+// A call that cannot start right away waits in its queue; if the queue that
+// is blocking it is already full, it is rejected with ServerBusyError
+// instead, so overload turns into fast, well-defined rejections rather than
+// unbounded latency. Queued calls are admitted in arrival order.
+//
+// A queued call need not hold a thread: tryAdmit() parks a continuation that
+// is handed the ticket when a slot frees up, so the caller can return its
+// thread to a scheduler and resubmit the call from the continuation, and a
+// coroutine can co_await admitAsync() to stay suspended while it waits.
+// admit() blocks the calling thread instead; setBlockingWaitLimit() caps how
+// many threads may do that at once.
+class AdmissionController {
+ public:
+  // Releases the admitted slot on destruction
+  class Ticket {
+   public:
+    Ticket() = default;
+    Ticket(AdmissionController *owner, std::string tool, bool global)
+        : owner_(owner), tool_(std::move(tool)), global_(global) {}
+    Ticket(Ticket &&other) noexcept
+        : owner_(other.owner_),
+          tool_(std::move(other.tool_)),
+          global_(other.global_) {
+      other.owner_ = nullptr;
+    }
+    Ticket &operator=(Ticket &&other) noexcept;
+    ~Ticket() { release(); }
+
+    void release();
+
+   private:
+    AdmissionController *owner_ = nullptr;
+    std::string tool_;
+    bool global_ = true;
+  };
+
+  // Receives the ticket of a parked call once it is admitted
+  using Admitted = std::function<void(Ticket)>;
+
+  // Awaitable returned by admitAsync(); yields the ticket
+  class AdmitAwaiter {
+   public:
+    using Resume = std::function<void(std::coroutine_handle<>)>;
+
+    AdmitAwaiter(AdmissionController &owner, std::string tool,
+                 const AdmissionLimits &limits, Resume resume,
+                 bool countGlobal)
+        : owner_(owner),
+          tool_(std::move(tool)),
+          limits_(limits),
+          resume_(std::move(resume)),
+          countGlobal_(countGlobal) {}
+
+    bool await_ready() const noexcept { return false; }
+    // Suspends only if the call was queued
+    bool await_suspend(std::coroutine_handle<> handle);
+    Ticket await_resume();
+
+   private:
+    AdmissionController &owner_;
+    std::string tool_;
+    AdmissionLimits limits_;
+    Resume resume_;
+    bool countGlobal_;
+    Ticket ticket_;
+    std::exception_ptr error_;
+  };
+
+  // Global limit across all tools (0 = unlimited) and its queue bound
+  void setGlobalLimits(size_t maxInFlight, size_t maxQueued);
+
+  // Threads that may block in admit() at the same time; further calls that
+  // would have to wait there are rejected. Unlimited by default.
+  void setBlockingWaitLimit(size_t maxBlocked);
+
+  // Wait for a slot for 'tool'. Throws ServerBusyError if the call would have
+  // to wait in a queue that is full. Nested calls made on behalf of an
+  // already admitted call (countGlobal = false) only take a per-tool slot, so
+  // they cannot deadlock against the global limit their parent holds.
+  Ticket admit(const std::string &tool, const AdmissionLimits &limits,
+               bool countGlobal = true);
+
+  // Like admit(), without blocking. Returns true with 'ticket' set if a slot
+  // is free now. Otherwise parks 'admitted' and returns false; it is called
+  // with the ticket once the call is admitted, on the thread that released
+  // the slot (possibly before tryAdmit() returns), so it should only hand
+  // the call back to a scheduler and must not throw.
+  bool tryAdmit(const std::string &tool, const AdmissionLimits &limits,
+                Ticket &ticket, Admitted admitted, bool countGlobal = true);
+
+  // co_await in a coroutine (see ToolTask): admission without holding a
+  // thread. A queued call stays suspended and is resumed through 'resume'
+  // (e.g. IoExecutor::post) once admitted. Throws ServerBusyError from the
+  // co_await when the queue is full.
+  AdmitAwaiter admitAsync(const std::string &tool,
+                          const AdmissionLimits &limits,
+                          AdmitAwaiter::Resume resume,
+                          bool countGlobal = true) {
+    return AdmitAwaiter(*this, tool, limits, std::move(resume), countGlobal);
+  }
+
+  // Counters for tuning the limits
+  json stats() const;
+
+ private:
+  struct ToolState {
+    size_t inFlight = 0;
+    size_t waiting = 0;
+    size_t peakInFlight = 0;
+    uint64_t admitted = 0;
+    uint64_t queued = 0;  // admitted after waiting
+    uint64_t rejected = 0;
+  };
+
+  struct Waiter {
+    std::string tool;
+    AdmissionLimits limits;
+    bool countGlobal;
+    bool blocking;
+    // Queued because the global limit was reached (counts against maxQueued_)
+    bool globalWait;
+    Admitted admitted;
+  };
+
+  bool blocked(const ToolState &state, const AdmissionLimits &limits,
+               bool countGlobal) const;
+  void take(ToolState &state, bool countGlobal, bool waited);
+  // Shared by admit() ('blocking') and tryAdmit()
+  bool request(const std::string &tool, const AdmissionLimits &limits,
+               bool countGlobal, bool blocking, Ticket &ticket,
+               Admitted admitted);
+  // Admit queued calls that fit now, oldest first; the caller runs the
+  // returned continuations once the mutex is released
+  std::vector<std::pair<Admitted, Ticket>> admitQueued();
+  static void handOff(std::vector<std::pair<Admitted, Ticket>> ready);
+  void release(const std::string &tool, bool global);
+
+  mutable std::mutex mutex_;
+  std::map<std::string, ToolState> tools_;
+  std::deque<Waiter> queue_;
+  size_t maxInFlight_ = 0;
+  size_t maxQueued_ = 0;
+  size_t maxBlocked_ = std::numeric_limits<size_t>::max();
+  size_t inFlight_ = 0;
+  size_t waiting_ = 0;
+  // Queued calls that found the global limit reached; bounded by maxQueued_
+  size_t globalWaiting_ = 0;
+  size_t blockedWaiting_ = 0;
+  size_t peakInFlight_ = 0;
+  uint64_t admitted_ = 0;
+  uint64_t rejected_ = 0;
+};
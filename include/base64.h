@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Base64 (RFC 4648, with padding) encoding for binary content sent over
+// JSON-RPC (resource blobs, binary tool results)
+namespace Base64 {
+
+// Number of characters produced for 'size' input bytes
+constexpr size_t encodedSize(size_t size) { return (size + 2) / 3 * 4; }
+
+// Encode 'size' bytes into 'out', which must hold encodedSize(size) chars.
+// Uses AVX2 or SSSE3 when the CPU has them.
+void encode(const uint8_t *data, size_t size, char *out);
+
+// Portable encoder that encode() falls back to; the SIMD paths must match it
+void encodeScalar(const uint8_t *data, size_t size, char *out);
+
+// Encode into a new string
+std::string encode(const void *data, size_t size);
+
+// Append the encoding of 'size' bytes to 'out' without intermediate copies
+void append(std::string &out, const void *data, size_t size);
+
+// Encoder in use: "avx2", "ssse3" or "scalar"
+const char *implementation();
+
+}  // namespace Base64
@@ -0,0 +1,117 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Event loop that resumes suspended coroutines (see ToolTask) when a file
+// descriptor becomes ready or a timer expires.
+//
+// A few threads wait in epoll for every suspended coroutine at once, so
+// thousands of tool calls blocked on pipes, sockets or timers cost memory
+// for their frames but no threads. Resumed coroutines run on the executor
+// threads until their next suspension, so CPU-heavy work inside an async
+// handler should be kept short.
+//
+// fd readiness needs epoll (Linux); elsewhere awaiting readable()/writable()
+// throws std::runtime_error, while timers and schedule() still work.
+class IoExecutor {
+ public:
+  explicit IoExecutor(size_t threads = 2);
+  // Stops the threads. Coroutines still suspended are never resumed, so
+  // only destroy the executor once every call using it has completed.
+  ~IoExecutor();
+
+  IoExecutor(const IoExecutor &) = delete;
+  IoExecutor &operator=(const IoExecutor &) = delete;
+
+  // Registration for one fd wait; lives in the awaiting coroutine's frame
+  struct Waiter {
+    std::coroutine_handle<> handle;
+    int fd = -1;
+    uint32_t revents = 0;
+  };
+
+  struct FdAwaiter {
+    IoExecutor &executor;
+    int fd;
+    uint32_t events;
+    Waiter waiter{};
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle);
+    // Returned epoll events (EPOLLIN, EPOLLHUP, ...)
+    uint32_t await_resume() const noexcept { return waiter.revents; }
+  };
+
+  struct SleepAwaiter {
+    IoExecutor &executor;
+    std::chrono::steady_clock::time_point deadline;
+
+    bool await_ready() const noexcept {
+      return deadline <= std::chrono::steady_clock::now();
+    }
+    void await_suspend(std::coroutine_handle<> handle) {
+      executor.addTimer(deadline, handle);
+    }
+    void await_resume() const noexcept {}
+  };
+
+  struct ScheduleAwaiter {
+    IoExecutor &executor;
+
+    bool await_ready() const noexcept { return false; }
+    void await_suspend(std::coroutine_handle<> handle) {
+      executor.post(handle);
+    }
+    void await_resume() const noexcept {}
+  };
+
+  // co_await executor.readable(fd) suspends until 'fd' is readable (or hung
+  // up). Only one coroutine may wait on a given fd at a time.
+  FdAwaiter readable(int fd);
+  FdAwaiter writable(int fd);
+  SleepAwaiter sleepFor(std::chrono::milliseconds duration) {
+    return {*this, std::chrono::steady_clock::now() + duration};
+  }
+  // Continue on an executor thread (e.g. to leave a request thread)
+  ScheduleAwaiter schedule() { return {*this}; }
+
+  // Resume 'handle' on an executor thread
+  void post(std::coroutine_handle<> handle);
+
+  size_t threadCount() const { return threads_.size(); }
+  // Coroutines currently suspended on an fd or timer
+  size_t waitingCount() const { return waiting_.load(); }
+
+ private:
+  void run();
+  void wake();
+  void addTimer(std::chrono::steady_clock::time_point deadline,
+                std::coroutine_handle<> handle);
+  void watch(Waiter &waiter, uint32_t events);
+  // Collect due timers and posted handles; returns the next timer deadline
+  // as a timeout in ms (-1 if there is none)
+  int collectReady(std::vector<std::coroutine_handle<>> &ready);
+
+  int epollFd_ = -1;
+  int wakeFd_ = -1;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;  // used instead of epoll where unavailable
+  bool stopping_ = false;
+  std::deque<std::coroutine_handle<>> posted_;
+  std::multimap<std::chrono::steady_clock::time_point,
+                std::coroutine_handle<>>
+      timers_;
+  std::atomic<size_t> waiting_{0};
+
+  std::vector<std::thread> threads_;
+};
@@ -22,6 +22,18 @@ public:
     std::string createErrorResponse(const std::string &id, int errorCode,
                                     const std::string &errorMessage);
 
+    // Top-level "method" value from a single scan without building the
+    // document (used to pick a scheduling lane); "" if absent or malformed
+    std::string peekMethod(const std::string &jsonStr);
+
+    // Top-level "id" (as parseRequest reports it) without keeping the rest of
+    // the document, so answering an oversized request stays cheap
+    std::string peekId(const std::string &jsonStr);
+
+    // A request id ("id" or a cancellation's "requestId") as the string key
+    // parseRequest reports: strings as-is, numbers in their exact JSON form
+    static std::string idString(const json &id);
+
     // Create JSON-RPC notification
     std::string createNotification(const std::string &method,
                                    const json &params);
@@ -32,6 +44,9 @@ public:
     static std::string createJsonArray(const std::vector<std::string> &items);
 
 private:
+    // Inverse of idString for responses: numeric keys go back as numbers
+    static json idValue(const std::string &id);
+
     // Legacy parsing helpers (will be replaced with nlohmann/json)
     std::string extractValue(const std::string &json, const std::string &key);
     std::map<std::string, std::string> parseParams(const std::string &paramsJson);
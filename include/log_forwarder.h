@@ -0,0 +1,107 @@
+#pragma once
+#include <spdlog/logger.h>
+#include <spdlog/sinks/base_sink.h>
+#include <spdlog/sinks/dist_sink.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <thread>
+
+using json = nlohmann::json;
+
+struct LogForwarderOptions {
+  size_t queueCapacity = 1024;  // records waiting to be sent
+  double ratePerSecond = 100;   // sustained notifications per second
+  double burst = 200;           // token bucket size
+  size_t maxMessageBytes = 4096;  // longer messages are truncated
+  int dropReportIntervalMs = 1000;  // at most one "dropped" notice per interval
+};
+
+// spdlog sink that forwards records at or above the client's level (set
+// through 'logging/setLevel') as 'notifications/message'.
+//
+// Logging threads only filter, rate-limit and enqueue; a background thread
+// does the sending, so a slow client never stalls request processing.
+// Records over the token-bucket rate or beyond the queue bound are dropped
+// and counted, and the client is told how many were lost. Anything logged
+// while sending (on the forwarder thread) is not forwarded again, nor are
+// message payloads (McpLogging::payload_logger()).
+class LogForwarder : public spdlog::sinks::base_sink<std::mutex>,
+                     public std::enable_shared_from_this<LogForwarder> {
+ public:
+  // Receives the 'notifications/message' params
+  using Sender = std::function<void(const json &)>;
+
+  LogForwarder(Sender sender, const LogForwarderOptions &options = {});
+  ~LogForwarder() override;
+
+  // Add this sink to 'hub', a sink of 'logger' (McpLogging::forward_sink),
+  // which may be logging meanwhile. While the client level is below the
+  // logger's, the logger's level is lowered to it; its other sinks should
+  // carry their own levels. stop() undoes both.
+  void attach(const std::shared_ptr<spdlog::logger> &logger,
+              const std::shared_ptr<spdlog::sinks::dist_sink_mt> &hub);
+
+  // Set the client level from an MCP level name ("debug" ... "emergency").
+  // Returns false for unknown names.
+  bool setLevel(const std::string &mcpLevel);
+  std::string level() const;
+
+  // Stop forwarding: leave the hub, restore the logger's level and join the
+  // sender thread
+  void stop();
+
+  json stats() const;
+
+  static std::string toMcpLevel(spdlog::level::level_enum level);
+
+ protected:
+  void sink_it_(const spdlog::details::log_msg &msg) override;
+  void flush_() override {}
+
+ private:
+  struct Record {
+    spdlog::level::level_enum level;
+    std::string logger;
+    std::string message;
+  };
+
+  void run();
+  bool takeToken();
+
+  Sender sender_;
+  LogForwarderOptions options_;
+  // Set by attach(), cleared by stop(); guarded by queueMutex_
+  std::weak_ptr<spdlog::logger> logger_;
+  std::weak_ptr<spdlog::sinks::dist_sink_mt> hub_;
+  spdlog::level::level_enum baseLevel_ = spdlog::level::info;
+  std::atomic<int> clientLevel_{spdlog::level::warn};
+
+  // Token bucket, guarded by the base_sink mutex
+  double tokens_;
+  std::chrono::steady_clock::time_point lastRefill_;
+
+  mutable std::mutex queueMutex_;
+  std::condition_variable queueCv_;
+  std::deque<Record> queue_;
+  bool stopping_ = false;
+
+  std::atomic<uint64_t> forwarded_{0};
+  std::atomic<uint64_t> droppedRate_{0};
+  std::atomic<uint64_t> droppedQueue_{0};
+  std::atomic<uint64_t> droppedInvalid_{0};  // could not be encoded
+  // Forwarder thread only
+  uint64_t reportedDrops_ = 0;
+  std::chrono::steady_clock::time_point lastDropReport_;
+
+  std::thread thread_;
+};
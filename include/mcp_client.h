@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "mcp_tool.h"
+
+using json = nlohmann::json;
+
+class McpServer;
+
+// Error from an in-process call, carrying the JSON-RPC error code the same
+// request would have been answered with over a transport
+class McpError : public std::runtime_error {
+ public:
+  McpError(int code, const std::string &message)
+      : std::runtime_error(message), code_(code) {}
+  int code() const { return code_; }
+
+ private:
+  int code_;
+};
+
+// In-process client for an McpServer living in the same process.
+//
+// Calls go straight to the registry, tool handlers, resource manager and
+// prompt registry with json values: nothing is serialized to JSON-RPC text
+// or parsed back. Admission control and worker-pool isolation still apply,
+// so tool calls behave exactly as they would for a remote client. Safe to
+// use from several threads; the server must outlive the client.
+class McpClient {
+ public:
+  explicit McpClient(McpServer &server);
+
+  std::vector<McpTool> listTools() const;
+
+  // The tool's own return value, binary content still json::binary. Throws
+  // McpError for unknown tools or when the server is overloaded; exceptions
+  // thrown by the tool propagate.
+  json callTool(const std::string &name,
+                const json &arguments = json::object()) const;
+  // The MCP 'tools/call' result ({"content": [...]}) for the call, binary
+  // content base64 encoded
+  json callToolResult(const std::string &name,
+                      const json &arguments = json::object()) const;
+
+  json listResources(const std::string &cursor = "") const;
+  json readResource(const std::string &uri, uint64_t offset = 0,
+                    size_t length = 0) const;
+
+  json listPrompts() const;
+  json getPrompt(const std::string &name,
+                 const json &arguments = json::object()) const;
+
+ private:
+  McpServer &server_;
+};
@@ -1,6 +1,7 @@
 
 #pragma once
 #include <spdlog/sinks/basic_file_sink.h>
+#include <spdlog/sinks/dist_sink.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 #include <spdlog/spdlog.h>
 
@@ -11,6 +12,40 @@
 // Logging setup utility for MCP server
 namespace McpLogging {
 
+// Name of the logger for message payloads: the [IN]/[OUT] request and
+// response traces and tool arguments. It writes to the same file and console
+// as the default logger, but LogForwarder never sends its records to the
+// client.
+inline constexpr const char* kPayloadLoggerName = "mcp_payload";
+
+inline std::shared_ptr<spdlog::logger> payload_logger() {
+  if (auto logger = spdlog::get(kPayloadLoggerName)) return logger;
+  // setup_logger() was not called: share the default logger's sinks
+  auto logger = spdlog::default_logger()->clone(kPayloadLoggerName);
+  try {
+    spdlog::register_logger(logger);
+  } catch (const spdlog::spdlog_ex&) {
+    // Registered concurrently by another thread
+    if (auto existing = spdlog::get(kPayloadLoggerName)) return existing;
+  }
+  return logger;
+}
+
+// The sink of 'logger' that log forwarders (LogForwarder) are added to and
+// removed from: a dist_sink installed by setup_logger(), so the logger's own
+// sink list never changes while it is in use. Null if there is none.
+inline std::shared_ptr<spdlog::sinks::dist_sink_mt> forward_sink(
+    const std::shared_ptr<spdlog::logger>& logger) {
+  for (const auto& sink : logger->sinks()) {
+    if (auto hub = std::dynamic_pointer_cast<spdlog::sinks::dist_sink_mt>(sink)) {
+      return hub;
+    }
+  }
+  return nullptr;
+}
+
+// File and console sinks keep 'level' even when a log forwarder lowers the
+// logger's level for the client
 inline std::shared_ptr<spdlog::logger> setup_logger(
     const std::string& name = "mcp_server",
     spdlog::level::level_enum level = spdlog::level::info,
@@ -23,11 +58,15 @@ inline std::shared_ptr<spdlog::logger> setup_logger(
   if (also_console) {
     sinks.push_back(std::make_shared<spdlog::sinks::stderr_color_sink_mt>());
   }
+  for (auto& sink : sinks) sink->set_level(level);
+  sinks.push_back(std::make_shared<spdlog::sinks::dist_sink_mt>());
   auto logger =
       std::make_shared<spdlog::logger>(name, sinks.begin(), sinks.end());
   logger->set_level(level);
   logger->set_pattern("[%Y-%m-%d %H:%M:%S] [%^%l%$] %v");
   spdlog::set_default_logger(logger);
+  spdlog::drop(kPayloadLoggerName);
+  spdlog::register_logger(logger->clone(kPayloadLoggerName));
   return logger;
 }
 
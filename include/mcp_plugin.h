@@ -0,0 +1,51 @@
+#pragma once
+
+// C ABI for tool plugins loaded from shared libraries (.so).
+//
+// A plugin exports two functions:
+//
+//   int mcp_plugin_call(const char* tool, const char* arguments_json,
+//                       char** result_json);
+//   void mcp_plugin_free(char* result_json);
+//
+// mcp_plugin_call runs the named tool. It returns 0 on success with the tool
+// result (any JSON value) in *result_json, or non-zero with an error message
+// (plain text) in *result_json. The server releases the buffer through
+// mcp_plugin_free, so the plugin decides how it is allocated.
+//
+// Tool metadata comes from a manifest so the server can advertise the tools
+// without loading the library, which is then opened lazily on the first call.
+// The manifest is a file next to the library with the same stem and a .json
+// extension (libfoo.so -> libfoo.json):
+//
+//   {"tools": [{"name": "...", "description": "...", "inputSchema": {...},
+//               "isolated": false, "maxConcurrency": 0, "maxQueued": 0}]}
+//
+// "isolated" (optional) runs the tool in the server's worker pool, if enabled.
+// "maxConcurrency"/"maxQueued" (optional) set the tool's admission limits.
+//
+// If there is no manifest file, the library is loaded at startup and must
+// export the manifest itself:
+//
+//   const char* mcp_plugin_manifest(void);
+//
+// When the library file changes on disk the plugin is reloaded in place on the
+// next call; calls already running keep using the previous version until they
+// return.
+
+#define MCP_PLUGIN_CALL_SYMBOL "mcp_plugin_call"
+#define MCP_PLUGIN_FREE_SYMBOL "mcp_plugin_free"
+#define MCP_PLUGIN_MANIFEST_SYMBOL "mcp_plugin_manifest"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef int (*McpPluginCallFn)(const char* tool, const char* arguments_json,
+                               char** result_json);
+typedef void (*McpPluginFreeFn)(char* result_json);
+typedef const char* (*McpPluginManifestFn)(void);
+
+#ifdef __cplusplus
+}
+#endif
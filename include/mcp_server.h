@@ -1,16 +1,35 @@
 #pragma once
 
+#include <condition_variable>
 #include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <nlohmann/json.hpp>
+#include <set>
 #include <string>
+#include <string_view>
 #include <vector>
 
+#include "admission_controller.h"
+#include "log_forwarder.h"
+#include "mcp_tool.h"
+#include "memory_accounting.h"
+#include "prompt_registry.h"
+#include "resource_manager.h"
+#include "spill_store.h"
+#include "tool_registry.h"
+#include "worker_pool.h"
+
 using json = nlohmann::json;
 
 // Forward declarations
+class IoExecutor;
+class ITransportAdapter;
 class JsonRpc;
+class PluginManager;
+class RequestScheduler;
+class ResourceWatcher;
 
 struct McpCapabilities {
   bool tools = false;
@@ -25,12 +44,6 @@ struct McpServerInfo {
   McpCapabilities capabilities;
 };
 
-struct McpTool {
-  std::string name;
-  std::string description;
-  json inputSchema;  // Changed from map to json for better schema support
-};
-
 class McpServer {
  public:
   McpServer(const std::string &name, const std::string &version);
@@ -45,18 +58,135 @@ class McpServer {
   void handleInitialize(const std::string &request, std::string &response);
   void handleListTools(const std::string &request, std::string &response);
   void handleCallTool(const std::string &request, std::string &response);
+  // Same, for a request already parsed into its id and params
+  void handleCallTool(const std::string &id, json params,
+                      std::string &response);
   void handlePing(const std::string &request, std::string &response);
+  void handleListResources(const std::string &request, std::string &response);
+  void handleReadResource(const std::string &request, std::string &response);
+  void handleSubscribeResource(const std::string &request,
+                               std::string &response);
+  void handleUnsubscribeResource(const std::string &request,
+                                 std::string &response);
+  void handleListPrompts(const std::string &request, std::string &response);
+  void handleGetPrompt(const std::string &request, std::string &response);
+  void handleSetLogLevel(const std::string &request, std::string &response);
 
-  // Request processing
+  // Request processing. Thread-safe; 'response' is left empty for
+  // notifications and cancelled requests.
   void processRequest(const std::string &request, std::string &response);
 
-  // Tool management
+  // Like processRequest, but calls to async tools return as soon as the
+  // coroutine suspends and 'done' receives the response when it finishes
+  // (on an executor thread). Everything else completes before returning.
+  using ResponseCallback = std::function<void(const std::string &)>;
+  void processRequestAsync(const std::string &request, ResponseCallback done);
+  // Block until every async call started by processRequestAsync has finished
+  void waitForAsyncCalls();
+
+  // Answer requests from 'transport' until it is closed. Requests run on
+  // 'threads' scheduler workers, with control messages on their own lane;
+  // responses and notifications are written back as they complete.
+  void serve(ITransportAdapter &transport, size_t threads);
+
+  // Methods that should bypass queued tool work (see RequestScheduler)
+  static bool isControlMethod(const std::string &method);
+
+  // Server-to-client notifications (resource updates, log messages) are
+  // handed to this sink, which must be safe to call from any thread
+  void setNotificationSink(std::function<void(const std::string &)> sink);
+  void sendNotification(const std::string &method, const json &params);
+
+  // Forward server log records to the client as 'notifications/message'
+  // (level chosen with 'logging/setLevel'); enables the logging capability.
+  // Attaches to the default spdlog logger, which must have been set up with
+  // McpLogging::setup_logger(); otherwise forwarding stays off. The forwarder
+  // is detached again when the server is destroyed.
+  void enableLogForwarding(const LogForwarderOptions &options = {});
+
+  // Tool management. Safe to call while requests are being served.
   void addTool(const McpTool &tool, std::function<json(const json &)> handler);
-  const std::map<std::string, McpTool> &getTools() const { return tools_; }
-  const std::map<std::string, std::function<json(const json &)>> &
-  getToolHandlers() const {
-    return toolHandlers_;
+  void addAsyncTool(const McpTool &tool, AsyncToolHandler handler);
+  bool removeTool(const std::string &name);
+  ToolRegistry &getToolRegistry() { return toolRegistry_; }
+  // Current registry version; hold on to it for the duration of a call
+  std::shared_ptr<const ToolSnapshot> getToolSnapshot() const {
+    return toolRegistry_.snapshot();
   }
+  // Copies taken from the current snapshot (kept for existing callers)
+  std::map<std::string, McpTool> getTools() const;
+  std::map<std::string, std::function<json(const json &)>> getToolHandlers()
+      const;
+
+  // Executor that resumes async tool coroutines, started on first use with
+  // setIoThreads() threads (default 2)
+  IoExecutor &getIoExecutor();
+  void setIoThreads(size_t threads) { ioThreads_ = threads; }
+
+  // Run 'task' on serve()'s work lane, on the workers that serve requests.
+  // Returns false, without running it, when serve() is not running.
+  bool submitWork(std::function<void()> task);
+
+  // Mark a registered tool to run in (or out of) the worker pool. Async
+  // tools cannot be isolated.
+  bool setToolIsolated(const std::string &name, bool isolated);
+  // Fork the out-of-process worker pool used by tools marked 'isolated'.
+  // Call after registering tools; workers inherit the registry at fork time.
+  void enableWorkerPool(const WorkerPoolOptions &options);
+  WorkerPool *getWorkerPool() const { return workerPool_.get(); }
+
+  // Run a tool from a registry snapshot, in the worker pool if it is isolated.
+  // Subject to admission control: throws ServerBusyError when overloaded.
+  // 'nested' marks calls made by another tool call (e.g. pipeline steps),
+  // which skip the global in-flight limit already held by their parent.
+  json invokeTool(const ToolEntry &entry, const json &arguments,
+                  bool nested = false) const;
+  // Admission limits configured on 'tool'
+  static AdmissionLimits limitsFor(const McpTool &tool);
+
+  // Global in-flight limit for tool calls (0 = unlimited) and how many calls
+  // may wait for it; per-tool limits live on McpTool
+  void setConcurrencyLimits(size_t maxInFlight, size_t maxQueued);
+  AdmissionController &getAdmissionController() const { return *admission_; }
+
+  // Heap bytes one request may allocate while it is handled (0 = unlimited).
+  // Requests over budget are answered with a kMemoryBudgetError error; tools
+  // can have a tighter budget of their own (McpTool::memoryBudget).
+  void setMemoryBudget(size_t requestBytes) { memoryBudget_ = requestBytes; }
+  size_t getMemoryBudget() const { return memoryBudget_; }
+  bool setToolMemoryBudget(const std::string &name, size_t bytes);
+
+  // Serve the files under 'dir' as resources; enables the resources
+  // capability. Returns false if 'dir' is not a directory.
+  bool addResourceRoot(const std::string &dir);
+  ResourceManager &getResourceManager() const { return *resources_; }
+
+  // Store tool results larger than 'thresholdBytes' under 'dir' (bounded by
+  // 'maxBytes') and return a note naming their URI instead of inlining them.
+  // An empty 'dir' uses a private directory for this instance only. The
+  // directory is served as a resource root so clients can read the result in
+  // chunks.
+  // Returns false if the directory cannot be used or is not private.
+  bool enableResultSpill(const std::string &dir, size_t thresholdBytes,
+                         uint64_t maxBytes);
+  SpillStore *getSpillStore() const { return spill_.get(); }
+
+  // 'tools/call' result for a tool's return value: inline text, or a text
+  // note naming the spilled copy's URI when the value exceeds the spill
+  // threshold. A typed result (ToolContent::result) keeps its items, except
+  // that text items and embedded resources (text or binary blob) over the
+  // threshold are spilled too; binary data left inline is base64 encoded.
+  json buildCallResult(json result) const;
+
+  // Register a prompt whose text may reference its arguments as {{name}};
+  // enables the prompts capability. Throws std::invalid_argument if the
+  // template references unknown arguments.
+  void addPrompt(const McpPrompt &prompt, const std::string &templateText);
+  PromptRegistry &getPromptRegistry() const { return *prompts_; }
+
+  // Register tools from the shared-library plugins in 'dir' (see
+  // mcp_plugin.h). Returns the number of plugins registered.
+  size_t loadPlugins(const std::string &dir);
 
   // Server info accessors
   McpServerInfo getServerInfo() const { return serverInfo_; }
@@ -69,11 +199,103 @@ class McpServer {
  private:
   McpServerInfo serverInfo_;
   std::unique_ptr<JsonRpc> jsonRpc_;
-  std::map<std::string, McpTool> tools_;
-  std::map<std::string, std::function<json(const json &)>> toolHandlers_;
+  ToolRegistry toolRegistry_;
+  std::unique_ptr<PluginManager> pluginManager_;
+  std::unique_ptr<WorkerPool> workerPool_;
+  std::unique_ptr<AdmissionController> admission_;
+  std::unique_ptr<ResourceManager> resources_;
+  std::unique_ptr<PromptRegistry> prompts_;
+  std::unique_ptr<SpillStore> spill_;
+  size_t spillThreshold_ = 0;
+  size_t memoryBudget_ = 0;
+  // Peak bytes allocated per request method and per tool call
+  std::unique_ptr<MemoryUsageStats> methodMemory_;
+  std::unique_ptr<MemoryUsageStats> toolMemory_;
 
   bool running_;
 
+  // Ids from notifications/cancelled for requests not yet started
+  std::mutex cancelledMutex_;
+  std::set<std::string> cancelledRequests_;
+
+  std::mutex notificationMutex_;
+  std::function<void(const std::string &)> notificationSink_;
+
+  // Subscribed resources: canonical path -> uri as the client sent it
+  std::mutex subscriptionsMutex_;
+  std::map<std::string, std::string> subscriptions_;
+  std::unique_ptr<ResourceWatcher> resourceWatcher_;
+
+  std::shared_ptr<LogForwarder> logForwarder_;
+
+  size_t ioThreads_ = 2;
+  std::once_flag ioExecutorOnce_;
+  std::unique_ptr<IoExecutor> ioExecutor_;
+  // Async tool calls started by processRequestAsync and not yet answered,
+  // and synchronous calls parked by admission control
+  std::mutex asyncMutex_;
+  std::condition_variable asyncIdle_;
+  size_t asyncInFlight_ = 0;
+  size_t queuedCalls_ = 0;
+  // serve()'s scheduler, which parked calls are resubmitted to once admitted
+  std::mutex schedulerMutex_;
+  RequestScheduler *scheduler_ = nullptr;
+
+  // Parse 'request' (the only full parse it gets) and answer it. With
+  // 'done', a call to an async tool returns true as soon as it is started
+  // and 'done' receives the response later; otherwise 'response' is set.
+  bool dispatchRequest(const std::string &request, std::string &response,
+                       ResponseCallback *done);
+  // processRequestAsync for a request whose method was already peeked
+  void answerRequest(const std::string &request, const std::string &method,
+                     ResponseCallback done);
+  // Run 'handle' with its allocations counted against the request budget;
+  // over budget, 'response' becomes a kMemoryBudgetError error
+  void runAccounted(const std::string &request, const std::string &method,
+                    std::string &response,
+                    const std::function<void()> &handle);
+  // Answer 'request' with an internal error after 'handle' threw
+  void failRequest(const std::string &request, const std::string &method,
+                   const std::string &what, std::string &response);
+  // tools/call with parsed params ('arguments' is moved out of them); see
+  // dispatchRequest for 'done'
+  bool callTool(const std::string &id, json &params, std::string &response,
+                ResponseCallback *done);
+  // A synchronous tools/call under serve(): runs now if admitted, otherwise
+  // parks it without holding this thread and returns true; the call is
+  // resubmitted to the scheduler once admitted and answered through 'done'
+  bool startQueuedCall(std::shared_ptr<const ToolEntry> entry,
+                       json &arguments, const std::string &id,
+                       ResponseCallback &done, std::string &response);
+  bool canResubmit();
+  // Run 'task' on serve()'s scheduler (or right here once it is stopping)
+  void resubmit(std::function<void()> task);
+  // The tool's handler (or worker pool) inside its own memory scope, for a
+  // call that has been admitted
+  json runTool(const ToolEntry &entry, const json &arguments) const;
+  // Response to a tools/call of 'name' whose result 'call' returns, or the
+  // JSON-RPC error for the exception it throws
+  std::string toolCallResponse(const std::string &id, const std::string &name,
+                               const std::function<json()> &call) const;
+  // Append a typed result's item to 'content', spilled if it is too large
+  void spillItem(json item, json &content) const;
+  // Store 'data' in the spill store and append a text note giving its URI,
+  // starting with 'label'
+  void appendSpilled(const std::string &label, std::string_view data,
+                     const std::string &extension, json &content) const;
+  void handleNotification(const std::string &method, const json &params);
+  void startAsyncCall(std::shared_ptr<const ToolEntry> entry,
+                      json arguments, const std::string &id,
+                      ResponseCallback done);
+  // Coroutine run by startAsyncCall: waits for admission, then the handler
+  ToolTask admitAndRun(std::shared_ptr<const ToolEntry> entry,
+                       json arguments);
+  void onResourcesChanged(const std::vector<std::string> &paths);
+  // Subscribed files whose directory was deleted: notify and unsubscribe
+  void onResourcesLost(const std::vector<std::string> &paths);
+  bool takeCancelled(const std::string &id);
+
   void setupDefaultTools();
-  void processRequest(const std::string &request);
+  void putDefaultTools(ToolSnapshot &next);
+  void setupDefaultPrompts();
 };
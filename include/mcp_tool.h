@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <nlohmann/json.hpp>
+#include <string>
+
+#include "tool_task.h"
+
+using json = nlohmann::json;
+
+struct McpTool {
+  std::string name;
+  std::string description;
+  json inputSchema;  // Changed from map to json for better schema support
+  bool isolated = false;  // Run in the out-of-process worker pool if enabled
+  size_t maxConcurrency = 0;  // Concurrent calls allowed, 0 = unlimited
+  size_t maxQueued = 0;       // Calls allowed to wait for a slot
+  size_t memoryBudget = 0;    // Bytes one call may allocate, 0 = no own limit
+};
+
+// Synchronous tool handler: receives the call arguments, returns the result
+using ToolHandler = std::function<json(const json &)>;
+
+// Asynchronous tool handler: a coroutine that may suspend on I/O (see
+// IoExecutor) without holding a thread. Arguments are passed by value so
+// they live in the coroutine frame.
+using AsyncToolHandler = std::function<ToolTask(json)>;
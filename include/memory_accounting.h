@@ -0,0 +1,171 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <new>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <utility>
+
+using json = nlohmann::json;
+
+// JSON-RPC error code returned when a request exceeds its memory budget
+constexpr int kMemoryBudgetError = -32003;
+
+// Shared heap counter of one scope; see MemoryScope
+struct MemoryAccount;
+
+// Accounts the heap memory allocated while it is the current scope. Scopes
+// nest: allocations count against every enclosing scope, and each one has
+// its own limit (0 = unlimited). Every allocation remembers the scope it was
+// charged to, so freeing it credits that scope whichever thread frees it.
+//
+// Allocations never fail or throw because of a budget, since operator new is
+// called from noexcept code and destructors. A scope that goes past its limit
+// is marked exceeded() by the allocation itself, and the next checkpoint()
+// on work running in it throws MemoryBudgetExceeded. Only the nothrow forms
+// of operator new refuse (return nullptr) an allocation that would exceed a
+// limit.
+//
+// Enforcement is therefore only as prompt as the checkpoints: the server
+// checks before each tool call, whenever an async tool resumes from a
+// co_await and when a tool or request finishes. A synchronous handler that
+// allocates in one long stretch is only stopped once it returns, unless it
+// calls checkpoint() itself as it goes.
+//
+// The scope belongs to the thread that created it. Work that continues on
+// other threads carries it along with current() and Attach; ToolTask does
+// this for coroutines itself.
+//
+// Counting needs the replacement operator new/delete in memory_hooks.cpp,
+// which only the mcp_server executable links. Without them (embedders of
+// the mcp library) scopes count nothing and never fail.
+class MemoryScope {
+ public:
+  // 'label' names the scope in MemoryBudgetExceeded::message(), e.g.
+  // "tool echo"
+  explicit MemoryScope(size_t limitBytes = 0, const char *label = "");
+  ~MemoryScope();
+
+  MemoryScope(const MemoryScope &) = delete;
+  MemoryScope &operator=(const MemoryScope &) = delete;
+
+  // Reference to a scope's account that keeps it alive, for carrying it to
+  // another thread or reading it after the scope has ended
+  class Handle {
+   public:
+    Handle() = default;
+    // Takes a new reference
+    explicit Handle(MemoryAccount *account) noexcept;
+    Handle(const Handle &other) noexcept : Handle(other.account_) {}
+    Handle(Handle &&other) noexcept
+        : account_(std::exchange(other.account_, nullptr)) {}
+    Handle &operator=(Handle other) noexcept {
+      std::swap(account_, other.account_);
+      return *this;
+    }
+    ~Handle();
+
+    MemoryAccount *get() const { return account_; }
+    int64_t currentBytes() const;
+    size_t peakBytes() const;
+    // This scope went past its own limit
+    bool exceeded() const;
+    // This scope or one enclosing it went past its limit
+    bool overBudget() const;
+    // The innermost of this scope and those enclosing it that went past its
+    // limit (empty if none)
+    Handle tripped() const;
+    size_t limitBytes() const;
+    const char *label() const;
+
+   private:
+    MemoryAccount *account_ = nullptr;
+  };
+
+  // Make 'handle' the current scope of this thread while alive
+  class Attach {
+   public:
+    explicit Attach(const Handle &handle);
+    ~Attach();
+
+    Attach(const Attach &) = delete;
+    Attach &operator=(const Attach &) = delete;
+
+   private:
+    Handle handle_;
+    MemoryAccount *previous_;
+  };
+
+  // Net bytes allocated so far (negative if more was freed than allocated)
+  int64_t currentBytes() const { return handle_.currentBytes(); }
+  size_t peakBytes() const { return handle_.peakBytes(); }
+  size_t limitBytes() const { return limit_; }
+  bool exceeded() const { return handle_.exceeded(); }
+  const Handle &handle() const { return handle_; }
+
+  // The current scope of this thread (empty outside any scope)
+  static Handle current();
+  // Throws MemoryBudgetExceeded, naming the scope, if the current scope or
+  // one enclosing it has gone past its limit. Long-running tools should call
+  // it as they go.
+  static void checkpoint();
+  static bool supported();
+
+  // Hooks for the replacement operator new/delete. chargeAllocation()
+  // returns the account to record with the allocation (nullptr outside any
+  // scope); with 'mayRefuse' it sets 'refused' instead of going over a limit.
+  static MemoryAccount *chargeAllocation(size_t bytes, bool mayRefuse,
+                                         bool &refused) noexcept;
+  static void releaseAllocation(MemoryAccount *account, size_t bytes) noexcept;
+  static void enableHooks() noexcept;
+
+ private:
+  size_t limit_;
+  Handle handle_;
+  MemoryAccount *previous_;
+};
+
+// Thrown by MemoryScope::checkpoint() once a scope has gone past its limit;
+// scope() is the one that did. Derives from std::bad_alloc so code that
+// already copes with allocation failure handles it too.
+class MemoryBudgetExceeded : public std::bad_alloc {
+ public:
+  explicit MemoryBudgetExceeded(MemoryScope::Handle scope) noexcept
+      : scope_(std::move(scope)) {}
+
+  const char *what() const noexcept override {
+    return "Memory budget exceeded";
+  }
+  const MemoryScope::Handle &scope() const { return scope_; }
+  size_t limitBytes() const { return scope_.limitBytes(); }
+  // "Memory budget of N bytes exceeded by <label>"
+  std::string message() const;
+
+ private:
+  MemoryScope::Handle scope_;
+};
+
+// Per-key (method or tool name) peak memory of finished requests, for
+// server_stats
+class MemoryUsageStats {
+ public:
+  // Distinct keys kept; further unknown keys are folded into "(other)"
+  static constexpr size_t kMaxKeys = 256;
+
+  void record(const std::string &key, size_t peakBytes, bool rejected);
+  // {key: {requests, rejected, peakBytes, avgPeakBytes}}
+  json toJson() const;
+
+ private:
+  struct Entry {
+    uint64_t requests = 0;
+    uint64_t rejected = 0;
+    size_t peakBytes = 0;
+    double totalPeakBytes = 0;
+  };
+
+  mutable std::mutex mutex_;
+  std::map<std::string, Entry> entries_;
+};
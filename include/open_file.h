@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Read-only open file (RAII) served with positional reads. Unlike a memory
+// mapping, a file truncated by someone else (log rotation, say) just yields
+// short reads instead of a SIGBUS that would kill the server. Safe to share
+// between threads.
+class OpenFile {
+ public:
+  // Throws std::runtime_error if the file cannot be opened
+  static std::shared_ptr<OpenFile> open(const std::string &path);
+  ~OpenFile();
+
+  OpenFile(const OpenFile &) = delete;
+  OpenFile &operator=(const OpenFile &) = delete;
+
+  // Size when the file was opened
+  size_t size() const { return size_; }
+  const std::string &path() const { return path_; }
+  // Modification time (ns since epoch) when the file was opened
+  int64_t mtimeNs() const { return mtimeNs_; }
+  // True if the file on disk no longer matches the opened size/mtime
+  bool isStale() const;
+
+  // Read up to 'length' bytes at 'offset' into 'out'. Returns the number of
+  // bytes read, fewer than asked only at the end of the file. Throws
+  // std::runtime_error on I/O errors.
+  size_t readAt(uint64_t offset, char *out, size_t length) const;
+
+ private:
+  OpenFile() = default;
+
+  std::string path_;
+  int fd_ = -1;
+  size_t size_ = 0;
+  int64_t mtimeNs_ = 0;
+};
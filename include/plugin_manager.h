@@ -0,0 +1,42 @@
+#pragma once
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class McpServer;
+
+// Discovers tool plugins in a directory and registers their tools with the
+// server. See mcp_plugin.h for the plugin ABI and manifest format.
+//
+// Libraries are opened lazily on the first call to one of their tools. A
+// background thread checks every kReloadCheckIntervalMs whether a plugin's
+// library or manifest changed on disk, and if so loads the new version and
+// swaps it in; tool calls never stat, copy or dlopen beyond that first open.
+// Each call holds a reference to the library version it started on, so a
+// reload never unmaps code that is still running.
+class PluginManager {
+ public:
+  static constexpr int kReloadCheckIntervalMs = 500;
+
+  explicit PluginManager(McpServer& server);
+  ~PluginManager();
+
+  // Register tools from every plugin in 'dir'. Returns the number of plugins
+  // that were registered successfully.
+  size_t loadDirectory(const std::string& dir);
+
+  class Plugin;
+
+ private:
+  void reloadLoop();
+
+  McpServer& server_;
+  std::mutex mutex_;  // guards plugins_ and stopping_
+  std::condition_variable cv_;
+  bool stopping_ = false;
+  std::vector<std::shared_ptr<Plugin>> plugins_;
+  std::thread reloader_;  // started with the first registered plugin
+};
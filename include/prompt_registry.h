@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using json = nlohmann::json;
+
+struct McpPromptArgument {
+  std::string name;
+  std::string description;
+  bool required = false;
+  std::string defaultValue;  // Used when an optional argument is omitted
+};
+
+struct McpPrompt {
+  std::string name;
+  std::string description;
+  std::vector<McpPromptArgument> arguments;
+};
+
+// Prompt template with {{argument}} placeholders, parsed once into literal
+// segments and argument slots. Rendering sizes the output up front and fills
+// it in a single pass.
+class PromptTemplate {
+ public:
+  // Throws std::invalid_argument for unterminated or unknown placeholders
+  static PromptTemplate compile(const std::string &text,
+                                const std::vector<McpPromptArgument> &args);
+
+  // 'values' is indexed like the argument list passed to compile(); literals
+  // are copied verbatim around them.
+  std::string render(const std::vector<std::string_view> &values) const;
+
+ private:
+  struct Segment {
+    size_t offset;  // into text_ for literals
+    size_t length;
+    int slot;  // argument index, or -1 for a literal
+  };
+
+  std::string text_;
+  std::vector<Segment> segments_;
+  size_t literalSize_ = 0;
+};
+
+// Prompts served through 'prompts/list' and 'prompts/get'. Rendering is a
+// single copy of the template and argument text, so results are not cached:
+// even building a cache key would cost as much as rendering again.
+class PromptRegistry {
+ public:
+  // Register or replace a prompt. Throws std::invalid_argument if the
+  // template does not compile.
+  void addPrompt(const McpPrompt &prompt, const std::string &templateText);
+  bool empty() const;
+
+  // Result for 'prompts/list'
+  json list() const;
+  // Result for 'prompts/get'. Throws std::invalid_argument for unknown
+  // prompts or missing required arguments.
+  json get(const std::string &name, const json &arguments);
+
+ private:
+  struct Entry {
+    McpPrompt prompt;
+    PromptTemplate compiled;
+  };
+
+  static std::string render(const Entry &entry, const json &arguments);
+
+  mutable std::mutex mutex_;
+  std::map<std::string, std::shared_ptr<const Entry>> prompts_;
+};
@@ -0,0 +1,68 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Scheduler for incoming requests with two priority lanes.
+//
+// - Control lane: protocol housekeeping (ping, initialize, tools/list,
+//   notifications). Served by a dedicated control thread that never runs
+//   tool work, and taken ahead of tool work by every other worker, so health
+//   checks are answered promptly even when all workers are busy.
+// - Work lane: tool calls and everything else. Each worker has its own deque;
+//   submissions are spread round-robin, and idle workers steal from the back
+//   of other workers' deques so one long call does not strand work queued
+//   behind it.
+class RequestScheduler {
+ public:
+  enum class Lane { Control, Work };
+  using Task = std::function<void()>;
+
+  // 'workers' general worker threads (at least one) plus the control thread
+  explicit RequestScheduler(size_t workers);
+  ~RequestScheduler();
+
+  RequestScheduler(const RequestScheduler &) = delete;
+  RequestScheduler &operator=(const RequestScheduler &) = delete;
+
+  void submit(Lane lane, Task task);
+
+  // Run everything already submitted, then stop the threads
+  void shutdown();
+
+  size_t workerCount() const { return queues_.size(); }
+  uint64_t stolenCount() const { return stolen_.load(); }
+
+ private:
+  struct WorkQueue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+
+  void workerLoop(size_t index);
+  void controlLoop();
+  bool popControl(Task &task);
+  bool popWork(size_t index, Task &task);
+
+  std::vector<std::unique_ptr<WorkQueue>> queues_;
+  std::mutex controlMutex_;
+  std::deque<Task> control_;
+
+  std::mutex sleepMutex_;
+  std::condition_variable workCv_;
+  std::condition_variable controlCv_;
+  size_t pendingControl_ = 0;
+  size_t pendingWork_ = 0;
+  bool stopping_ = false;
+
+  std::atomic<size_t> nextQueue_{0};
+  std::atomic<uint64_t> stolen_{0};
+  std::vector<std::thread> threads_;
+};
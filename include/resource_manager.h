@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "open_file.h"
+
+using json = nlohmann::json;
+
+// Serves files under configured directories as MCP resources
+// ('resources/list' and 'resources/read').
+//
+// Resources are identified by file:// URIs. Reads are served in chunks with
+// positional reads: 'resources/read' accepts optional "offset" and "length"
+// parameters (bytes) and returns at most kMaxChunkSize bytes, plus
+// "totalSize" and, when more data remains, "nextOffset". Text files are
+// returned as "text", everything else as base64 "blob". Recently read files
+// stay open in a small LRU cache. Files are not memory-mapped: they belong to
+// other processes, and touching a mapped page past a concurrent truncation
+// raises SIGBUS.
+class ResourceManager {
+ public:
+  static constexpr size_t kDefaultChunkSize = 1 << 20;
+  static constexpr size_t kMaxChunkSize = 16 << 20;
+  static constexpr size_t kPageSize = 500;  // resources per list page
+  static constexpr size_t kCacheEntries = 32;
+
+  // Expose every file under 'dir'. Returns false if it is not a directory.
+  bool addRoot(const std::string &dir);
+  bool empty() const;
+
+  // Result for 'resources/list', in path order; 'cursor' comes from a
+  // previous nextCursor (the URI of that page's last file). Each page reads
+  // only the directories it lists from. Throws std::runtime_error for a
+  // cursor outside the configured roots.
+  json list(const std::string &cursor) const;
+  // Result for 'resources/read'. Throws std::runtime_error for unknown URIs
+  // or paths outside the configured roots.
+  json read(const std::string &uri, uint64_t offset, size_t length);
+
+  // Map a file:// URI to a canonical path inside a root ("" if it is not)
+  std::string resolve(const std::string &uri) const;
+  static std::string uriForPath(const std::string &path);
+  static std::string mimeType(const std::string &path);
+  // Extension mimeType() maps back to 'mimeType' (".bin" if none does)
+  static std::string extensionFor(const std::string &mimeType);
+
+  // Drop a cached open file (e.g. after the file changed)
+  void invalidate(const std::string &path);
+
+ private:
+  std::shared_ptr<OpenFile> acquire(const std::string &path);
+
+  mutable std::mutex mutex_;
+  std::vector<std::string> roots_;  // canonical paths
+
+  // LRU of open files, most recently used first
+  std::list<std::shared_ptr<OpenFile>> lru_;
+  std::unordered_map<std::string,
+                     std::list<std::shared_ptr<OpenFile>>::iterator>
+      cache_;
+};
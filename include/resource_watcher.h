@@ -0,0 +1,64 @@
+#pragma once
+#include <chrono>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Watches subscribed files with inotify and reports changes in debounced
+// batches from a background thread.
+//
+// The parent directory of each file is watched rather than the file itself,
+// so editors that save by writing a new file and renaming it over the old one
+// are still detected. A burst of events is reported once the file has been
+// quiet for kDebounceMs, or after kMaxDelayMs at the latest while it keeps
+// changing.
+//
+// If a watched directory is deleted (or its filesystem unmounted) the watch
+// is gone; the files subscribed in it are reported once through 'onLost'
+// and forgotten. Watch them again if they reappear.
+//
+// Linux only; elsewhere watch() returns false.
+class ResourceWatcher {
+ public:
+  static constexpr int kDebounceMs = 50;
+  static constexpr int kMaxDelayMs = 500;
+
+  // Receives the canonical paths that changed since the last batch
+  using Callback = std::function<void(const std::vector<std::string> &)>;
+
+  explicit ResourceWatcher(Callback onChanged, Callback onLost = nullptr);
+  ~ResourceWatcher();
+
+  ResourceWatcher(const ResourceWatcher &) = delete;
+  ResourceWatcher &operator=(const ResourceWatcher &) = delete;
+
+  // Start/stop reporting changes to 'path' (a canonical file path)
+  bool watch(const std::string &path);
+  void unwatch(const std::string &path);
+
+ private:
+  void run();
+  void readEvents(std::chrono::steady_clock::time_point now);
+
+  Callback onChanged_;
+  Callback onLost_;
+  int inotifyFd_ = -1;
+  int wakeFd_ = -1;
+  bool stopping_ = false;
+
+  std::mutex mutex_;
+  std::map<int, std::string> dirsByWatch_;  // inotify wd -> directory
+  std::map<std::string, int> watchByDir_;
+  std::map<std::string, std::set<std::string>> filesByDir_;  // names
+
+  std::set<std::string> pending_;
+  std::vector<std::string> lost_;  // paths whose directory watch is gone
+  std::chrono::steady_clock::time_point firstEvent_;
+  std::chrono::steady_clock::time_point lastEvent_;
+
+  std::thread thread_;
+};
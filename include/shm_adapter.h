@@ -0,0 +1,98 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "shm_ring.h"
+#include "transport_adapter.h"
+
+// Start of a shared-memory transport segment. The client->server ring and
+// the server->client ring follow, each ShmRing::regionSize(ringCapacity).
+struct ShmTransportHeader {
+  static constexpr uint32_t kMagic = 0x4d435053;  // "MCPS"
+  static constexpr uint32_t kVersion = 1;
+
+  uint32_t magic;
+  uint32_t version;
+  uint64_t ringCapacity;
+  std::atomic<int32_t> serverPid;
+  std::atomic<int32_t> clientPid;  // 0 until a client attaches
+};
+
+// A mapped transport segment (POSIX shared memory, shm_open). The server
+// creates it under a well-known name; a co-located client opens it by name.
+// Linux only.
+class ShmTransportSegment {
+ public:
+  // Create and initialize. An existing segment of that name is only replaced
+  // if the server that created it has exited; otherwise this throws
+  // std::runtime_error. The creator unlinks the name again when the segment
+  // is destroyed, unless it has been reclaimed by another server meanwhile.
+  static std::unique_ptr<ShmTransportSegment> create(const std::string &name,
+                                                     size_t ringCapacity);
+  // Map a segment created by a server. Throws std::runtime_error if it does
+  // not exist or has an unknown layout.
+  static std::unique_ptr<ShmTransportSegment> open(const std::string &name);
+  ~ShmTransportSegment();
+
+  ShmTransportSegment(const ShmTransportSegment &) = delete;
+  ShmTransportSegment &operator=(const ShmTransportSegment &) = delete;
+
+  ShmTransportHeader &header() { return *header_; }
+  ShmRing &requests() { return requests_; }    // client -> server
+  ShmRing &responses() { return responses_; }  // server -> client
+  const std::string &name() const { return name_; }
+
+  // False once 'pid' has exited (0 counts as alive: nobody attached yet)
+  static bool peerAlive(int32_t pid);
+  // Name unique to this server process
+  static std::string defaultName();
+
+ private:
+  ShmTransportSegment() = default;
+
+  std::string name_;
+  bool owner_ = false;
+  uint64_t device_ = 0;  // identity of the created segment
+  uint64_t inode_ = 0;
+  void *base_ = nullptr;
+  size_t size_ = 0;
+  ShmTransportHeader *header_ = nullptr;
+  ShmRing requests_;
+  ShmRing responses_;
+};
+
+// Transport for clients on the same host: messages travel through a pair of
+// single-producer/single-consumer rings in shared memory, so large tool
+// arguments and results are copied once into the mapping and never pass
+// through the kernel. A side only enters the kernel (futex) to sleep when
+// its ring is empty or full. Messages larger than a ring stream through it.
+//
+// Serves one client (see ShmClient) per segment. readMessage() ends when the
+// client disconnects or its process exits.
+class ShmAdapter : public ITransportAdapter {
+ public:
+  static constexpr size_t kDefaultRingCapacity = 4 << 20;
+
+  // 'name' empty uses ShmTransportSegment::defaultName(). A client message
+  // longer than 'maxMessageSize' drops the client.
+  explicit ShmAdapter(const std::string &name,
+                      size_t ringCapacity = kDefaultRingCapacity,
+                      size_t maxMessageSize = ShmRing::kDefaultMaxMessage);
+  ~ShmAdapter() override;
+
+  bool readMessage(std::string &message) override;
+  bool writeMessage(const std::string &message) override;
+
+  const std::string &name() const { return segment_->name(); }
+
+ private:
+  bool clientAlive();
+
+  std::unique_ptr<ShmTransportSegment> segment_;
+  size_t maxMessageSize_;
+  std::mutex writeMutex_;  // the response ring has a single producer
+};
@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <string>
+
+#include "mcp_client.h"
+#include "shm_adapter.h"
+
+using json = nlohmann::json;
+
+// Client side of the shared-memory transport, for processes on the same
+// host as a server started with --transport shm:
+//
+//   ShmClient client("/mcp_server");
+//   json tools = client.call("tools/list");
+//
+// Only one client may be attached to a segment at a time; the server sees a
+// disconnect when the client is destroyed or its process exits.
+class ShmClient {
+ public:
+  // Throws std::runtime_error if no server is listening on 'name' or another
+  // client is already attached
+  explicit ShmClient(const std::string &name);
+  ~ShmClient();
+
+  ShmClient(const ShmClient &) = delete;
+  ShmClient &operator=(const ShmClient &) = delete;
+
+  // Raw JSON-RPC text, one message each. Return false once the server has
+  // gone away.
+  bool send(const std::string &message);
+  bool receive(std::string &message);
+
+  // Send a request and wait for its response, returning the result. Throws
+  // McpError for an error response and std::runtime_error if the server
+  // goes away. Messages received meanwhile that are not the response
+  // (notifications, replies to raw send() requests) are dropped, so use
+  // either call() or send()/receive(), from one thread at a time.
+  json call(const std::string &method, const json &params = json::object());
+
+ private:
+  bool serverAlive();
+
+  std::unique_ptr<ShmTransportSegment> segment_;
+  std::mutex sendMutex_;  // the request ring has a single producer
+  int64_t nextId_ = 0;
+};
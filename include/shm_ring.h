@@ -0,0 +1,78 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// Header at the start of a ring's shared-memory region. Counters are
+// free-running byte offsets; the data area follows the header.
+struct ShmRingHeader {
+  std::atomic<uint64_t> head;  // bytes written by the producer
+  std::atomic<uint64_t> tail;  // bytes consumed by the consumer
+  std::atomic<uint32_t> dataSeq;      // futex word: bumped after writes
+  std::atomic<uint32_t> spaceSeq;     // futex word: bumped after reads
+  std::atomic<uint32_t> dataWaiters;  // consumers sleeping on dataSeq
+  std::atomic<uint32_t> spaceWaiters; // producers sleeping on spaceSeq
+  std::atomic<uint32_t> closed;
+  uint32_t capacity;  // power of two
+};
+
+// Single-producer/single-consumer byte ring in shared memory, usable between
+// processes. Messages are length-prefixed and may be larger than the ring:
+// they stream through as the consumer drains it. Blocking waits use futexes
+// on the shared counters and only enter the kernel when the other side is
+// actually sleeping. Counters written by the other process are validated
+// before use, so a misbehaving peer can only end its connection.
+//
+// Linux only.
+class ShmRing {
+ public:
+  // Called periodically while blocked; return false to abandon the wait
+  using WaitPredicate = std::function<bool()>;
+  static constexpr int kWaitSliceMs = 50;
+  static constexpr size_t kDefaultMaxMessage = size_t{256} << 20;
+
+  ShmRing() = default;
+
+  // Bytes of shared memory needed for a ring of (at least) 'capacity' bytes
+  static size_t regionSize(size_t capacity);
+  // Initialize a ring in 'region' (which must be regionSize(capacity) bytes)
+  static ShmRing create(void *region, size_t capacity);
+  // Use a ring previously initialized by create()
+  static ShmRing attach(void *region);
+
+  // Write one message. Returns false if the ring was closed or the predicate
+  // gave up while waiting for space.
+  bool write(const char *data, size_t size,
+             const WaitPredicate &keepWaiting = {});
+  bool write(const std::string &message,
+             const WaitPredicate &keepWaiting = {}) {
+    return write(message.data(), message.size(), keepWaiting);
+  }
+  // Read one message into 'message'. Returns false if the ring was closed and
+  // drained, or the predicate gave up while waiting for data. The length
+  // prefix comes from the other process: a message longer than 'maxSize'
+  // closes the ring and returns false, and memory only grows as the bytes
+  // actually arrive.
+  bool read(std::string &message, const WaitPredicate &keepWaiting = {},
+            size_t maxSize = kDefaultMaxMessage);
+
+  // Wake both sides and make further waits fail
+  void close();
+  // Discard any buffered bytes and reopen (only when neither side is active)
+  void reset();
+
+  bool valid() const { return header_ != nullptr; }
+
+ private:
+  static uint32_t roundCapacity(size_t capacity);
+
+  bool writeBytes(const char *src, size_t size,
+                  const WaitPredicate &keepWaiting);
+  bool readBytes(char *dst, size_t size, const WaitPredicate &keepWaiting);
+
+  ShmRingHeader *header_ = nullptr;
+  char *data_ = nullptr;
+  uint64_t capacity_ = 0;  // copied at attach; the peer can scribble on ours
+};
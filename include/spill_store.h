@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Content-addressed file store for tool results too large to inline in a
+// response. Files are named after an FNV-1a hash and the size of their
+// contents, and an existing file is only reused after comparing its bytes, so
+// identical results share one file while colliding ones get their own. The
+// store is bounded: once it exceeds maxBytes the least recently stored files
+// are deleted (a single result larger than the bound is kept on its own).
+//
+// Tool results may be private, so the store is too. By default it uses a
+// fresh mode 0700 directory per instance under $XDG_RUNTIME_DIR (or the temp
+// directory), removed again on destruction. An explicit directory must be a
+// real directory (not a symlink) owned by this user; it is restricted to 0700
+// and results left there by earlier runs are adopted. Files are created
+// exclusively with mode 0600.
+class SpillStore {
+ public:
+  // 'dir' empty creates a private per-instance directory. Throws
+  // std::runtime_error if the directory cannot be created or is unsafe.
+  SpillStore(const std::string &dir, uint64_t maxBytes);
+  ~SpillStore();
+
+  SpillStore(const SpillStore &) = delete;
+  SpillStore &operator=(const SpillStore &) = delete;
+
+  // Write 'data' (unless an identical file exists) and return its canonical
+  // path. 'extension' (e.g. ".json") selects the MIME type it is served with.
+  // Throws std::runtime_error on I/O errors.
+  std::string store(std::string_view data, const std::string &extension);
+
+  const std::string &directory() const { return dir_; }
+  uint64_t totalBytes() const;
+  size_t fileCount() const;
+
+  static uint64_t fnv1a(const char *data, size_t size);
+
+ private:
+  void evictLocked(const std::string &keep);
+
+  std::string dir_;  // canonical
+  bool owned_ = false;  // per-instance directory, removed on destruction
+  uint64_t maxBytes_;
+  uint64_t sequence_ = 0;  // temp file names
+
+  mutable std::mutex mutex_;
+  uint64_t totalBytes_ = 0;
+  // Stored files, most recently used first: (path, size)
+  using FileList = std::list<std::pair<std::string, uint64_t>>;
+  FileList lru_;
+  std::unordered_map<std::string, FileList::iterator> files_;
+};
@@ -1,6 +1,7 @@
 #pragma once
 #include <fstream>
 #include <iostream>
+#include <mutex>
 #include <string>
 
 #include "transport_adapter.h"
@@ -33,5 +34,6 @@ class StdioAdapter : public ITransportAdapter {
 
  private:
   std::ofstream logFile_;
+  std::mutex logMutex_;  // reads and writes log from different threads
   void log(const std::string& direction, const std::string& msg);
 };
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+// Typed content items for tool results. Instead of a plain value (sent as a
+// single text item), a handler may return a complete result:
+//
+//   return ToolContent::result({ToolContent::text("Rendered chart"),
+//                               ToolContent::image(png, "image/png")});
+//
+// Binary payloads stay json::binary inside the server and are base64-encoded
+// once, when the response is built, so they cost about 4/3 of their size on
+// the wire.
+namespace ToolContent {
+
+json text(std::string text);
+json image(std::vector<uint8_t> data, const std::string &mimeType);
+// Sent as an embedded blob resource (see finishResult)
+json audio(std::vector<uint8_t> data, const std::string &mimeType);
+// Embedded resource carrying binary contents
+json blob(const std::string &uri, std::vector<uint8_t> data,
+          const std::string &mimeType);
+// Embedded resource carrying text contents
+json resource(const std::string &uri, std::string text,
+              const std::string &mimeType);
+
+// Key that marks a value as built by result(). A plain value that merely
+// looks like {"content": [...]} is still sent as text.
+inline constexpr const char *kResultMarker = "_toolContentResult";
+
+// {"content": items}, plus "isError" when set
+json result(json items, bool isError = false);
+
+// Whether a tool's return value was built by result()
+bool isResult(const json &value);
+
+// Make a result() value ready to send: drop the marker, and turn every item
+// that is not an object with a known MCP content type (text, image, audio,
+// resource, resource_link) into a text item holding its JSON. Protocol
+// 2024-11-05, the one this server speaks, has no audio or resource_link
+// content: audio becomes an embedded blob resource with the same bytes, and
+// a resource_link a text note naming its URI.
+void finishResult(json &result);
+
+// Replace every json::binary inside 'value' by its base64 string, in place
+void encodeBinary(json &value);
+
+}  // namespace ToolContent
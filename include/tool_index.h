@@ -0,0 +1,97 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct McpTool;
+
+// Inverted index over tool names, descriptions and inputSchema property names.
+//
+// Backs the built-in 'search_tools' tool so agents can discover relevant tools
+// in large catalogs without fetching the whole 'tools/list'. The index is
+// maintained incrementally: addTool() on an existing name replaces its entry.
+//
+// Terms are lowercased alphanumeric runs; snake_case and camelCase names are
+// split into words. Each term is weighted by the field it came from (name >
+// property > description) and scored with an idf factor at query time.
+//
+// Copies are independent values. fork() is the cheap way to derive a new
+// version: the fork shares storage with its source and clones only what it
+// changes. An index must not be modified concurrently with its own reads,
+// but distinct copies and forks may be used from different threads.
+class ToolIndex {
+ public:
+  struct Hit {
+    std::string name;
+    double score;
+  };
+
+  ToolIndex() = default;
+  // Copies clone every shard
+  ToolIndex(const ToolIndex& other);
+  ToolIndex& operator=(const ToolIndex& other);
+  ToolIndex(ToolIndex&&) = default;
+  ToolIndex& operator=(ToolIndex&&) = default;
+
+  // An index sharing every shard with this one; it clones a shard before
+  // changing it. This index must not change while forks of it exist (the
+  // registry only forks published snapshots, which never change).
+  ToolIndex fork() const;
+
+  // Index (or re-index) a tool
+  void addTool(const McpTool& tool);
+  // Drop a tool from the index. No-op if it is not indexed.
+  void removeTool(const std::string& name);
+
+  // Return up to 'limit' tools ranked by relevance to 'query'
+  std::vector<Hit> search(const std::string& query, size_t limit) const;
+
+  size_t size() const { return size_; }
+
+  // Split text into normalized index terms
+  static std::vector<std::string> tokenize(const std::string& text);
+
+ private:
+  // Forks share their shards, and a change clones only the shards it
+  // touches, so a registry version that adds one tool costs a few shards
+  // rather than a copy of the whole index
+  static constexpr size_t kShards = 64;
+  static constexpr size_t kNameChunk = 64;
+
+  struct Posting {
+    uint32_t doc;
+    float weight;
+  };
+  struct Doc {
+    uint32_t id;
+    std::vector<std::string> terms;
+  };
+  using PostingShard = std::unordered_map<std::string, std::vector<Posting>>;
+  using DocShard = std::unordered_map<std::string, Doc>;  // by tool name
+  using NameChunk = std::array<std::string, kNameChunk>;  // doc id -> name
+
+  static size_t shardOf(const std::string& key);
+  static uint64_t newOwner();
+  // The shard, cloned first unless this index owns it. 'owner' is the
+  // shard's tag: the index that created or cloned it. Ownership is tracked
+  // explicitly rather than read off use_count(), which is not synchronized
+  // with a fork dropping its reference.
+  template <typename Shard>
+  Shard& writable(std::shared_ptr<Shard>& shard, uint64_t& owner);
+
+  std::array<std::shared_ptr<PostingShard>, kShards> postings_;
+  std::array<std::shared_ptr<DocShard>, kShards> docs_;
+  std::vector<std::shared_ptr<NameChunk>> names_;
+  std::array<uint64_t, kShards> postingOwners_{};
+  std::array<uint64_t, kShards> docOwners_{};
+  std::vector<uint64_t> nameOwners_;
+  // Tag of the shards this index may change in place; unique per index
+  uint64_t owner_ = newOwner();
+  std::vector<uint32_t> freeIds_;
+  uint32_t nextId_ = 0;
+  size_t size_ = 0;
+};
@@ -0,0 +1,55 @@
+#pragma once
+#include <map>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+class McpServer;
+
+// Runs a small DAG of tool calls inside the server (the 'run_pipeline' tool).
+//
+// Arguments:
+//   {"steps": [{"id": "a", "tool": "...", "arguments": {...},
+//               "dependsOn": ["..."]}, ...],
+//    "output": "final" | "all",   // default "final"
+//    "final": "<step id>"}        // default: the last step listed
+//
+// Anywhere inside a step's arguments, {"$ref": "a"} is replaced by the result
+// of step "a", and {"$ref": "a/some/pointer"} by the part of it at that JSON
+// pointer. References imply dependencies; "dependsOn" adds ordering-only ones.
+// Each step starts as soon as its own dependencies are complete, up to
+// kMaxParallelSteps at once, on the server's work lane (McpServer::submitWork)
+// or on the thread running the pipeline; intermediate results stay in the
+// server and only the requested output is returned.
+class ToolPipeline {
+ public:
+  static constexpr size_t kMaxSteps = 64;
+  static constexpr size_t kMaxParallelSteps = 8;
+  static constexpr const char *kToolName = "run_pipeline";
+
+  explicit ToolPipeline(McpServer &server);
+
+  // Validate and run a pipeline. Throws std::runtime_error on invalid input
+  // or when a step fails; a step's ServerBusyError or MemoryBudgetExceeded
+  // propagates as is.
+  json run(const json &request);
+
+  // inputSchema of the 'run_pipeline' tool
+  static json inputSchema();
+
+ private:
+  struct Step {
+    std::string id;
+    std::string tool;
+    json arguments;
+    std::vector<std::string> dependsOn;
+  };
+
+  json runStep(const Step &step);
+  json resolveRefs(const json &value) const;
+
+  McpServer &server_;
+  std::map<std::string, json> results_;
+};
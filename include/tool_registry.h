@@ -0,0 +1,81 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "mcp_tool.h"
+#include "tool_index.h"
+
+// A registered tool together with its handler. Entries are immutable once
+// published and shared between snapshots.
+//
+// Async tools also get a blocking 'handler' that runs the coroutine and waits
+// for it, so synchronous callers (pipelines, McpClient) work unchanged.
+struct ToolEntry {
+  McpTool tool;
+  ToolHandler handler;
+  AsyncToolHandler asyncHandler;  // empty for synchronous tools
+};
+
+// Immutable view of the tool registry at one point in time
+struct ToolSnapshot {
+  std::map<std::string, std::shared_ptr<const ToolEntry>> entries;
+  ToolIndex index;
+  uint64_t version = 0;
+
+  // Returns nullptr if no tool with that name is registered
+  const ToolEntry *find(const std::string &name) const {
+    auto it = entries.find(name);
+    return it != entries.end() ? it->second.get() : nullptr;
+  }
+};
+
+// Live tool registry with RCU-style publication.
+//
+// Readers call snapshot() and keep using the returned snapshot for as long as
+// they hold it. Each thread caches the snapshot it saw last and reuses it
+// while an atomic version counter says it is current, so the common path is
+// one atomic load plus a reference count increment; the first lookup on a
+// thread after a change loads the published std::atomic<std::shared_ptr>,
+// without taking a mutex. Writers derive a new snapshot from the current one
+// (sharing the tool entries, and forking the index so it shares every shard
+// the change does not touch), apply their change and publish it.
+// Writers are serialized among themselves, and a snapshot is freed when its
+// last reader drops it, so in-flight calls keep the handler they started
+// with even if the tool is replaced or unregistered meanwhile. A thread's
+// cache keeps a superseded snapshot alive until that thread's next lookup.
+class ToolRegistry {
+ public:
+  ToolRegistry();
+
+  std::shared_ptr<const ToolSnapshot> snapshot() const;
+
+  // Register or replace a tool. Each call publishes a new version; batch
+  // bulk registration with update().
+  void addTool(const McpTool &tool, ToolHandler handler);
+  void addAsyncTool(const McpTool &tool, AsyncToolHandler handler);
+  // Unregister a tool. Returns false if it was not registered.
+  bool removeTool(const std::string &name);
+
+  // Apply several changes and publish them as a single new version. Use this
+  // for bulk registration to avoid copying the registry once per tool.
+  void update(const std::function<void(ToolSnapshot &)> &mutator);
+
+  // Helpers for use inside update()
+  static void put(ToolSnapshot &snapshot, const McpTool &tool,
+                  ToolHandler handler);
+  static void putAsync(ToolSnapshot &snapshot, const McpTool &tool,
+                       AsyncToolHandler handler);
+  static void put(ToolSnapshot &snapshot, ToolEntry entry);
+  static bool erase(ToolSnapshot &snapshot, const std::string &name);
+
+ private:
+  const uint64_t id_;  // tells registries apart in the per-thread cache
+  std::atomic<uint64_t> version_{0};
+  std::atomic<std::shared_ptr<const ToolSnapshot>> current_;
+  std::mutex writeMutex_;
+};
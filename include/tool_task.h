@@ -0,0 +1,157 @@
+#pragma once
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <utility>
+
+#include "memory_accounting.h"
+
+using json = nlohmann::json;
+
+// Coroutine type for asynchronous tool handlers:
+//
+//   ToolTask fetch(json args) {
+//     co_await executor.readable(fd);
+//     co_return json{...};
+//   }
+//
+// A task does not run until it is awaited by another ToolTask or started
+// with start(). While suspended it holds no thread; whoever resumes it (see
+// IoExecutor) continues running it, inside the MemoryScope that was current
+// when the task was created; every co_await is a MemoryScope::checkpoint(),
+// so a task over its budget throws MemoryBudgetExceeded at the next one.
+// Take arguments by value: a suspended coroutine may outlive the caller's
+// references.
+class ToolTask {
+ public:
+  // Receives the result, or the exception the coroutine ended with
+  using Completion = std::function<void(json, std::exception_ptr)>;
+
+  struct promise_type {
+    json value;
+    std::exception_ptr error;
+    std::coroutine_handle<> continuation;  // awaiting ToolTask, if any
+    Completion onDone;                     // set by start()
+    // Charged for the coroutine's allocations on whichever thread runs it
+    MemoryScope::Handle memory = MemoryScope::current();
+    std::optional<MemoryScope::Attach> attached;
+
+    // Every stretch of the body, from a resumption to the next suspension,
+    // runs attached to 'memory'
+    void enter() { attached.emplace(memory); }
+    void leave() noexcept { attached.reset(); }
+
+    ToolTask get_return_object() {
+      return ToolTask(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+
+    struct InitialAwaiter {
+      promise_type &promise;
+      bool await_ready() noexcept { return false; }
+      void await_suspend(std::coroutine_handle<>) noexcept {}
+      void await_resume() { promise.enter(); }
+    };
+    InitialAwaiter initial_suspend() noexcept { return {*this}; }
+
+    template <typename Awaitable>
+    struct ScopedAwaiter {
+      Awaitable inner;
+      promise_type &promise;
+      bool suspended = false;
+
+      bool await_ready() { return inner.await_ready(); }
+      auto await_suspend(std::coroutine_handle<promise_type> handle) {
+        promise.leave();
+        suspended = true;
+        try {
+          return inner.await_suspend(handle);
+        } catch (...) {
+          promise.enter();
+          suspended = false;
+          throw;
+        }
+      }
+      decltype(auto) await_resume() {
+        if (suspended) promise.enter();
+        // Abort a task that went over budget before it allocates any more
+        MemoryScope::checkpoint();
+        return inner.await_resume();
+      }
+    };
+    template <typename Awaitable>
+    ScopedAwaiter<Awaitable> await_transform(Awaitable &&awaitable) {
+      return {std::forward<Awaitable>(awaitable), *this};
+    }
+
+    struct FinalAwaiter {
+      bool await_ready() noexcept { return false; }
+      std::coroutine_handle<> await_suspend(
+          std::coroutine_handle<promise_type> handle) noexcept {
+        promise_type &promise = handle.promise();
+        promise.leave();
+        if (promise.continuation) return promise.continuation;
+        // Detached: the frame owns itself, so free it before reporting
+        Completion done = std::move(promise.onDone);
+        json value = std::move(promise.value);
+        std::exception_ptr error = promise.error;
+        handle.destroy();
+        if (done) {
+          try {
+            done(std::move(value), error);
+          } catch (...) {
+            // Nowhere to report it from here; completions must not throw
+          }
+        }
+        return std::noop_coroutine();
+      }
+      void await_resume() noexcept {}
+    };
+    FinalAwaiter final_suspend() noexcept { return {}; }
+
+    void return_value(json result) { value = std::move(result); }
+    void unhandled_exception() { error = std::current_exception(); }
+  };
+
+  ToolTask(ToolTask &&other) noexcept
+      : handle_(std::exchange(other.handle_, nullptr)) {}
+  ToolTask &operator=(ToolTask &&other) noexcept {
+    if (this != &other) {
+      if (handle_) handle_.destroy();
+      handle_ = std::exchange(other.handle_, nullptr);
+    }
+    return *this;
+  }
+  ToolTask(const ToolTask &) = delete;
+  ToolTask &operator=(const ToolTask &) = delete;
+  ~ToolTask() {
+    if (handle_) handle_.destroy();
+  }
+
+  // Run the task detached: it starts on the calling thread and 'done' is
+  // called on whichever thread finishes it. 'done' must not throw.
+  void start(Completion done) && {
+    auto handle = std::exchange(handle_, nullptr);
+    handle.promise().onDone = std::move(done);
+    handle.resume();
+  }
+
+  // Awaiting a task from another coroutine runs it and yields its result
+  bool await_ready() const noexcept { return false; }
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) {
+    handle_.promise().continuation = awaiting;
+    return handle_;
+  }
+  json await_resume() {
+    promise_type &promise = handle_.promise();
+    if (promise.error) std::rethrow_exception(promise.error);
+    return std::move(promise.value);
+  }
+
+ private:
+  explicit ToolTask(std::coroutine_handle<promise_type> handle)
+      : handle_(handle) {}
+
+  std::coroutine_handle<promise_type> handle_;
+};
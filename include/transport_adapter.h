@@ -2,6 +2,10 @@
 #include <string>
 
 // Abstract interface for message transport (stdin/stdout, TCP, etc.)
+//
+// McpServer::serve() calls readMessage() from one thread while other threads
+// call writeMessage() (one at a time), so an adapter must allow a read and a
+// write to run concurrently.
 class ITransportAdapter {
  public:
   virtual ~ITransportAdapter() = default;
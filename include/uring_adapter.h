@@ -0,0 +1,93 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "transport_adapter.h"
+
+// Newline-delimited JSON-RPC over file descriptors (stdin/stdout or a
+// connected local socket), driven by io_uring on Linux.
+//
+// - Reads use a registered (fixed) buffer; on sockets a multishot receive
+//   with a provided-buffer ring keeps one request armed for the whole
+//   connection, so a busy client costs one io_uring_enter per batch of
+//   completions instead of a read() per message.
+// - Writes from any thread are appended to an output batch; one write is in
+//   flight at a time and everything queued behind it goes out in the next
+//   submission. Batches that fit are copied into a registered buffer.
+// - io_uring is set up with raw syscalls (no liburing). If it is not
+//   available at runtime (old kernel, seccomp, non-Linux), the adapter falls
+//   back to plain blocking read()/write(); check usingUring().
+//
+// Completions are reaped by the thread blocked in readMessage(); when no
+// thread is reading, writers reap their own. Once the input has ended,
+// queued output is flushed and later writes complete before returning.
+class UringAdapter : public ITransportAdapter {
+ public:
+  static constexpr size_t kReadBufferSize = 64 * 1024;
+  static constexpr size_t kWriteBufferSize = 256 * 1024;
+  static constexpr size_t kMaxQueuedOutput = 8 * 1024 * 1024;
+
+  // Does not take ownership of the descriptors
+  UringAdapter(int readFd, int writeFd);
+  ~UringAdapter() override;
+
+  UringAdapter(const UringAdapter &) = delete;
+  UringAdapter &operator=(const UringAdapter &) = delete;
+
+  bool readMessage(std::string &message) override;
+  bool writeMessage(const std::string &message) override;
+
+  bool usingUring() const { return ring_ != nullptr; }
+  bool usingMultishot() const { return multishot_; }
+
+  // True if this kernel lets the process create an io_uring
+  static bool available();
+
+ private:
+  struct Ring;
+
+  // Reading state is guarded by cqMutex_, whoever holds it reaps
+  bool takeLine(std::string &message);
+  bool takeRemainder(std::string &message);
+  bool armReadLocked();
+  void reapLocked();
+  void onReadCompletion(int32_t res, uint32_t flags);
+  void onWriteCompletion(int32_t res);
+  // Reap completions unless another thread already is; optionally waits
+  // for at least one. Must be called without outMutex_.
+  bool tryReap(bool wait);
+
+  // Writing state is guarded by outMutex_
+  void submitWriteLocked();
+  void issueWriteLocked();
+  void waitForWrites(std::unique_lock<std::mutex> &outLock, bool all);
+
+  bool fallbackRead(std::string &message);
+  bool fallbackWrite(const std::string &message);
+
+  int readFd_;
+  int writeFd_;
+  std::unique_ptr<Ring> ring_;
+  bool multishot_ = false;
+  bool providedBuffersWork_ = false;  // a multishot receive delivered data
+
+  std::mutex cqMutex_;
+  std::string input_;     // received bytes not yet returned as messages
+  size_t inputStart_ = 0;  // start of the next message in input_
+  size_t scanned_ = 0;     // input_ before this has no newline left
+  bool readArmed_ = false;
+  bool eof_ = false;
+
+  std::mutex outMutex_;
+  std::condition_variable writeDone_;
+  std::string queued_;    // waiting for the write in flight
+  std::string inFlight_;  // being written
+  size_t inFlightOffset_ = 0;
+  bool writeInFlight_ = false;
+  bool writeFailed_ = false;
+  bool inputClosed_ = false;  // readMessage() hit EOF; writes are synchronous
+};
@@ -0,0 +1,82 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <vector>
+
+using json = nlohmann::json;
+
+struct WorkerPoolOptions {
+  size_t workers = 2;
+  size_t ringCapacity = 1 << 20;  // bytes per direction and worker
+  size_t memoryLimitBytes = 0;    // RLIMIT_AS per worker, 0 = unlimited
+  unsigned cpuLimitSeconds = 0;   // CPU seconds per call, 0 = unlimited
+  // Kill a worker whose call takes longer, and reject a call that waits
+  // longer for an idle worker; <= 0 = never
+  int callTimeoutMs = 30000;
+};
+
+// Runs tool calls in pre-forked worker processes so that a crashing, leaking
+// or spinning tool cannot take down or starve the server.
+//
+// Each worker gets a shared-memory segment holding a request and a response
+// ShmRing; arguments and results are copied into the rings, never through a
+// pipe. A worker runs one call at a time. When it dies, exceeds its resource
+// limits or misses the call timeout, the call fails with an exception and the
+// worker is replaced by a fresh fork.
+//
+// Workers are forked from a zygote: a copy of the server forked once when the
+// pool starts, which stays single-threaded, so respawned workers never
+// inherit locks held by server threads. Workers run the handlers registered
+// when the pool started. Start the pool after registering tools and before
+// starting other threads. If the zygote dies, its workers die too and
+// further calls fail. POSIX only.
+//
+// While a call runs, the server checks that its worker is still alive
+// through a pidfd (Linux 5.3+), without a round trip to the zygote; the
+// zygote is only asked for the exit status of a worker that died, or on
+// every check where pidfds are unavailable.
+class WorkerPool {
+ public:
+  // Runs a tool inside a worker process
+  using Executor = std::function<json(const std::string &, const json &)>;
+
+  WorkerPool(Executor executor, const WorkerPoolOptions &options);
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool &operator=(const WorkerPool &) = delete;
+
+  // Run 'tool' in an idle worker, waiting for one if all are busy. Throws
+  // ServerBusyError if none becomes idle within callTimeoutMs, and
+  // std::runtime_error if the tool fails or the worker is lost.
+  json call(const std::string &tool, const json &arguments);
+
+  size_t size() const { return workers_.size(); }
+  size_t respawnCount() const;
+
+  struct Worker;
+
+ private:
+  void startZygote();
+  // One request/reply exchange with the zygote; throws if it is gone
+  int zygoteCall(int op, size_t index, int pid, int *status);
+  void spawn(Worker &worker);
+  void retire(Worker &worker);
+  bool alive(Worker &worker);
+
+  Executor executor_;
+  WorkerPoolOptions options_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<Worker *> idle_;
+  mutable std::mutex mutex_;
+  std::condition_variable idleCv_;
+  size_t respawns_ = 0;
+  int zygotePid_ = -1;
+  int zygoteFd_ = -1;
+  std::mutex zygoteMutex_;
+};
@@ -0,0 +1,225 @@
+#include "admission_controller.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <optional>
+
+#include "mcp_logger.h"
+
+AdmissionController::Ticket &AdmissionController::Ticket::operator=(
+    Ticket &&other) noexcept {
+  if (this != &other) {
+    release();
+    owner_ = other.owner_;
+    tool_ = std::move(other.tool_);
+    global_ = other.global_;
+    other.owner_ = nullptr;
+  }
+  return *this;
+}
+
+void AdmissionController::Ticket::release() {
+  if (owner_) {
+    owner_->release(tool_, global_);
+    owner_ = nullptr;
+  }
+}
+
+bool AdmissionController::AdmitAwaiter::await_suspend(
+    std::coroutine_handle<> handle) {
+  try {
+    // Once parked, another thread may resume the coroutine (and free this
+    // awaiter) at any moment, so nothing here touches it afterwards
+    return !owner_.tryAdmit(
+        tool_, limits_, ticket_,
+        [this, handle](Ticket ticket) {
+          ticket_ = std::move(ticket);
+          resume_(handle);
+        },
+        countGlobal_);
+  } catch (...) {
+    error_ = std::current_exception();
+    return false;
+  }
+}
+
+AdmissionController::Ticket AdmissionController::AdmitAwaiter::await_resume() {
+  if (error_) std::rethrow_exception(error_);
+  return std::move(ticket_);
+}
+
+void AdmissionController::setGlobalLimits(size_t maxInFlight,
+                                          size_t maxQueued) {
+  std::vector<std::pair<Admitted, Ticket>> ready;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    maxInFlight_ = maxInFlight;
+    maxQueued_ = maxQueued;
+    ready = admitQueued();
+  }
+  handOff(std::move(ready));
+}
+
+void AdmissionController::setBlockingWaitLimit(size_t maxBlocked) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  maxBlocked_ = maxBlocked;
+}
+
+bool AdmissionController::blocked(const ToolState &state,
+                                  const AdmissionLimits &limits,
+                                  bool countGlobal) const {
+  return (limits.maxConcurrency > 0 &&
+          state.inFlight >= limits.maxConcurrency) ||
+         (countGlobal && maxInFlight_ > 0 && inFlight_ >= maxInFlight_);
+}
+
+void AdmissionController::take(ToolState &state, bool countGlobal,
+                               bool waited) {
+  ++state.inFlight;
+  if (countGlobal) ++inFlight_;
+  ++state.admitted;
+  ++admitted_;
+  if (waited) ++state.queued;
+  state.peakInFlight = std::max(state.peakInFlight, state.inFlight);
+  peakInFlight_ = std::max(peakInFlight_, inFlight_);
+}
+
+AdmissionController::Ticket AdmissionController::admit(
+    const std::string &tool, const AdmissionLimits &limits, bool countGlobal) {
+  struct Handoff {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::optional<Ticket> ticket;
+  };
+  auto handoff = std::make_shared<Handoff>();
+  Ticket ticket;
+  if (request(tool, limits, countGlobal, true, ticket,
+              [handoff](Ticket admitted) {
+                std::lock_guard<std::mutex> lock(handoff->mutex);
+                handoff->ticket.emplace(std::move(admitted));
+                handoff->cv.notify_one();
+              })) {
+    return ticket;
+  }
+  std::unique_lock<std::mutex> lock(handoff->mutex);
+  handoff->cv.wait(lock, [&] { return handoff->ticket.has_value(); });
+  return std::move(*handoff->ticket);
+}
+
+bool AdmissionController::tryAdmit(const std::string &tool,
+                                   const AdmissionLimits &limits,
+                                   Ticket &ticket, Admitted admitted,
+                                   bool countGlobal) {
+  return request(tool, limits, countGlobal, false, ticket,
+                 std::move(admitted));
+}
+
+bool AdmissionController::request(const std::string &tool,
+                                  const AdmissionLimits &limits,
+                                  bool countGlobal, bool blocking,
+                                  Ticket &ticket, Admitted admitted) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  ToolState &state = tools_[tool];
+
+  if (!blocked(state, limits, countGlobal)) {
+    take(state, countGlobal, false);
+    ticket = Ticket(this, tool, countGlobal);
+    return true;
+  }
+
+  bool toolFull = limits.maxConcurrency > 0 &&
+                  state.inFlight >= limits.maxConcurrency &&
+                  state.waiting >= limits.maxQueued;
+  // Only calls held back by the global limit use the global queue; calls
+  // waiting on a per-tool cap alone, and nested calls, are bounded per tool
+  bool globalWait =
+      countGlobal && maxInFlight_ > 0 && inFlight_ >= maxInFlight_;
+  bool globalFull = globalWait && globalWaiting_ >= maxQueued_;
+  // A thread blocked here is a thread the scheduler cannot use
+  bool threadsFull = blocking && blockedWaiting_ >= maxBlocked_;
+  if (toolFull || globalFull || threadsFull) {
+    ++state.rejected;
+    ++rejected_;
+    throw ServerBusyError("Server busy: too many pending calls to " + tool);
+  }
+
+  ++state.waiting;
+  ++waiting_;
+  if (globalWait) ++globalWaiting_;
+  if (blocking) ++blockedWaiting_;
+  queue_.push_back(
+      {tool, limits, countGlobal, blocking, globalWait, std::move(admitted)});
+  return false;
+}
+
+std::vector<std::pair<AdmissionController::Admitted, AdmissionController::Ticket>>
+AdmissionController::admitQueued() {
+  std::vector<std::pair<Admitted, Ticket>> ready;
+  for (auto it = queue_.begin(); it != queue_.end();) {
+    ToolState &state = tools_[it->tool];
+    if (blocked(state, it->limits, it->countGlobal)) {
+      ++it;
+      continue;
+    }
+    --state.waiting;
+    --waiting_;
+    if (it->globalWait) --globalWaiting_;
+    if (it->blocking) --blockedWaiting_;
+    take(state, it->countGlobal, true);
+    ready.emplace_back(std::move(it->admitted),
+                       Ticket(this, it->tool, it->countGlobal));
+    it = queue_.erase(it);
+  }
+  return ready;
+}
+
+void AdmissionController::handOff(
+    std::vector<std::pair<Admitted, Ticket>> ready) {
+  for (auto &[admitted, ticket] : ready) {
+    try {
+      admitted(std::move(ticket));
+    } catch (const std::exception &e) {
+      // The ticket went with the continuation and is released again
+      spdlog::error(std::string("Admitted call could not be resumed: ") +
+                    e.what());
+    } catch (...) {
+      spdlog::error("Admitted call could not be resumed");
+    }
+  }
+}
+
+void AdmissionController::release(const std::string &tool, bool global) {
+  std::vector<std::pair<Admitted, Ticket>> ready;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = tools_.find(tool);
+    if (it != tools_.end() && it->second.inFlight > 0) --it->second.inFlight;
+    if (global && inFlight_ > 0) --inFlight_;
+    ready = admitQueued();
+  }
+  handOff(std::move(ready));
+}
+
+json AdmissionController::stats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  json tools = json::object();
+  for (const auto &[name, state] : tools_) {
+    tools[name] = {{"inFlight", state.inFlight},
+                   {"waiting", state.waiting},
+                   {"peakInFlight", state.peakInFlight},
+                   {"admitted", state.admitted},
+                   {"queued", state.queued},
+                   {"rejected", state.rejected}};
+  }
+  return {{"maxInFlight", maxInFlight_},
+          {"maxQueued", maxQueued_},
+          {"inFlight", inFlight_},
+          {"waiting", waiting_},
+          {"globalWaiting", globalWaiting_},
+          {"blockedWaiting", blockedWaiting_},
+          {"peakInFlight", peakInFlight_},
+          {"admitted", admitted_},
+          {"rejected", rejected_},
+          {"tools", tools}};
+}
@@ -10,29 +10,43 @@ void CallToolHandler::handle(const json& request, std::string& response) {
   std::string method, id;
   json params;
   if (jsonRpc_.parseRequest(request.dump(), method, params, id)) {
+    if (!params.is_object() || !params.contains("name") ||
+        !params["name"].is_string() ||
+        (params.contains("arguments") && !params["arguments"].is_object())) {
+      spdlog::warn("Invalid tools/call params");
+      response = jsonRpc_.createErrorResponse(
+          id, -32602,
+          "Invalid params: 'name' must be a string and 'arguments' an object");
+      return;
+    }
     std::string toolName = params["name"];
     json arguments =
         params.contains("arguments") ? params["arguments"] : json::object();
-    spdlog::info("Tool call request - name: " + toolName +
-                 ", arguments: " + arguments.dump());
+    McpLogging::payload_logger()->info("Tool call request - name: " +
+                                       toolName +
+                                       ", arguments: " + arguments.dump());
     // Use the tool handler if it exists
-    auto& handlers = server_.getToolHandlers();
-    if (handlers.find(toolName) != handlers.end()) {
+    auto snapshot = server_.getToolSnapshot();
+    if (const ToolEntry* entry = snapshot->find(toolName)) {
       try {
         spdlog::info("Calling tool: " + toolName);
-        json result = handlers.at(toolName)(arguments);
-        json contentArray = json::array();
-        json textContent = {
-            {"type", "text"},
-            {"text",
-             result.is_string() ? result.get<std::string>() : result.dump()}};
-        contentArray.push_back(textContent);
-        json resultObj = {{"content", contentArray}};
+        json result = server_.invokeTool(*entry, arguments);
+        json resultObj = server_.buildCallResult(std::move(result));
         response = jsonRpc_.createResponse(id, resultObj);
         spdlog::info("Tool call completed successfully: " + toolName);
+      } catch (const ServerBusyError& e) {
+        spdlog::warn("Tool call rejected: " + toolName + " - " + e.what());
+        response = jsonRpc_.createErrorResponse(id, kServerBusyError, e.what());
+      } catch (const MemoryBudgetExceeded& e) {
+        spdlog::warn("Tool call failed: " + toolName + " - " + e.message());
+        response =
+            jsonRpc_.createErrorResponse(id, kMemoryBudgetError, e.message());
       } catch (const std::exception& e) {
         spdlog::error("Tool call failed: " + toolName + " - " + e.what());
         response = jsonRpc_.createErrorResponse(id, -32603, e.what());
+      } catch (...) {
+        spdlog::error("Tool call failed: " + toolName + " - unknown error");
+        response = jsonRpc_.createErrorResponse(id, -32603, "Unknown error");
       }
     } else {
       spdlog::error("Tool not found: " + toolName);
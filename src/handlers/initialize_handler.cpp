@@ -16,6 +16,13 @@ void InitializeHandler::handle(const json& request, std::string& response) {
         {"capabilities",
          {{"tools", server_.getCapabilities().tools},
           {"logging", server_.getCapabilities().logging}}}};
+    if (server_.getCapabilities().resources) {
+      result["capabilities"]["resources"] = {{"subscribe", true},
+                                             {"listChanged", false}};
+    }
+    if (server_.getCapabilities().prompts) {
+      result["capabilities"]["prompts"] = {{"listChanged", false}};
+    }
     response = jsonRpc_.createResponse(id, result);
     spdlog::info("Initialize response created successfully");
   } else {
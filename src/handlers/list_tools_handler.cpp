@@ -10,7 +10,9 @@ void ListToolsHandler::handle(const json& request, std::string& response) {
   json params;
   if (jsonRpc_.parseRequest(request.dump(), method, params, id)) {
     json toolsArray = json::array();
-    for (const auto& [name, tool] : server_.getTools()) {
+    auto snapshot = server_.getToolSnapshot();
+    for (const auto& [name, entry] : snapshot->entries) {
+      const McpTool& tool = entry->tool;
       json toolObj = {{"name", tool.name},
                       {"description", tool.description},
                       {"inputSchema", tool.inputSchema}};
@@ -0,0 +1,201 @@
+#include "io_executor.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "mcp_logger.h"
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#endif
+
+namespace {
+
+constexpr int kMaxEvents = 64;
+
+}  // namespace
+
+IoExecutor::IoExecutor(size_t threads) {
+#ifdef __linux__
+  epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+  wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (epollFd_ < 0 || wakeFd_ < 0) {
+    if (epollFd_ >= 0) ::close(epollFd_);
+    if (wakeFd_ >= 0) ::close(wakeFd_);
+    throw std::runtime_error("Cannot create async executor: " +
+                             std::string(std::strerror(errno)));
+  }
+  // data.ptr == nullptr marks the wakeup eventfd
+  struct epoll_event ev {};
+  ev.events = EPOLLIN;
+  ev.data.ptr = nullptr;
+  epoll_ctl(epollFd_, EPOLL_CTL_ADD, wakeFd_, &ev);
+#endif
+  threads = std::max<size_t>(1, threads);
+  for (size_t i = 0; i < threads; ++i) {
+    threads_.emplace_back([this] { run(); });
+  }
+}
+
+IoExecutor::~IoExecutor() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake();
+  for (auto &thread : threads_) thread.join();
+#ifdef __linux__
+  ::close(epollFd_);
+  ::close(wakeFd_);
+#endif
+}
+
+void IoExecutor::wake() {
+#ifdef __linux__
+  uint64_t one = 1;
+  (void)!::write(wakeFd_, &one, sizeof(one));
+#else
+  cv_.notify_all();
+#endif
+}
+
+void IoExecutor::post(std::coroutine_handle<> handle) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    posted_.push_back(handle);
+  }
+  wake();
+}
+
+void IoExecutor::addTimer(std::chrono::steady_clock::time_point deadline,
+                          std::coroutine_handle<> handle) {
+  bool earliest;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    earliest = timers_.empty() || deadline < timers_.begin()->first;
+    timers_.emplace(deadline, handle);
+    ++waiting_;
+  }
+  // Threads sleep until the old earliest deadline; make one recompute
+  if (earliest) wake();
+}
+
+IoExecutor::FdAwaiter IoExecutor::readable(int fd) {
+#ifdef __linux__
+  return {*this, fd, EPOLLIN | EPOLLRDHUP};
+#else
+  return {*this, fd, 1};
+#endif
+}
+
+IoExecutor::FdAwaiter IoExecutor::writable(int fd) {
+#ifdef __linux__
+  return {*this, fd, EPOLLOUT};
+#else
+  return {*this, fd, 4};
+#endif
+}
+
+void IoExecutor::FdAwaiter::await_suspend(std::coroutine_handle<> handle) {
+  waiter.handle = handle;
+  waiter.fd = fd;
+  executor.watch(waiter, events);
+}
+
+#ifndef __linux__
+
+void IoExecutor::watch(Waiter &, uint32_t) {
+  throw std::runtime_error("Waiting for fd readiness is not supported here");
+}
+
+#else
+
+void IoExecutor::watch(Waiter &waiter, uint32_t events) {
+  struct epoll_event ev {};
+  ev.events = events | EPOLLONESHOT;
+  ev.data.ptr = &waiter;
+  ++waiting_;
+  // Once added, another thread may resume the coroutine at any moment, so
+  // nothing here may touch 'waiter' afterwards
+  if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, waiter.fd, &ev) != 0) {
+    --waiting_;
+    throw std::runtime_error("Cannot wait on fd " + std::to_string(waiter.fd) +
+                             ": " + std::strerror(errno));
+  }
+}
+
+#endif
+
+int IoExecutor::collectReady(std::vector<std::coroutine_handle<>> &ready) {
+  using namespace std::chrono;
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto now = steady_clock::now();
+  while (!timers_.empty() && timers_.begin()->first <= now) {
+    ready.push_back(timers_.begin()->second);
+    timers_.erase(timers_.begin());
+    --waiting_;
+  }
+  ready.insert(ready.end(), posted_.begin(), posted_.end());
+  posted_.clear();
+
+  if (timers_.empty()) return -1;
+  auto wait = duration_cast<milliseconds>(timers_.begin()->first - now) +
+              milliseconds(1);  // round up so the timer is due on wakeup
+  return static_cast<int>(std::min<int64_t>(wait.count(), 60000));
+}
+
+void IoExecutor::run() {
+  std::vector<std::coroutine_handle<>> ready;
+  for (;;) {
+    ready.clear();
+    int timeoutMs = collectReady(ready);
+    if (ready.empty()) {
+#ifdef __linux__
+      struct epoll_event events[kMaxEvents];
+      int n = epoll_wait(epollFd_, events, kMaxEvents, timeoutMs);
+      if (n < 0 && errno != EINTR) {
+        spdlog::error("Async executor epoll_wait failed; stopping thread");
+        return;
+      }
+      for (int i = 0; i < n; ++i) {
+        if (events[i].data.ptr == nullptr) {
+          // When stopping, leave the counter set so every thread wakes up
+          std::lock_guard<std::mutex> lock(mutex_);
+          if (!stopping_) {
+            uint64_t value;
+            (void)!::read(wakeFd_, &value, sizeof(value));
+          }
+          continue;
+        }
+        auto *waiter = static_cast<Waiter *>(events[i].data.ptr);
+        // Unregister before resuming: the coroutine may close the fd or
+        // wait on it again
+        epoll_ctl(epollFd_, EPOLL_CTL_DEL, waiter->fd, nullptr);
+        waiter->revents = events[i].events;
+        --waiting_;
+        ready.push_back(waiter->handle);
+      }
+#else
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (!stopping_ && posted_.empty()) {
+        if (timeoutMs < 0) {
+          cv_.wait(lock);
+        } else {
+          cv_.wait_for(lock, std::chrono::milliseconds(timeoutMs));
+        }
+      }
+#endif
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stopping_) return;
+    }
+    for (auto handle : ready) handle.resume();
+  }
+}
@@ -22,10 +22,8 @@ bool JsonRpc::parseRequest(const std::string &jsonStr, std::string &method,
 
         if (j.contains("id"))
         {
-            if (j["id"].is_string())
-                id = j["id"];
-            else if (j["id"].is_number())
-                id = std::to_string(j["id"].get<int>());
+            if (j["id"].is_string() || j["id"].is_number())
+                id = idString(j["id"]);
         }
 
         if (j.contains("params"))
@@ -47,16 +45,8 @@ std::string JsonRpc::createResponse(const std::string &id, const json &result)
         {"jsonrpc", "2.0"},
         {"result", result}};
 
-    // Preserve the original ID type - try to convert back to number if it was numeric
-    try
-    {
-        int numericId = std::stoi(id);
-        response["id"] = numericId;
-    }
-    catch (...)
-    {
-        response["id"] = id; // Keep as string if conversion fails
-    }
+    // Preserve the original ID type - convert back to number if it was numeric
+    response["id"] = idValue(id);
 
     return response.dump(); // Single line for MCP compatibility
 }
@@ -68,18 +58,139 @@ std::string JsonRpc::createErrorResponse(const std::string &id, int errorCode,
         {"jsonrpc", "2.0"},
         {"error", {{"code", errorCode}, {"message", errorMessage}}}};
 
-    // Preserve the original ID type - try to convert back to number if it was numeric
+    // Preserve the original ID type - convert back to number if it was numeric
+    response["id"] = idValue(id);
+
+    return response.dump(); // Single line for MCP compatibility
+}
+
+std::string JsonRpc::idString(const json &id)
+{
+    if (id.is_string())
+        return id.get<std::string>();
+    // dump() keeps 64-bit and fractional ids exact where get<int>() would not
+    return id.dump();
+}
+
+json JsonRpc::idValue(const std::string &id)
+{
+    json parsed = json::parse(id, nullptr, false);
+    if (parsed.is_number())
+        return parsed;
+    return id; // Keep as string if it is not a number
+}
+
+// Parse 'jsonStr' keeping only the top-level member 'key'; every other
+// member is discarded as soon as it has been read. Null if absent or invalid.
+static json peekMember(const std::string &jsonStr, const std::string &key)
+{
+    bool keep = false;
+    json j = json::parse(
+        jsonStr,
+        [&keep, &key](int depth, json::parse_event_t event, json &parsed)
+        {
+            if (depth != 1)
+                return true;
+            if (event == json::parse_event_t::key)
+            {
+                keep = parsed == key;
+                return keep;
+            }
+            return keep;
+        },
+        false);
+    if (j.is_object() && j.contains(key))
+        return j[key];
+    return nullptr;
+}
+
+std::string JsonRpc::peekMethod(const std::string &jsonStr)
+{
+    // Single pass that tracks nesting, so a "method" key inside params (tool
+    // arguments, say) is never taken for the request's own
+    const size_t n = jsonStr.size();
+    int depth = 0;
+    bool expectKey = false;
+    size_t i = 0;
+    while (i < n)
+    {
+        char c = jsonStr[i];
+        if (c == '"')
+        {
+            size_t end = i + 1;
+            bool escaped = false;
+            while (end < n && jsonStr[end] != '"')
+            {
+                if (jsonStr[end] == '\\')
+                {
+                    escaped = true;
+                    ++end;
+                }
+                ++end;
+            }
+            if (end >= n)
+                return "";
+            bool isKey = depth == 1 && expectKey;
+            expectKey = false;
+            if (isKey && escaped)
+            {
+                // Escaped keys are rare; let the parser decode them
+                json method = peekMember(jsonStr, "method");
+                return method.is_string() ? method.get<std::string>() : "";
+            }
+            if (isKey && jsonStr.compare(i + 1, end - i - 1, "method") == 0)
+            {
+                size_t v = jsonStr.find_first_not_of(" \t\r\n", end + 1);
+                if (v == std::string::npos || jsonStr[v] != ':')
+                    return "";
+                v = jsonStr.find_first_not_of(" \t\r\n", v + 1);
+                if (v == std::string::npos || jsonStr[v] != '"')
+                    return "";
+                size_t close = jsonStr.find('"', v + 1);
+                if (close == std::string::npos)
+                    return "";
+                std::string method = jsonStr.substr(v + 1, close - v - 1);
+                if (method.find('\\') != std::string::npos)
+                {
+                    json parsed = peekMember(jsonStr, "method");
+                    return parsed.is_string() ? parsed.get<std::string>() : "";
+                }
+                return method;
+            }
+            i = end + 1;
+            continue;
+        }
+        if (c == '{' || c == '[')
+        {
+            ++depth;
+            expectKey = depth == 1 && c == '{';
+        }
+        else if (c == '}' || c == ']')
+        {
+            --depth;
+        }
+        else if (c == ',' && depth == 1)
+        {
+            expectKey = true;
+        }
+        ++i;
+    }
+    return "";
+}
+
+std::string JsonRpc::peekId(const std::string &jsonStr)
+{
     try
     {
-        int numericId = std::stoi(id);
-        response["id"] = numericId;
+        // Discard every top-level member except "id" as soon as it is parsed
+        json id = peekMember(jsonStr, "id");
+        if (id.is_string() || id.is_number())
+            return idString(id);
     }
-    catch (...)
+    catch (const json::exception &e)
     {
-        response["id"] = id; // Keep as string if conversion fails
     }
-
-    return response.dump(); // Single line for MCP compatibility
+    return "";
 }
 
 std::string JsonRpc::createNotification(const std::string &method,
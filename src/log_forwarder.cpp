@@ -0,0 +1,203 @@
+#include "log_forwarder.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "mcp_logger.h"
+
+namespace {
+
+// Set on the forwarder thread so records logged while sending are ignored
+thread_local bool tlsForwarding = false;
+
+const std::pair<const char *, spdlog::level::level_enum> kMcpLevels[] = {
+    {"debug", spdlog::level::debug},     {"info", spdlog::level::info},
+    {"notice", spdlog::level::info},     {"warning", spdlog::level::warn},
+    {"error", spdlog::level::err},       {"critical", spdlog::level::critical},
+    {"alert", spdlog::level::critical},  {"emergency", spdlog::level::critical}};
+
+}  // namespace
+
+LogForwarder::LogForwarder(Sender sender, const LogForwarderOptions &options)
+    : sender_(std::move(sender)),
+      options_(options),
+      tokens_(options.burst),
+      lastRefill_(std::chrono::steady_clock::now()) {
+  thread_ = std::thread([this] { run(); });
+}
+
+LogForwarder::~LogForwarder() { stop(); }
+
+void LogForwarder::attach(
+    const std::shared_ptr<spdlog::logger> &logger,
+    const std::shared_ptr<spdlog::sinks::dist_sink_mt> &hub) {
+  {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    if (stopping_) return;
+    baseLevel_ = logger->level();
+    logger_ = logger;
+    hub_ = hub;
+    if (clientLevel_ < baseLevel_) {
+      logger->set_level(
+          static_cast<spdlog::level::level_enum>(clientLevel_.load()));
+    }
+  }
+  hub->add_sink(shared_from_this());
+}
+
+bool LogForwarder::setLevel(const std::string &mcpLevel) {
+  for (const auto &[name, level] : kMcpLevels) {
+    if (mcpLevel != name) continue;
+    clientLevel_ = level;
+    // Let records below the file/console level through to this sink only
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    if (auto logger = logger_.lock()) {
+      logger->set_level(std::min(baseLevel_, level));
+    }
+    return true;
+  }
+  return false;
+}
+
+std::string LogForwarder::level() const {
+  return toMcpLevel(static_cast<spdlog::level::level_enum>(clientLevel_.load()));
+}
+
+std::string LogForwarder::toMcpLevel(spdlog::level::level_enum level) {
+  switch (level) {
+    case spdlog::level::trace:
+    case spdlog::level::debug:
+      return "debug";
+    case spdlog::level::info:
+      return "info";
+    case spdlog::level::warn:
+      return "warning";
+    case spdlog::level::err:
+      return "error";
+    default:
+      return "critical";
+  }
+}
+
+bool LogForwarder::takeToken() {
+  auto now = std::chrono::steady_clock::now();
+  double elapsed = std::chrono::duration<double>(now - lastRefill_).count();
+  lastRefill_ = now;
+  tokens_ = std::min(options_.burst, tokens_ + elapsed * options_.ratePerSecond);
+  if (tokens_ < 1.0) return false;
+  tokens_ -= 1.0;
+  return true;
+}
+
+void LogForwarder::sink_it_(const spdlog::details::log_msg &msg) {
+  if (tlsForwarding || msg.level < clientLevel_ ||
+      msg.level == spdlog::level::off ||
+      msg.logger_name == McpLogging::kPayloadLoggerName) {
+    return;
+  }
+  if (!takeToken()) {
+    ++droppedRate_;
+    return;
+  }
+
+  size_t length = std::min(msg.payload.size(), options_.maxMessageBytes);
+  // Do not cut a multi-byte UTF-8 sequence in half
+  while (length > 0 && length < msg.payload.size() &&
+         (static_cast<unsigned char>(msg.payload[length]) & 0xc0) == 0x80) {
+    --length;
+  }
+  Record record{msg.level,
+                std::string(msg.logger_name.begin(), msg.logger_name.end()),
+                std::string(msg.payload.begin(), msg.payload.begin() + length)};
+  {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    if (stopping_) return;
+    if (queue_.size() >= options_.queueCapacity) {
+      ++droppedQueue_;
+      return;
+    }
+    queue_.push_back(std::move(record));
+  }
+  queueCv_.notify_one();
+}
+
+void LogForwarder::run() {
+  using namespace std::chrono;
+  tlsForwarding = true;
+  for (;;) {
+    std::deque<Record> batch;
+    {
+      std::unique_lock<std::mutex> lock(queueMutex_);
+      // Wake periodically so drops are reported even when logging stops
+      queueCv_.wait_for(lock, milliseconds(options_.dropReportIntervalMs),
+                        [this] { return stopping_ || !queue_.empty(); });
+      if (stopping_) return;
+      batch.swap(queue_);
+    }
+
+    for (const auto &record : batch) {
+      json params = {{"level", toMcpLevel(record.level)},
+                     {"data", record.message}};
+      if (!record.logger.empty()) params["logger"] = record.logger;
+      try {
+        sender_(params);
+        ++forwarded_;
+      } catch (const std::exception &) {
+        // e.g. a message that is not valid UTF-8; logging it here would
+        // only be discarded, so just count it
+        ++droppedInvalid_;
+      }
+    }
+
+    uint64_t drops = droppedRate_ + droppedQueue_ + droppedInvalid_;
+    auto now = steady_clock::now();
+    if (drops > reportedDrops_ &&
+        now - lastDropReport_ >= milliseconds(options_.dropReportIntervalMs)) {
+      try {
+        sender_({{"level", "warning"},
+                 {"logger", "log_forwarder"},
+                 {"data", std::to_string(drops - reportedDrops_) +
+                              " log messages dropped"}});
+      } catch (const std::exception &) {
+        // Reported again with the next drops; the thread must survive
+      }
+      reportedDrops_ = drops;
+      lastDropReport_ = now;
+    }
+  }
+}
+
+void LogForwarder::stop() {
+  std::shared_ptr<spdlog::logger> logger;
+  std::shared_ptr<spdlog::sinks::dist_sink_mt> hub;
+  {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    if (stopping_) return;
+    stopping_ = true;
+    queue_.clear();
+    logger = logger_.lock();
+    hub = hub_.lock();
+    logger_.reset();
+    hub_.reset();
+  }
+  // From the destructor there is no shared owner left, and so no hub
+  // holding this sink either
+  if (auto self = weak_from_this().lock(); self && hub) hub->remove_sink(self);
+  if (logger) logger->set_level(baseLevel_);
+  queueCv_.notify_all();
+  if (thread_.joinable()) thread_.join();
+}
+
+json LogForwarder::stats() const {
+  size_t queued;
+  {
+    std::lock_guard<std::mutex> lock(queueMutex_);
+    queued = queue_.size();
+  }
+  return {{"level", level()},
+          {"forwarded", forwarded_.load()},
+          {"queued", queued},
+          {"droppedRateLimited", droppedRate_.load()},
+          {"droppedQueueFull", droppedQueue_.load()},
+          {"droppedInvalid", droppedInvalid_.load()}};
+}
@@ -15,17 +15,20 @@
 //   - All logs are flushed immediately for real-time debugging.
 //
 // See also: 'bridge_stdio.log' for raw stdio bridge logs.
+#include <algorithm>
 #include <cstdlib>
 #include <iostream>
 #include <string>
 #include <thread>
+#include <vector>
 
-#include "json_rpc.h"
 #include "mcp_logger.h"
 #include "mcp_server.h"
+#include "shm_adapter.h"
 #include "stdio_adapter.h"
 // #include "tcp_server_adapter.h" // Removed TCP support
 #include "transport_adapter.h"
+#include "uring_adapter.h"
 
 int main(int argc, char* argv[]) {
   try {
@@ -36,6 +39,24 @@ int main(int argc, char* argv[]) {
     std::string log_level_str = "info";
     std::string log_file = "C:/Development/MCP/mcp_server.log";
     bool also_console = true;
+    std::string plugin_dir;
+    std::string transport = "stdio";
+    std::string shm_name;  // empty = unique per server process
+    size_t shm_max_message = ShmRing::kDefaultMaxMessage;
+    std::vector<std::string> resource_dirs;
+    WorkerPoolOptions worker_options;
+    worker_options.workers = 0;  // pool disabled unless --worker-pool is given
+    std::vector<std::string> isolated_tools;
+    size_t max_in_flight = 0;
+    size_t max_queued = 0;
+    size_t memory_budget = 0;  // per request, 0 = unlimited
+    std::vector<std::pair<std::string, size_t>> tool_memory_budgets;
+    size_t worker_threads = std::max(2u, std::thread::hardware_concurrency());
+    size_t io_threads = 2;
+    size_t spill_threshold = 0;  // bytes; 0 (default) disables spilling
+    uint64_t spill_max_bytes = uint64_t{1024} << 20;
+    LogForwarderOptions client_log_options;
+    std::string spill_dir;  // empty = private per-instance directory
 
     // Allow log level and file to be set via environment or args
     if (const char* env_log = std::getenv("MCP_LOG_LEVEL")) {
@@ -44,12 +65,62 @@ int main(int argc, char* argv[]) {
     if (const char* env_file = std::getenv("MCP_LOG_FILE")) {
       log_file = env_file;
     }
+    if (const char* env_plugins = std::getenv("MCP_PLUGIN_DIR")) {
+      plugin_dir = env_plugins;
+    }
     for (int i = 1; i < argc; ++i) {
       std::string arg = argv[i];
       if (arg == "--log-level" && i + 1 < argc) {
         log_level_str = argv[++i];
       } else if (arg == "--log-file" && i + 1 < argc) {
         log_file = argv[++i];
+      } else if (arg == "--plugin-dir" && i + 1 < argc) {
+        plugin_dir = argv[++i];
+      } else if (arg == "--worker-pool" && i + 1 < argc) {
+        worker_options.workers = std::stoul(argv[++i]);
+      } else if (arg == "--worker-memory-mb" && i + 1 < argc) {
+        worker_options.memoryLimitBytes = std::stoul(argv[++i]) << 20;
+      } else if (arg == "--worker-cpu-seconds" && i + 1 < argc) {
+        worker_options.cpuLimitSeconds = std::stoul(argv[++i]);
+      } else if (arg == "--worker-timeout-ms" && i + 1 < argc) {
+        worker_options.callTimeoutMs = std::stoi(argv[++i]);
+      } else if (arg == "--isolate" && i + 1 < argc) {
+        isolated_tools.push_back(argv[++i]);
+      } else if (arg == "--max-in-flight" && i + 1 < argc) {
+        max_in_flight = std::stoul(argv[++i]);
+      } else if (arg == "--max-queued" && i + 1 < argc) {
+        max_queued = std::stoul(argv[++i]);
+      } else if (arg == "--memory-budget-mb" && i + 1 < argc) {
+        memory_budget = std::stoul(argv[++i]) << 20;
+      } else if (arg == "--tool-memory-mb" && i + 1 < argc) {
+        // NAME=MB
+        std::string spec = argv[++i];
+        size_t eq = spec.find('=');
+        if (eq != std::string::npos) {
+          tool_memory_budgets.emplace_back(
+              spec.substr(0, eq), std::stoul(spec.substr(eq + 1)) << 20);
+        }
+      } else if (arg == "--resource-dir" && i + 1 < argc) {
+        resource_dirs.push_back(argv[++i]);
+      } else if (arg == "--spill-threshold" && i + 1 < argc) {
+        spill_threshold = std::stoul(argv[++i]);
+      } else if (arg == "--spill-dir" && i + 1 < argc) {
+        spill_dir = argv[++i];
+      } else if (arg == "--spill-max-mb" && i + 1 < argc) {
+        spill_max_bytes = uint64_t{std::stoul(argv[++i])} << 20;
+      } else if (arg == "--client-log-rate" && i + 1 < argc) {
+        client_log_options.ratePerSecond = std::stod(argv[++i]);
+        client_log_options.burst = 2 * client_log_options.ratePerSecond;
+      } else if (arg == "--io-threads" && i + 1 < argc) {
+        io_threads = std::stoul(argv[++i]);
+      } else if (arg == "--transport" && i + 1 < argc) {
+        transport = argv[++i];
+      } else if (arg == "--shm-name" && i + 1 < argc) {
+        shm_name = argv[++i];
+      } else if (arg == "--shm-max-message-mb" && i + 1 < argc) {
+        shm_max_message = size_t{std::stoul(argv[++i])} << 20;
+      } else if (arg == "--threads" && i + 1 < argc) {
+        worker_threads = std::stoul(argv[++i]);
       } else if (arg == "--no-console-log") {
         also_console = false;
       }
@@ -78,41 +149,67 @@ int main(int argc, char* argv[]) {
 
     // Initialize server
     server.initialize();
+    server.setConcurrencyLimits(max_in_flight, max_queued);
+    server.setMemoryBudget(memory_budget);
+    for (const auto& dir : resource_dirs) {
+      server.addResourceRoot(dir);
+    }
+    if (spill_threshold > 0) {
+      server.enableResultSpill(spill_dir, spill_threshold, spill_max_bytes);
+    }
+
+    // Tool plugins register from their manifests; libraries load on first use
+    if (!plugin_dir.empty()) {
+      server.loadPlugins(plugin_dir);
+    }
+
+    for (const auto& [name, bytes] : tool_memory_budgets) {
+      if (!server.setToolMemoryBudget(name, bytes)) {
+        spdlog::warn("Cannot set memory budget of unknown tool: " + name);
+      }
+    }
+
+    // Fork the worker pool last so workers inherit every registered tool
+    for (const auto& name : isolated_tools) {
+      if (!server.setToolIsolated(name, true)) {
+        spdlog::warn("Cannot isolate unknown tool: " + name);
+      }
+    }
+    if (worker_options.workers > 0) {
+      server.enableWorkerPool(worker_options);
+    }
 
     spdlog::info("Server initialized, starting main communication loop");
 
     // Adapter selection logic
-    // Only support stdio transport
+    // stdio and uring speak newline-delimited JSON-RPC on stdin/stdout; shm
+    // serves one co-located ShmClient through a shared-memory segment
     std::unique_ptr<ITransportAdapter> adapter;
-    spdlog::info("Using StdioAdapter (stdio-only mode)");
-    adapter = std::make_unique<StdioAdapter>();
-
-    std::string message;
-    int requestCount = 0;
-
-    while (adapter->readMessage(message)) {
-      requestCount++;
-      spdlog::debug("Received request #" + std::to_string(requestCount) + ": " +
-                    message);
-
-      if (!message.empty()) {
-        std::string response;
-        server.processRequest(message, response);
-
-        if (!response.empty()) {
-          spdlog::debug("Sending response #" + std::to_string(requestCount) +
-                        ": " + response);
-          adapter->writeMessage(response);
-        } else {
-          spdlog::warn("Empty response generated for request #" +
-                       std::to_string(requestCount));
-        }
+    if (transport == "shm") {
+      auto shm = std::make_unique<ShmAdapter>(
+          shm_name, ShmAdapter::kDefaultRingCapacity, shm_max_message);
+      spdlog::info("Using ShmAdapter (segment " + shm->name() + ")");
+      adapter = std::move(shm);
+    } else if (transport == "uring") {
+      auto uring = std::make_unique<UringAdapter>(0, 1);
+      if (uring->usingUring()) {
+        spdlog::info("Using UringAdapter (io_uring on stdio)");
+        adapter = std::move(uring);
       } else {
-        spdlog::debug("Received empty message, ignoring");
+        spdlog::warn("io_uring unavailable, falling back to StdioAdapter");
       }
+    } else if (transport != "stdio") {
+      spdlog::warn("Unknown transport '" + transport + "', using stdio");
+    }
+    if (!adapter) {
+      spdlog::info("Using StdioAdapter (stdio-only mode)");
+      adapter = std::make_unique<StdioAdapter>();
     }
 
-    spdlog::info("Main loop ended - stdin closed");
+    server.enableLogForwarding(client_log_options);
+    server.setIoThreads(io_threads);
+    server.serve(*adapter, worker_threads);
+    spdlog::info("Main loop ended - input closed");
   } catch (const std::exception& e) {
     spdlog::error(std::string("Exception in main: ") + e.what());
     std::cerr << "Error: " << e.what() << std::endl;
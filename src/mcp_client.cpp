@@ -0,0 +1,62 @@
+#include "mcp_client.h"
+
+#include "mcp_server.h"
+
+McpClient::McpClient(McpServer &server) : server_(server) {}
+
+std::vector<McpTool> McpClient::listTools() const {
+  auto snapshot = server_.getToolSnapshot();
+  std::vector<McpTool> tools;
+  tools.reserve(snapshot->entries.size());
+  for (const auto &[name, entry] : snapshot->entries) {
+    tools.push_back(entry->tool);
+  }
+  return tools;
+}
+
+json McpClient::callTool(const std::string &name, const json &arguments) const {
+  // The snapshot keeps the handler alive even if the tool is replaced
+  auto snapshot = server_.getToolSnapshot();
+  const ToolEntry *entry = snapshot->find(name);
+  if (!entry) throw McpError(-32601, "Tool not found: " + name);
+  try {
+    return server_.invokeTool(*entry, arguments);
+  } catch (const ServerBusyError &e) {
+    throw McpError(kServerBusyError, e.what());
+  }
+}
+
+json McpClient::callToolResult(const std::string &name,
+                               const json &arguments) const {
+  return server_.buildCallResult(callTool(name, arguments));
+}
+
+json McpClient::listResources(const std::string &cursor) const {
+  try {
+    return server_.getResourceManager().list(cursor);
+  } catch (const std::exception &e) {
+    throw McpError(-32602, e.what());
+  }
+}
+
+json McpClient::readResource(const std::string &uri, uint64_t offset,
+                             size_t length) const {
+  try {
+    return server_.getResourceManager().read(uri, offset, length);
+  } catch (const std::exception &e) {
+    throw McpError(-32002, e.what());
+  }
+}
+
+json McpClient::listPrompts() const {
+  return server_.getPromptRegistry().list();
+}
+
+json McpClient::getPrompt(const std::string &name,
+                          const json &arguments) const {
+  try {
+    return server_.getPromptRegistry().get(name, arguments);
+  } catch (const std::exception &e) {
+    throw McpError(-32602, e.what());
+  }
+}
@@ -1,17 +1,27 @@
 #include "mcp_server.h"
 
+#include <algorithm>
 #include <ctime>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <sstream>
+#include <optional>
 #include <stdexcept>
 
 #include "handlers/call_tool_handler.h"
 #include "handlers/initialize_handler.h"
 #include "handlers/list_tools_handler.h"
 #include "handlers/ping_handler.h"
+#include "io_executor.h"
 #include "json_rpc.h"
 #include "mcp_logger.h"
+#include "plugin_manager.h"
+#include "request_scheduler.h"
+#include "resource_watcher.h"
+#include "tool_content.h"
+#include "tool_pipeline.h"
+#include "transport_adapter.h"
 
 McpServer::McpServer(const std::string &name, const std::string &version)
     : running_(false) {
@@ -20,19 +30,31 @@ McpServer::McpServer(const std::string &name, const std::string &version)
   serverInfo_.capabilities.tools = true;
   serverInfo_.capabilities.resources = false;
   serverInfo_.capabilities.prompts = false;
-  serverInfo_.capabilities.logging = true;
+  serverInfo_.capabilities.logging = false;
 
   jsonRpc_ = std::make_unique<JsonRpc>();
+  admission_ = std::make_unique<AdmissionController>();
+  resources_ = std::make_unique<ResourceManager>();
+  prompts_ = std::make_unique<PromptRegistry>();
+  methodMemory_ = std::make_unique<MemoryUsageStats>();
+  toolMemory_ = std::make_unique<MemoryUsageStats>();
 }
 
-McpServer::~McpServer() { stop(); }
+McpServer::~McpServer() {
+  stop();
+  // Takes the sink out of the default logger and restores its level
+  if (logForwarder_) logForwarder_->stop();
+  // Stop the watcher thread before the members its callback uses go away
+  resourceWatcher_.reset();
+}
 
 void McpServer::initialize() {
   spdlog::info("Initializing MCP server: " + serverInfo_.name + " v" +
                serverInfo_.version);
   setupDefaultTools();
+  setupDefaultPrompts();
   spdlog::info("Server initialization complete. Tools registered: " +
-               std::to_string(tools_.size()));
+               std::to_string(getToolSnapshot()->entries.size()));
 }
 
 void McpServer::start() {
@@ -44,33 +66,132 @@ void McpServer::stop() { running_ = false; }
 
 // Global request history buffer (file scope)
 static std::vector<std::string> requestHistory;
+static std::mutex requestHistoryMutex;
 
-void McpServer::processRequest(const std::string &request,
-                               std::string &response) {
-  spdlog::debug("Processing request: " + request.substr(0, 100) +
-                (request.length() > 100 ? "..." : ""));
+static void recordRequest(const std::string &request) {
+  McpLogging::payload_logger()->debug(
+      "Processing request: " + request.substr(0, 100) +
+      (request.length() > 100 ? "..." : ""));
 
   // Store request in history (keep last 10)
-  requestHistory.push_back(request);
-  if (requestHistory.size() > 10) requestHistory.erase(requestHistory.begin());
+  {
+    std::lock_guard<std::mutex> lock(requestHistoryMutex);
+    requestHistory.push_back(request);
+    if (requestHistory.size() > 10)
+      requestHistory.erase(requestHistory.begin());
+  }
 
   // Log incoming request to file
-  spdlog::info("[IN] " + request);
+  McpLogging::payload_logger()->info("[IN] " + request);
+}
+
+// Upper bound on remembered cancellations (ids of requests that never arrive
+// or already finished would otherwise accumulate)
+static constexpr size_t kMaxCancelledRequests = 1024;
 
+bool McpServer::isControlMethod(const std::string &method) {
+  return method == "ping" || method == "initialize" ||
+         method == "tools/list" || method == "logging/setLevel" ||
+         method.rfind("notifications/", 0) == 0;
+}
+
+void McpServer::processRequest(const std::string &request,
+                               std::string &response) {
+  runAccounted(request, jsonRpc_->peekMethod(request), response,
+               [&] { dispatchRequest(request, response, nullptr); });
+}
+
+void McpServer::runAccounted(const std::string &request,
+                             const std::string &method, std::string &response,
+                             const std::function<void()> &handle) {
+  size_t peakBytes = 0;
+  bool exceeded = false;
+  std::string budgetError;
+  {
+    MemoryScope scope(memoryBudget_, ("request " + method).c_str());
+    try {
+      handle();
+    } catch (const MemoryBudgetExceeded &e) {
+      // Also thrown for a tool's own budget outside its error handling
+      budgetError = e.message();
+    } catch (const std::exception &e) {
+      failRequest(request, method, e.what(), response);
+    } catch (...) {
+      failRequest(request, method, "Unknown error", response);
+    }
+    peakBytes = scope.peakBytes();
+    exceeded = scope.exceeded();
+    if (exceeded && budgetError.empty()) {
+      budgetError = MemoryBudgetExceeded(scope.handle()).message();
+    }
+  }
+
+  if (!budgetError.empty()) {
+    spdlog::warn(budgetError);
+    if (method.rfind("notifications/", 0) == 0) {
+      response.clear();
+    } else {
+      response = jsonRpc_->createErrorResponse(jsonRpc_->peekId(request),
+                                               kMemoryBudgetError, budgetError);
+      McpLogging::payload_logger()->info("[OUT] " + response);
+    }
+  }
+  methodMemory_->record(method.empty() ? "(unknown)" : method, peakBytes,
+                        exceeded);
+}
+
+void McpServer::failRequest(const std::string &request,
+                            const std::string &method,
+                            const std::string &what, std::string &response) {
+  // Every request gets an answer, or the client waits on its id forever
+  spdlog::error("Request failed: " + method + " - " + what);
+  if (method.rfind("notifications/", 0) == 0) {
+    response.clear();
+    return;
+  }
+  response = jsonRpc_->createErrorResponse(jsonRpc_->peekId(request), -32603,
+                                           "Internal error: " + what);
+  McpLogging::payload_logger()->info("[OUT] " + response);
+}
+
+bool McpServer::dispatchRequest(const std::string &request,
+                                std::string &response, ResponseCallback *done) {
+  recordRequest(request);
+
+  // The only full parse of the request; handlers get its pieces
   std::string method, id;
   json params;
+  bool started = false;
 
   if (jsonRpc_->parseRequest(request, method, params, id)) {
     spdlog::info("Parsed request - Method: " + method + ", ID: " + id);
 
-    if (method == "initialize") {
+    if (method.rfind("notifications/", 0) == 0) {
+      handleNotification(method, params);
+    } else if (takeCancelled(id)) {
+      spdlog::info("Skipping cancelled request: " + id);
+    } else if (method == "initialize") {
       handleInitialize(request, response);
     } else if (method == "tools/list") {
       handleListTools(request, response);
     } else if (method == "tools/call") {
-      handleCallTool(request, response);
+      started = callTool(id, params, response, done);
     } else if (method == "ping") {
       handlePing(request, response);
+    } else if (method == "resources/list") {
+      handleListResources(request, response);
+    } else if (method == "resources/read") {
+      handleReadResource(request, response);
+    } else if (method == "resources/subscribe") {
+      handleSubscribeResource(request, response);
+    } else if (method == "resources/unsubscribe") {
+      handleUnsubscribeResource(request, response);
+    } else if (method == "prompts/list") {
+      handleListPrompts(request, response);
+    } else if (method == "prompts/get") {
+      handleGetPrompt(request, response);
+    } else if (method == "logging/setLevel") {
+      handleSetLogLevel(request, response);
     } else {
       spdlog::warn("Unknown method: " + method);
       response = jsonRpc_->createErrorResponse(id, -32601,
@@ -81,8 +202,283 @@ void McpServer::processRequest(const std::string &request,
     response = jsonRpc_->createErrorResponse("", -32700, "Parse error");
   }
 
-  // Log outgoing response to file
-  spdlog::info("[OUT] " + response);
+  // Log outgoing response to file (calls still running log their own)
+  if (!started) McpLogging::payload_logger()->info("[OUT] " + response);
+  return started;
+}
+
+void McpServer::serve(ITransportAdapter &transport, size_t threads) {
+  // Responses may be written out of order, which JSON-RPC allows
+  std::mutex writeMutex;
+  auto send = [&](const std::string &message) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    transport.writeMessage(message);
+  };
+  setNotificationSink(send);
+  running_ = true;
+
+  {
+    RequestScheduler scheduler(threads);
+    {
+      std::lock_guard<std::mutex> lock(schedulerMutex_);
+      scheduler_ = &scheduler;
+    }
+    // Calls queued by admission control give their worker back (see
+    // startQueuedCall); those that still block, such as pipeline steps,
+    // must leave at least one worker for everything else
+    admission_->setBlockingWaitLimit(scheduler.workerCount() - 1);
+    std::string message;
+    int requestCount = 0;
+
+    while (transport.readMessage(message)) {
+      requestCount++;
+      McpLogging::payload_logger()->debug(
+          "Received request #" + std::to_string(requestCount) + ": " + message);
+
+      if (message.empty()) {
+        spdlog::debug("Received empty message, ignoring");
+        continue;
+      }
+      std::string method = jsonRpc_->peekMethod(message);
+      auto lane = isControlMethod(method) ? RequestScheduler::Lane::Control
+                                          : RequestScheduler::Lane::Work;
+      int requestNumber = requestCount;
+      scheduler.submit(lane, [this, &send, message, method, requestNumber] {
+        // Async tool calls free this worker while they wait
+        answerRequest(message, method, [&send, requestNumber](
+                                           const std::string &response) {
+          if (!response.empty()) {
+            McpLogging::payload_logger()->debug(
+                "Sending response #" + std::to_string(requestNumber) + ": " +
+                response);
+            send(response);
+          } else {
+            spdlog::debug("No response for request #" +
+                          std::to_string(requestNumber));
+          }
+        });
+      });
+    }
+
+    // Finish whatever is still queued or suspended before returning. Calls
+    // admitted from here on run on the thread that freed their slot.
+    {
+      std::lock_guard<std::mutex> lock(schedulerMutex_);
+      scheduler_ = nullptr;
+    }
+    scheduler.shutdown();
+    waitForAsyncCalls();
+    admission_->setBlockingWaitLimit(std::numeric_limits<size_t>::max());
+  }
+
+  setNotificationSink(nullptr);
+  running_ = false;
+}
+
+void McpServer::processRequestAsync(const std::string &request,
+                                    ResponseCallback done) {
+  answerRequest(request, jsonRpc_->peekMethod(request), std::move(done));
+}
+
+void McpServer::answerRequest(const std::string &request,
+                              const std::string &method,
+                              ResponseCallback done) {
+  // Only calls to async tools leave this thread; everything else, including
+  // synchronous tools, is answered before returning. An async call's
+  // coroutine stays charged to the request wherever it is resumed.
+  std::string response;
+  bool started = false;
+  runAccounted(request, method, response,
+               [&] { started = dispatchRequest(request, response, &done); });
+  if (!started) done(response);
+}
+
+void McpServer::startAsyncCall(std::shared_ptr<const ToolEntry> entry,
+                               json arguments, const std::string &id,
+                               ResponseCallback done) {
+  const std::string &name = entry->tool.name;
+  spdlog::info("Calling async tool: " + name);
+
+  {
+    std::lock_guard<std::mutex> lock(asyncMutex_);
+    ++asyncInFlight_;
+  }
+  // The entry keeps the handler (and anything its lambda captured) alive
+  // across suspensions. The coroutine carries the tool's memory scope
+  // (inside the request's) to every thread that resumes it.
+  MemoryScope scope(entry->tool.memoryBudget, ("tool " + name).c_str());
+  auto finish = [this, entry, id, memory = scope.handle(),
+                 done = std::move(done)](json result,
+                                         std::exception_ptr error) {
+    MemoryScope::Attach attach(memory);
+    std::string response = toolCallResponse(id, entry->tool.name, [&] {
+      if (error) std::rethrow_exception(error);
+      MemoryScope::checkpoint();
+      return std::move(result);
+    });
+    toolMemory_->record(entry->tool.name, memory.peakBytes(),
+                        memory.exceeded());
+    McpLogging::payload_logger()->info("[OUT] " + response);
+    done(response);
+
+    std::lock_guard<std::mutex> lock(asyncMutex_);
+    if (--asyncInFlight_ == 0 && queuedCalls_ == 0) asyncIdle_.notify_all();
+  };
+
+  std::optional<ToolTask> task;
+  try {
+    task.emplace(admitAndRun(entry, std::move(arguments)));
+  } catch (...) {
+    finish(json(), std::current_exception());
+    return;
+  }
+  std::move(*task).start(std::move(finish));
+}
+
+ToolTask McpServer::admitAndRun(std::shared_ptr<const ToolEntry> entry,
+                                json arguments) {
+  // A queued call waits suspended and is resumed on an executor thread, so
+  // it holds no scheduler worker. The ticket is released when the handler
+  // returns, before the response is built.
+  AdmissionController::Ticket ticket = co_await admission_->admitAsync(
+      entry->tool.name, limitsFor(entry->tool),
+      [this](std::coroutine_handle<> handle) { getIoExecutor().post(handle); });
+  co_return co_await entry->asyncHandler(std::move(arguments));
+}
+
+void McpServer::waitForAsyncCalls() {
+  std::unique_lock<std::mutex> lock(asyncMutex_);
+  asyncIdle_.wait(lock,
+                  [this] { return asyncInFlight_ == 0 && queuedCalls_ == 0; });
+}
+
+bool McpServer::startQueuedCall(std::shared_ptr<const ToolEntry> entry,
+                                json &arguments, const std::string &id,
+                                ResponseCallback &done, std::string &response) {
+  // Everything the call needs once admitted. The continuation may run on
+  // another thread before tryAdmit() even returns, so it owns 'done' from
+  // the start and gives it back only if the call is admitted right away.
+  struct Parked {
+    std::shared_ptr<const ToolEntry> entry;
+    json arguments;
+    std::string id;
+    ResponseCallback done;
+    MemoryScope::Handle memory;
+  };
+  auto parked = std::make_shared<Parked>();
+  parked->entry = std::move(entry);
+  parked->arguments = std::move(arguments);
+  parked->id = id;
+  parked->done = std::move(done);
+  parked->memory = MemoryScope::current();
+  const std::string &name = parked->entry->tool.name;
+
+  auto resume = [this, parked](AdmissionController::Ticket ticket) {
+    auto held =
+        std::make_shared<AdmissionController::Ticket>(std::move(ticket));
+    resubmit([this, parked, held] {
+      // Still the request's memory scope, on whichever worker this runs
+      MemoryScope::Attach attach(parked->memory);
+      std::string response =
+          toolCallResponse(parked->id, parked->entry->tool.name, [&] {
+            AdmissionController::Ticket ticket = std::move(*held);
+            return runTool(*parked->entry, parked->arguments);
+          });
+      McpLogging::payload_logger()->info("[OUT] " + response);
+      parked->done(response);
+
+      std::lock_guard<std::mutex> lock(asyncMutex_);
+      if (--queuedCalls_ == 0 && asyncInFlight_ == 0) asyncIdle_.notify_all();
+    });
+  };
+
+  AdmissionController::Ticket ticket;
+  std::exception_ptr error;
+  {
+    // Counted before parking, so waitForAsyncCalls() cannot miss the call
+    std::lock_guard<std::mutex> lock(asyncMutex_);
+    ++queuedCalls_;
+  }
+  try {
+    // Safe point: don't start another tool once the request is over budget
+    MemoryScope::checkpoint();
+    if (!admission_->tryAdmit(name, limitsFor(parked->entry->tool), ticket,
+                              std::move(resume))) {
+      spdlog::info("Tool call queued: " + name);
+      return true;
+    }
+  } catch (...) {
+    error = std::current_exception();
+  }
+  {
+    std::lock_guard<std::mutex> lock(asyncMutex_);
+    if (--queuedCalls_ == 0 && asyncInFlight_ == 0) asyncIdle_.notify_all();
+  }
+
+  done = std::move(parked->done);
+  response = toolCallResponse(parked->id, name, [&] {
+    if (error) std::rethrow_exception(error);
+    AdmissionController::Ticket held = std::move(ticket);
+    return runTool(*parked->entry, parked->arguments);
+  });
+  return false;
+}
+
+bool McpServer::canResubmit() {
+  std::lock_guard<std::mutex> lock(schedulerMutex_);
+  return scheduler_ != nullptr;
+}
+
+void McpServer::resubmit(std::function<void()> task) {
+  {
+    std::lock_guard<std::mutex> lock(schedulerMutex_);
+    if (scheduler_) {
+      scheduler_->submit(RequestScheduler::Lane::Work, std::move(task));
+      return;
+    }
+  }
+  // serve() is finishing: run it here rather than lose it
+  task();
+}
+
+bool McpServer::submitWork(std::function<void()> task) {
+  std::lock_guard<std::mutex> lock(schedulerMutex_);
+  if (!scheduler_) return false;
+  scheduler_->submit(RequestScheduler::Lane::Work, std::move(task));
+  return true;
+}
+
+IoExecutor &McpServer::getIoExecutor() {
+  std::call_once(ioExecutorOnce_, [this] {
+    ioExecutor_ = std::make_unique<IoExecutor>(ioThreads_);
+  });
+  return *ioExecutor_;
+}
+
+void McpServer::handleNotification(const std::string &method,
+                                   const json &params) {
+  if (method == "notifications/cancelled" && params.contains("requestId")) {
+    const json &requestId = params["requestId"];
+    if (!requestId.is_number() && !requestId.is_string()) {
+      spdlog::warn("Ignoring cancellation with invalid requestId: " +
+                   requestId.dump());
+      return;
+    }
+    std::string id = JsonRpc::idString(requestId);
+    std::lock_guard<std::mutex> lock(cancelledMutex_);
+    if (cancelledRequests_.size() >= kMaxCancelledRequests) {
+      cancelledRequests_.clear();
+    }
+    cancelledRequests_.insert(id);
+    spdlog::info("Request cancelled by client: " + id);
+  } else {
+    spdlog::debug("Notification received: " + method);
+  }
+}
+
+bool McpServer::takeCancelled(const std::string &id) {
+  std::lock_guard<std::mutex> lock(cancelledMutex_);
+  return cancelledRequests_.erase(id) > 0;
 }
 
 void McpServer::handleInitialize(const std::string &request,
@@ -101,6 +497,13 @@ void McpServer::handleInitialize(const std::string &request,
         {"capabilities",
          {{"tools", serverInfo_.capabilities.tools},
           {"logging", serverInfo_.capabilities.logging}}}};
+    if (serverInfo_.capabilities.resources) {
+      result["capabilities"]["resources"] = {{"subscribe", true},
+                                             {"listChanged", false}};
+    }
+    if (serverInfo_.capabilities.prompts) {
+      result["capabilities"]["prompts"] = {{"listChanged", false}};
+    }
 
     response = jsonRpc_->createResponse(id, result);
     spdlog::info("Initialize response created successfully");
@@ -118,7 +521,9 @@ void McpServer::handleListTools(const std::string &request,
   if (jsonRpc_->parseRequest(request, method, params, id)) {
     json toolsArray = json::array();
 
-    for (const auto &[name, tool] : tools_) {
+    auto snapshot = getToolSnapshot();
+    for (const auto &[name, entry] : snapshot->entries) {
+      const McpTool &tool = entry->tool;
       json toolObj = {{"name", tool.name},
                       {"description", tool.description},
                       {"inputSchema", tool.inputSchema}};
@@ -135,51 +540,188 @@ void McpServer::handleListTools(const std::string &request,
 
 void McpServer::handleCallTool(const std::string &request,
                                std::string &response) {
-  spdlog::info("Handling tools/call request");
-
   std::string method, id;
   json params;
 
   if (jsonRpc_->parseRequest(request, method, params, id)) {
-    std::string toolName = params["name"];
-    json arguments =
-        params.contains("arguments") ? params["arguments"] : json::object();
-
-    spdlog::info("Tool call request - name: " + toolName +
-                 ", arguments: " + arguments.dump());
-
-    if (toolHandlers_.find(toolName) != toolHandlers_.end()) {
-      try {
-        spdlog::info("Calling tool: " + toolName);
-        json result = toolHandlers_[toolName](arguments);
-
-        // Format result according to MCP specification
-        // content should be an array of content objects
-        json contentArray = json::array();
-        json textContent = {
-            {"type", "text"},
-            {"text",
-             result.is_string() ? result.get<std::string>() : result.dump()}};
-        contentArray.push_back(textContent);
-
-        json resultObj = {{"content", contentArray}};
-        response = jsonRpc_->createResponse(id, resultObj);
-        spdlog::info("Tool call completed successfully: " + toolName);
-      } catch (const std::exception &e) {
-        spdlog::error("Tool call failed: " + toolName + " - " + e.what());
-        response = jsonRpc_->createErrorResponse(id, -32603, e.what());
-      }
-    } else {
-      spdlog::error("Tool not found: " + toolName);
-      response = jsonRpc_->createErrorResponse(id, -32601,
-                                               "Tool not found: " + toolName);
-    }
+    callTool(id, params, response, nullptr);
   } else {
     spdlog::error("Failed to parse tools/call request");
     response = jsonRpc_->createErrorResponse(id, -32700, "Parse error");
   }
 }
 
+void McpServer::handleCallTool(const std::string &id, json params,
+                               std::string &response) {
+  callTool(id, params, response, nullptr);
+}
+
+bool McpServer::callTool(const std::string &id, json &params,
+                         std::string &response, ResponseCallback *done) {
+  spdlog::info("Handling tools/call request");
+
+  // Checked once, before synchronous and async calls go separate ways
+  if (!params.is_object() || !params.contains("name") ||
+      !params["name"].is_string() ||
+      (params.contains("arguments") && !params["arguments"].is_object())) {
+    spdlog::warn("Invalid tools/call params");
+    response = jsonRpc_->createErrorResponse(
+        id, -32602,
+        "Invalid params: 'name' must be a string and 'arguments' an object");
+    return false;
+  }
+  std::string toolName = params["name"];
+  json arguments = params.contains("arguments")
+                       ? std::move(params["arguments"])
+                       : json::object();
+
+  McpLogging::payload_logger()->info("Tool call request - name: " + toolName +
+                                     ", arguments: " + arguments.dump());
+
+  // Hold the entry for the whole call so the handler stays valid even if
+  // the tool is replaced or removed concurrently
+  std::shared_ptr<const ToolEntry> entry;
+  {
+    auto snapshot = getToolSnapshot();
+    auto it = snapshot->entries.find(toolName);
+    if (it != snapshot->entries.end()) entry = it->second;
+  }
+  if (!entry) {
+    spdlog::error("Tool not found: " + toolName);
+    response =
+        jsonRpc_->createErrorResponse(id, -32601, "Tool not found: " + toolName);
+    return false;
+  }
+
+  if (done && entry->asyncHandler) {
+    startAsyncCall(std::move(entry), std::move(arguments), id,
+                   std::move(*done));
+    return true;
+  }
+
+  spdlog::info("Calling tool: " + toolName);
+  // Under serve(), a call that has to wait for admission gives this worker
+  // back instead of blocking it
+  if (done && canResubmit()) {
+    return startQueuedCall(std::move(entry), arguments, id, *done, response);
+  }
+  response = toolCallResponse(
+      id, toolName, [&] { return invokeTool(*entry, arguments); });
+  return false;
+}
+
+std::string McpServer::toolCallResponse(
+    const std::string &id, const std::string &name,
+    const std::function<json()> &call) const {
+  try {
+    // Format result according to MCP specification
+    // content should be an array of content objects
+    json result = call();
+    std::string response =
+        jsonRpc_->createResponse(id, buildCallResult(std::move(result)));
+    spdlog::info("Tool call completed successfully: " + name);
+    return response;
+  } catch (const ServerBusyError &e) {
+    spdlog::warn("Tool call rejected: " + name + " - " + e.what());
+    return jsonRpc_->createErrorResponse(id, kServerBusyError, e.what());
+  } catch (const MemoryBudgetExceeded &e) {
+    spdlog::warn("Tool call failed: " + name + " - " + e.message());
+    return jsonRpc_->createErrorResponse(id, kMemoryBudgetError, e.message());
+  } catch (const std::exception &e) {
+    spdlog::error("Tool call failed: " + name + " - " + e.what());
+    return jsonRpc_->createErrorResponse(id, -32603, e.what());
+  } catch (...) {
+    spdlog::error("Tool call failed: " + name + " - unknown error");
+    return jsonRpc_->createErrorResponse(id, -32603, "Unknown error");
+  }
+}
+
+json McpServer::buildCallResult(json result) const {
+  if (ToolContent::isResult(result)) {
+    ToolContent::finishResult(result);
+    // Images and audio must arrive inline, but large text and embedded
+    // resources are spilled item by item like plain values
+    if (spill_) {
+      json content = json::array();
+      for (auto &item : result["content"]) spillItem(std::move(item), content);
+      result["content"] = std::move(content);
+    }
+    ToolContent::encodeBinary(result);
+    return result;
+  }
+
+  ToolContent::encodeBinary(result);
+  std::string text = result.is_string()
+                         ? std::move(result.get_ref<std::string &>())
+                         : result.dump();
+
+  json contentArray = json::array();
+  if (!spill_ || text.size() <= spillThreshold_) {
+    contentArray.push_back({{"type", "text"}, {"text", std::move(text)}});
+    return {{"content", contentArray}};
+  }
+
+  // Too large to inline: hand back the URI the client reads in chunks
+  // through 'resources/read', so this response stays small
+  appendSpilled("Result", text, result.is_string() ? ".txt" : ".json",
+                contentArray);
+  return {{"content", contentArray}};
+}
+
+void McpServer::spillItem(json item, json &content) const {
+  const std::string &type = item["type"].get_ref<const std::string &>();
+  if (type == "text") {
+    auto text = item.find("text");
+    if (text != item.end() && text->is_string() &&
+        text->get_ref<const std::string &>().size() > spillThreshold_) {
+      appendSpilled("Text", text->get_ref<const std::string &>(), ".txt",
+                    content);
+      return;
+    }
+  } else if (type == "resource" && item.contains("resource") &&
+             item["resource"].is_object()) {
+    const json &resource = item["resource"];
+    std::string label = "Resource " + resource.value("uri", std::string());
+    std::string extension =
+        ResourceManager::extensionFor(resource.value("mimeType", ""));
+    auto text = resource.find("text");
+    if (text != resource.end() && text->is_string() &&
+        text->get_ref<const std::string &>().size() > spillThreshold_) {
+      appendSpilled(label, text->get_ref<const std::string &>(),
+                    extension == ".bin" ? ".txt" : extension, content);
+      return;
+    }
+    // Raw bytes (ToolContent::blob) are stored as they are, before base64
+    auto blob = resource.find("blob");
+    if (blob != resource.end() && blob->is_binary() &&
+        blob->get_binary().size() > spillThreshold_) {
+      const json::binary_t &bytes = blob->get_binary();
+      appendSpilled(label,
+                    std::string_view(
+                        reinterpret_cast<const char *>(bytes.data()),
+                        bytes.size()),
+                    extension, content);
+      return;
+    }
+  }
+  content.push_back(std::move(item));
+}
+
+void McpServer::appendSpilled(const std::string &label, std::string_view data,
+                              const std::string &extension,
+                              json &content) const {
+  std::string path = spill_->store(data, extension);
+  std::string uri = ResourceManager::uriForPath(path);
+  spdlog::info("Spilled " + std::to_string(data.size()) +
+               " byte tool result to " + path);
+  // Protocol 2024-11-05 has no resource_link content, so the URI travels
+  // in a text note
+  content.push_back(
+      {{"type", "text"},
+       {"text", label + " is " + std::to_string(data.size()) +
+                    " bytes; read it with resources/read from " + uri}});
+}
+
 void McpServer::handlePing(const std::string &request, std::string &response) {
   std::string method, id;
   json params;
@@ -192,13 +734,400 @@ void McpServer::handlePing(const std::string &request, std::string &response) {
   }
 }
 
+void McpServer::handleListResources(const std::string &request,
+                                    std::string &response) {
+  std::string method, id;
+  json params;
+
+  if (jsonRpc_->parseRequest(request, method, params, id)) {
+    try {
+      json result = resources_->list(params.value("cursor", ""));
+      response = jsonRpc_->createResponse(id, result);
+    } catch (const std::exception &e) {
+      response = jsonRpc_->createErrorResponse(id, -32602, e.what());
+    }
+  } else {
+    response = jsonRpc_->createErrorResponse(id, -32700, "Parse error");
+  }
+}
+
+void McpServer::handleReadResource(const std::string &request,
+                                   std::string &response) {
+  std::string method, id;
+  json params;
+
+  if (jsonRpc_->parseRequest(request, method, params, id)) {
+    std::string uri = params.value("uri", "");
+    if (uri.empty()) {
+      response = jsonRpc_->createErrorResponse(id, -32602, "Missing uri");
+      return;
+    }
+    try {
+      json result = resources_->read(uri, params.value("offset", uint64_t{0}),
+                                     params.value("length", size_t{0}));
+      response = jsonRpc_->createResponse(id, result);
+    } catch (const std::exception &e) {
+      spdlog::error("resources/read failed: " + uri + " - " + e.what());
+      response = jsonRpc_->createErrorResponse(id, -32002, e.what());
+    }
+  } else {
+    response = jsonRpc_->createErrorResponse(id, -32700, "Parse error");
+  }
+}
+
+void McpServer::handleListPrompts(const std::string &request,
+                                  std::string &response) {
+  std::string method, id;
+  json params;
+
+  if (jsonRpc_->parseRequest(request, method, params, id)) {
+    response = jsonRpc_->createResponse(id, prompts_->list());
+  } else {
+    response = jsonRpc_->createErrorResponse(id, -32700, "Parse error");
+  }
+}
+
+void McpServer::handleGetPrompt(const std::string &request,
+                                std::string &response) {
+  std::string method, id;
+  json params;
+
+  if (jsonRpc_->parseRequest(request, method, params, id)) {
+    std::string name = params.value("name", "");
+    if (name.empty()) {
+      response = jsonRpc_->createErrorResponse(id, -32602, "Missing name");
+      return;
+    }
+    try {
+      json result =
+          prompts_->get(name, params.value("arguments", json::object()));
+      response = jsonRpc_->createResponse(id, result);
+    } catch (const std::exception &e) {
+      response = jsonRpc_->createErrorResponse(id, -32602, e.what());
+    }
+  } else {
+    response = jsonRpc_->createErrorResponse(id, -32700, "Parse error");
+  }
+}
+
+void McpServer::handleSetLogLevel(const std::string &request,
+                                  std::string &response) {
+  std::string method, id;
+  json params;
+
+  if (jsonRpc_->parseRequest(request, method, params, id)) {
+    std::string level = params.value("level", "");
+    if (!logForwarder_) {
+      response = jsonRpc_->createErrorResponse(id, -32601,
+                                               "Logging is not enabled");
+    } else if (!logForwarder_->setLevel(level)) {
+      response = jsonRpc_->createErrorResponse(id, -32602,
+                                               "Invalid log level: " + level);
+    } else {
+      spdlog::info("Client log level set to " + level);
+      response = jsonRpc_->createResponse(id, json::object());
+    }
+  } else {
+    response = jsonRpc_->createErrorResponse(id, -32700, "Parse error");
+  }
+}
+
+void McpServer::handleSubscribeResource(const std::string &request,
+                                        std::string &response) {
+  std::string method, id;
+  json params;
+
+  if (jsonRpc_->parseRequest(request, method, params, id)) {
+    std::string uri = params.value("uri", "");
+    std::string path = resources_->resolve(uri);
+    if (path.empty()) {
+      response =
+          jsonRpc_->createErrorResponse(id, -32002, "Resource not found: " + uri);
+      return;
+    }
+
+    std::lock_guard<std::mutex> lock(subscriptionsMutex_);
+    if (!resourceWatcher_) {
+      resourceWatcher_ = std::make_unique<ResourceWatcher>(
+          [this](const std::vector<std::string> &paths) {
+            onResourcesChanged(paths);
+          },
+          [this](const std::vector<std::string> &paths) {
+            onResourcesLost(paths);
+          });
+    }
+    if (!resourceWatcher_->watch(path)) {
+      response = jsonRpc_->createErrorResponse(
+          id, -32603, "Cannot watch resource: " + uri);
+      return;
+    }
+    subscriptions_[path] = uri;
+    spdlog::info("Subscribed to resource: " + uri);
+    response = jsonRpc_->createResponse(id, json::object());
+  } else {
+    response = jsonRpc_->createErrorResponse(id, -32700, "Parse error");
+  }
+}
+
+void McpServer::handleUnsubscribeResource(const std::string &request,
+                                          std::string &response) {
+  std::string method, id;
+  json params;
+
+  if (jsonRpc_->parseRequest(request, method, params, id)) {
+    std::string uri = params.value("uri", "");
+    std::string path = resources_->resolve(uri);
+
+    std::lock_guard<std::mutex> lock(subscriptionsMutex_);
+    auto it = path.empty() ? subscriptions_.end() : subscriptions_.find(path);
+    if (it == subscriptions_.end()) {
+      // resolve() fails once the file is deleted; fall back to the URI the
+      // subscription was made with so its watch is still released
+      it = std::find_if(
+          subscriptions_.begin(), subscriptions_.end(),
+          [&uri](const auto &entry) { return entry.second == uri; });
+    }
+    if (it != subscriptions_.end()) {
+      if (resourceWatcher_) resourceWatcher_->unwatch(it->first);
+      subscriptions_.erase(it);
+      spdlog::info("Unsubscribed from resource: " + uri);
+    }
+    response = jsonRpc_->createResponse(id, json::object());
+  } else {
+    response = jsonRpc_->createErrorResponse(id, -32700, "Parse error");
+  }
+}
+
+void McpServer::onResourcesChanged(const std::vector<std::string> &paths) {
+  std::vector<std::string> uris;
+  {
+    std::lock_guard<std::mutex> lock(subscriptionsMutex_);
+    for (const auto &path : paths) {
+      auto it = subscriptions_.find(path);
+      if (it != subscriptions_.end()) uris.push_back(it->second);
+    }
+  }
+  for (const auto &path : paths) resources_->invalidate(path);
+  for (const auto &uri : uris) {
+    sendNotification("notifications/resources/updated", {{"uri", uri}});
+  }
+}
+
+void McpServer::onResourcesLost(const std::vector<std::string> &paths) {
+  // The watch went with the directory. Tell subscribers once more, so they
+  // re-read and find the resource gone, and drop their subscriptions; they
+  // can subscribe again if it comes back.
+  std::vector<std::string> uris;
+  {
+    std::lock_guard<std::mutex> lock(subscriptionsMutex_);
+    for (const auto &path : paths) {
+      auto it = subscriptions_.find(path);
+      if (it == subscriptions_.end()) continue;
+      uris.push_back(it->second);
+      subscriptions_.erase(it);
+      spdlog::info("Resource directory removed, dropped subscription: " +
+                   uris.back());
+    }
+  }
+  for (const auto &path : paths) resources_->invalidate(path);
+  for (const auto &uri : uris) {
+    sendNotification("notifications/resources/updated", {{"uri", uri}});
+  }
+}
+
+void McpServer::setNotificationSink(
+    std::function<void(const std::string &)> sink) {
+  std::lock_guard<std::mutex> lock(notificationMutex_);
+  notificationSink_ = std::move(sink);
+}
+
+void McpServer::sendNotification(const std::string &method,
+                                 const json &params) {
+  std::string notification = jsonRpc_->createNotification(method, params);
+  // Held while sending so clearing the sink waits for sends in progress
+  std::lock_guard<std::mutex> lock(notificationMutex_);
+  if (notificationSink_) notificationSink_(notification);
+}
+
+void McpServer::enableLogForwarding(const LogForwarderOptions &options) {
+  if (logForwarder_) return;
+  auto logger = spdlog::default_logger();
+  auto hub = McpLogging::forward_sink(logger);
+  if (!hub) {
+    spdlog::warn("Log forwarding needs McpLogging::setup_logger(); disabled");
+    return;
+  }
+  logForwarder_ = std::make_shared<LogForwarder>(
+      [this](const json &params) {
+        sendNotification("notifications/message", params);
+      },
+      options);
+  logForwarder_->attach(logger, hub);
+  serverInfo_.capabilities.logging = true;
+}
+
+bool McpServer::addResourceRoot(const std::string &dir) {
+  if (!resources_->addRoot(dir)) return false;
+  serverInfo_.capabilities.resources = true;
+  return true;
+}
+
+bool McpServer::enableResultSpill(const std::string &dir,
+                                  size_t thresholdBytes, uint64_t maxBytes) {
+  try {
+    auto store = std::make_unique<SpillStore>(dir, maxBytes);
+    if (!addResourceRoot(store->directory())) return false;
+    spill_ = std::move(store);
+    spillThreshold_ = thresholdBytes;
+    return true;
+  } catch (const std::exception &e) {
+    spdlog::error(std::string("Result spilling disabled: ") + e.what());
+    return false;
+  }
+}
+
+void McpServer::addPrompt(const McpPrompt &prompt,
+                          const std::string &templateText) {
+  prompts_->addPrompt(prompt, templateText);
+  serverInfo_.capabilities.prompts = true;
+}
+
 void McpServer::addTool(const McpTool &tool,
                         std::function<json(const json &)> handler) {
-  tools_[tool.name] = tool;
-  toolHandlers_[tool.name] = handler;
+  toolRegistry_.addTool(tool, std::move(handler));
+}
+
+void McpServer::addAsyncTool(const McpTool &tool, AsyncToolHandler handler) {
+  toolRegistry_.addAsyncTool(tool, std::move(handler));
+}
+
+bool McpServer::removeTool(const std::string &name) {
+  return toolRegistry_.removeTool(name);
+}
+
+bool McpServer::setToolIsolated(const std::string &name, bool isolated) {
+  bool found = false;
+  toolRegistry_.update([&](ToolSnapshot &next) {
+    const ToolEntry *entry = next.find(name);
+    if (!entry) return;
+    if (entry->asyncHandler && isolated) {
+      // Worker processes have no executor threads to resume coroutines
+      spdlog::warn("Async tools cannot run in the worker pool: " + name);
+      return;
+    }
+    ToolEntry updated = *entry;
+    updated.tool.isolated = isolated;
+    ToolRegistry::put(next, std::move(updated));
+    found = true;
+  });
+  return found;
+}
+
+void McpServer::enableWorkerPool(const WorkerPoolOptions &options) {
+  // Runs inside the worker: call the handler directly, never the pool
+  auto executor = [this](const std::string &name,
+                         const json &arguments) -> json {
+    auto snapshot = getToolSnapshot();
+    const ToolEntry *entry = snapshot->find(name);
+    if (!entry) throw std::runtime_error("Tool not found in worker: " + name);
+    return entry->handler(arguments);
+  };
+  workerPool_ = std::make_unique<WorkerPool>(executor, options);
+}
+
+void McpServer::setConcurrencyLimits(size_t maxInFlight, size_t maxQueued) {
+  admission_->setGlobalLimits(maxInFlight, maxQueued);
+}
+
+AdmissionLimits McpServer::limitsFor(const McpTool &tool) {
+  AdmissionLimits limits;
+  limits.maxConcurrency = tool.maxConcurrency;
+  limits.maxQueued = tool.maxQueued;
+  return limits;
+}
+
+json McpServer::invokeTool(const ToolEntry &entry, const json &arguments,
+                           bool nested) const {
+  // Safe point: don't start another tool once the request is over budget
+  MemoryScope::checkpoint();
+  auto ticket = admission_->admit(entry.tool.name, limitsFor(entry.tool),
+                                  !nested);
+  return runTool(entry, arguments);
+}
+
+json McpServer::runTool(const ToolEntry &entry, const json &arguments) const {
+  json result;
+  size_t peakBytes = 0;
+  bool exceeded = false;
+  MemoryScope::Handle tripped;
+  {
+    // The tool's own budget, on top of whatever the request has left
+    MemoryScope scope(entry.tool.memoryBudget,
+                      ("tool " + entry.tool.name).c_str());
+    try {
+      if (entry.tool.isolated && workerPool_) {
+        result = workerPool_->call(entry.tool.name, arguments);
+      } else {
+        result = entry.handler(arguments);
+      }
+    } catch (const MemoryBudgetExceeded &) {
+      // Reported below if this tool or the request is the one over budget;
+      // a nested tool's own budget passes through
+      if (!scope.handle().overBudget()) throw;
+    }
+    peakBytes = scope.peakBytes();
+    exceeded = scope.exceeded();
+    // Over budget even if the handler never reached a checkpoint
+    tripped = scope.handle().tripped();
+  }
+  toolMemory_->record(entry.tool.name, peakBytes, exceeded);
+  if (tripped.get()) throw MemoryBudgetExceeded(std::move(tripped));
+  return result;
+}
+
+bool McpServer::setToolMemoryBudget(const std::string &name, size_t bytes) {
+  bool found = false;
+  toolRegistry_.update([&](ToolSnapshot &next) {
+    const ToolEntry *entry = next.find(name);
+    if (!entry) return;
+    ToolEntry updated = *entry;
+    updated.tool.memoryBudget = bytes;
+    ToolRegistry::put(next, std::move(updated));
+    found = true;
+  });
+  return found;
+}
+
+size_t McpServer::loadPlugins(const std::string &dir) {
+  if (!pluginManager_) pluginManager_ = std::make_unique<PluginManager>(*this);
+  size_t loaded = pluginManager_->loadDirectory(dir);
+  spdlog::info("Plugins loaded from " + dir + ": " + std::to_string(loaded));
+  return loaded;
+}
+
+std::map<std::string, McpTool> McpServer::getTools() const {
+  std::map<std::string, McpTool> tools;
+  for (const auto &[name, entry] : getToolSnapshot()->entries) {
+    tools.emplace(name, entry->tool);
+  }
+  return tools;
+}
+
+std::map<std::string, std::function<json(const json &)>>
+McpServer::getToolHandlers() const {
+  std::map<std::string, std::function<json(const json &)>> handlers;
+  for (const auto &[name, entry] : getToolSnapshot()->entries) {
+    handlers.emplace(name, entry->handler);
+  }
+  return handlers;
 }
 
 void McpServer::setupDefaultTools() {
+  // Published as one registry version instead of one copy per tool
+  toolRegistry_.update([this](ToolSnapshot &next) { putDefaultTools(next); });
+}
+
+void McpServer::putDefaultTools(ToolSnapshot &next) {
   // Add a simple "echo" tool
   McpTool echoTool;
   echoTool.name = "echo";
@@ -210,7 +1139,7 @@ void McpServer::setupDefaultTools() {
          {{"type", "string"}, {"description", "The message to echo back"}}}}},
       {"required", {"message"}}};
 
-  addTool(echoTool, [](const json &params) -> json {
+  ToolRegistry::put(next, echoTool, [](const json &params) -> json {
     std::string message = params.value("message", "");
     if (!message.empty()) {
       return "Echo: " + message;
@@ -224,7 +1153,7 @@ void McpServer::setupDefaultTools() {
   timeTool.description = "Returns the current system time";
   timeTool.inputSchema = {{"type", "object"}, {"properties", json::object()}};
 
-  addTool(timeTool, [](const json &) -> json {
+  ToolRegistry::put(next, timeTool, [](const json &) -> json {
     auto now = std::time(nullptr);
     auto tm = *std::localtime(&now);
     std::stringstream ss;
@@ -238,10 +1167,10 @@ void McpServer::setupDefaultTools() {
   systemTool.description = "Returns basic system information";
   systemTool.inputSchema = {{"type", "object"}, {"properties", json::object()}};
 
-  addTool(systemTool, [this](const json &) -> json {
+  ToolRegistry::put(next, systemTool, [this](const json &) -> json {
     json info = {{"server_name", serverInfo_.name},
                  {"server_version", serverInfo_.version},
-                 {"tools_available", tools_.size()},
+                 {"tools_available", getToolSnapshot()->entries.size()},
                  {"capabilities",
                   {{"tools", serverInfo_.capabilities.tools},
                    {"logging", serverInfo_.capabilities.logging}}}};
@@ -258,9 +1187,147 @@ void McpServer::setupDefaultTools() {
                              {"properties", json::object()}};
 
   // Add a simple history buffer (store last 10 requests)
-  addTool(contextTool, [](const json &) -> json {
+  ToolRegistry::put(next, contextTool, [](const json &) -> json {
+    std::lock_guard<std::mutex> lock(requestHistoryMutex);
     json arr = json::array();
     for (const auto &req : requestHistory) arr.push_back(req);
     return json{{"recent_requests", arr}};
   });
+
+  // Add a "server_stats" tool exposing runtime counters for tuning limits
+  McpTool statsTool;
+  statsTool.name = "server_stats";
+  statsTool.description =
+      "Returns server runtime counters: tool admission (in-flight, queued, "
+      "rejected calls), worker pool state, the result spill store, client "
+      "log forwarding, async tool calls and per-method and per-tool "
+      "peak memory.";
+  statsTool.inputSchema = {{"type", "object"}, {"properties", json::object()}};
+
+  ToolRegistry::put(next, statsTool, [this](const json &) -> json {
+    json stats = {{"admission", admission_->stats()}};
+    if (workerPool_) {
+      stats["workerPool"] = {{"workers", workerPool_->size()},
+                             {"respawns", workerPool_->respawnCount()}};
+    }
+    if (spill_) {
+      stats["spill"] = {{"files", spill_->fileCount()},
+                        {"bytes", spill_->totalBytes()},
+                        {"thresholdBytes", spillThreshold_}};
+    }
+    if (logForwarder_) stats["logging"] = logForwarder_->stats();
+    {
+      std::lock_guard<std::mutex> lock(asyncMutex_);
+      stats["async"] = {{"inFlight", asyncInFlight_}};
+    }
+    stats["async"]["executorThreads"] = getIoExecutor().threadCount();
+    stats["async"]["waiting"] = getIoExecutor().waitingCount();
+    stats["memory"] = {{"accounting", MemoryScope::supported()},
+                       {"requestBudgetBytes", memoryBudget_},
+                       {"methods", methodMemory_->toJson()},
+                       {"tools", toolMemory_->toJson()}};
+    return stats;
+  });
+
+  // Add a "run_pipeline" tool that chains tool calls inside the server, so
+  // intermediate results never round-trip through the client
+  McpTool pipelineTool;
+  pipelineTool.name = ToolPipeline::kToolName;
+  pipelineTool.description =
+      "Runs several tool calls in one request. Steps may reference earlier "
+      "results with {\"$ref\": \"<step id>[/json/pointer]\"}; independent "
+      "steps run in parallel. Returns the final step's result, or all results "
+      "with output=\"all\".";
+  pipelineTool.inputSchema = ToolPipeline::inputSchema();
+
+  ToolRegistry::put(next, pipelineTool, [this](const json &params) -> json {
+    return ToolPipeline(*this).run(params);
+  });
+
+  // Add a "search_tools" tool backed by the inverted tool index, so agents
+  // can find tools without downloading the whole catalog
+  McpTool searchTool;
+  searchTool.name = "search_tools";
+  searchTool.description =
+      "Searches the tool catalog by keywords matched against tool names, "
+      "descriptions and argument names. Returns the best matches first.";
+  searchTool.inputSchema = {
+      {"type", "object"},
+      {"properties",
+       {{"query",
+         {{"type", "string"}, {"description", "Keywords to search for"}}},
+        {"limit",
+         {{"type", "integer"},
+          {"description", "Maximum number of results (default 10)"}}},
+        {"includeSchema",
+         {{"type", "boolean"},
+          {"description", "Include each tool's inputSchema in the results"}}}}},
+      {"required", {"query"}}};
+
+  ToolRegistry::put(next, searchTool, [this](const json &params) -> json {
+    std::string query = params.value("query", "");
+    int limit = params.value("limit", 10);
+    bool includeSchema = params.value("includeSchema", false);
+    if (limit < 1) limit = 1;
+
+    auto snapshot = getToolSnapshot();
+    json results = json::array();
+    for (const auto &hit :
+         snapshot->index.search(query, static_cast<size_t>(limit))) {
+      const ToolEntry *found = snapshot->find(hit.name);
+      if (!found) continue;
+      json entry = {{"name", found->tool.name},
+                    {"description", found->tool.description},
+                    {"score", hit.score}};
+      if (includeSchema) entry["inputSchema"] = found->tool.inputSchema;
+      results.push_back(entry);
+    }
+    return json{{"results", results}};
+  });
+
+  // Add an async "sleep" tool: waits on the executor's timer without
+  // occupying a request thread
+  McpTool sleepTool;
+  sleepTool.name = "sleep";
+  sleepTool.description =
+      "Waits for the given number of milliseconds (at most 60000) and then "
+      "returns. Does not occupy a server thread while waiting.";
+  sleepTool.inputSchema = {
+      {"type", "object"},
+      {"properties",
+       {{"ms",
+         {{"type", "integer"}, {"description", "Milliseconds to wait"}}}}},
+      {"required", {"ms"}}};
+
+  ToolRegistry::putAsync(next, sleepTool, [this](json params) -> ToolTask {
+    int64_t ms = std::clamp<int64_t>(params.value("ms", int64_t{0}), 0, 60000);
+    co_await getIoExecutor().sleepFor(std::chrono::milliseconds(ms));
+    co_return json("Slept " + std::to_string(ms) + " ms");
+  });
+}
+
+void McpServer::setupDefaultPrompts() {
+  McpPrompt summarize;
+  summarize.name = "summarize";
+  summarize.description = "Asks for a concise summary of a piece of text";
+  summarize.arguments = {
+      {"text", "Text to summarize", true, ""},
+      {"max_words", "Upper bound on the summary length (default 100)", false,
+       "100"}};
+  addPrompt(summarize,
+            "Summarize the following text in at most {{max_words}} words. "
+            "Keep names, numbers and conclusions intact.\n\n{{text}}");
+
+  McpPrompt review;
+  review.name = "code_review";
+  review.description = "Asks for a review of a code snippet";
+  review.arguments = {
+      {"code", "Code to review", true, ""},
+      {"language", "Programming language of the snippet", false, ""},
+      {"focus", "Aspects to concentrate on", false,
+       "correctness, readability and performance"}};
+  addPrompt(review,
+            "Review the following code, focusing on {{focus}}. "
+            "Point out concrete problems and suggest fixes.\n\n"
+            "```{{language}}\n{{code}}\n```");
 }
@@ -0,0 +1,206 @@
+#include "memory_accounting.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+struct MemoryAccount {
+  MemoryAccount *parent;  // holds a reference
+  size_t limit;
+  // Copied in so it outlives the scope without allocating
+  char label[64];
+  std::atomic<int64_t> current{0};
+  std::atomic<int64_t> peak{0};
+  std::atomic<bool> exceeded{false};
+  // The scope, Handles, child accounts and every allocation still charged
+  std::atomic<uint64_t> refs{1};
+};
+
+namespace {
+
+// Current scope of this thread. Constant-initialized, so reading it from
+// operator new never allocates or runs TLS constructors.
+thread_local MemoryAccount *tlsAccount = nullptr;
+
+std::atomic<bool> hooksEnabled{false};
+
+void retain(MemoryAccount *account) noexcept {
+  if (account) account->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void releaseRef(MemoryAccount *account) noexcept {
+  while (account &&
+         account->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    // Accounts live in malloc memory so operator new never recurses into
+    // its own bookkeeping
+    MemoryAccount *parent = account->parent;
+    account->~MemoryAccount();
+    std::free(account);
+    account = parent;
+  }
+}
+
+}  // namespace
+
+MemoryScope::Handle::Handle(MemoryAccount *account) noexcept
+    : account_(account) {
+  retain(account_);
+}
+
+MemoryScope::Handle::~Handle() { releaseRef(account_); }
+
+int64_t MemoryScope::Handle::currentBytes() const {
+  return account_ ? account_->current.load(std::memory_order_relaxed) : 0;
+}
+
+size_t MemoryScope::Handle::peakBytes() const {
+  return account_ ? static_cast<size_t>(
+                        account_->peak.load(std::memory_order_relaxed))
+                  : 0;
+}
+
+bool MemoryScope::Handle::exceeded() const {
+  return account_ && account_->exceeded.load(std::memory_order_relaxed);
+}
+
+bool MemoryScope::Handle::overBudget() const {
+  return tripped().get() != nullptr;
+}
+
+MemoryScope::Handle MemoryScope::Handle::tripped() const {
+  for (MemoryAccount *account = account_; account; account = account->parent) {
+    if (account->exceeded.load(std::memory_order_relaxed)) {
+      return Handle(account);
+    }
+  }
+  return Handle();
+}
+
+size_t MemoryScope::Handle::limitBytes() const {
+  return account_ ? account_->limit : 0;
+}
+
+const char *MemoryScope::Handle::label() const {
+  return account_ ? account_->label : "";
+}
+
+MemoryScope::Attach::Attach(const Handle &handle)
+    : handle_(handle), previous_(tlsAccount) {
+  tlsAccount = handle_.get();
+}
+
+MemoryScope::Attach::~Attach() { tlsAccount = previous_; }
+
+MemoryScope::MemoryScope(size_t limitBytes, const char *label)
+    : limit_(limitBytes), previous_(tlsAccount) {
+  void *memory = std::malloc(sizeof(MemoryAccount));
+  if (!memory) throw std::bad_alloc();
+  auto *account = new (memory) MemoryAccount();
+  account->parent = previous_;
+  retain(previous_);
+  account->limit = limitBytes;
+  std::strncpy(account->label, label ? label : "", sizeof(account->label) - 1);
+  account->label[sizeof(account->label) - 1] = '\0';
+  // The Handle adds the scope's own reference; drop the initial one
+  handle_ = Handle(account);
+  releaseRef(account);
+  tlsAccount = account;
+}
+
+MemoryScope::~MemoryScope() { tlsAccount = previous_; }
+
+MemoryScope::Handle MemoryScope::current() { return Handle(tlsAccount); }
+
+void MemoryScope::checkpoint() {
+  Handle tripped = Handle(tlsAccount).tripped();
+  if (tripped.get()) throw MemoryBudgetExceeded(std::move(tripped));
+}
+
+bool MemoryScope::supported() {
+  return hooksEnabled.load(std::memory_order_relaxed);
+}
+
+void MemoryScope::enableHooks() noexcept {
+  hooksEnabled.store(true, std::memory_order_relaxed);
+}
+
+MemoryAccount *MemoryScope::chargeAllocation(size_t bytes, bool mayRefuse,
+                                             bool &refused) noexcept {
+  MemoryAccount *charged = tlsAccount;
+  refused = false;
+  if (!charged) return nullptr;
+  auto amount = static_cast<int64_t>(bytes);
+
+  if (mayRefuse) {
+    for (MemoryAccount *account = charged; account; account = account->parent) {
+      if (account->limit != 0 &&
+          account->current.load(std::memory_order_relaxed) + amount >
+              static_cast<int64_t>(account->limit)) {
+        account->exceeded.store(true, std::memory_order_relaxed);
+        refused = true;
+        return nullptr;
+      }
+    }
+  }
+
+  for (MemoryAccount *account = charged; account; account = account->parent) {
+    int64_t now =
+        account->current.fetch_add(amount, std::memory_order_relaxed) + amount;
+    int64_t peak = account->peak.load(std::memory_order_relaxed);
+    while (now > peak && !account->peak.compare_exchange_weak(
+                             peak, now, std::memory_order_relaxed)) {
+    }
+    if (account->limit != 0 && now > static_cast<int64_t>(account->limit)) {
+      account->exceeded.store(true, std::memory_order_relaxed);
+    }
+  }
+  retain(charged);
+  return charged;
+}
+
+void MemoryScope::releaseAllocation(MemoryAccount *account,
+                                    size_t bytes) noexcept {
+  auto amount = static_cast<int64_t>(bytes);
+  for (MemoryAccount *scope = account; scope; scope = scope->parent) {
+    scope->current.fetch_sub(amount, std::memory_order_relaxed);
+  }
+  releaseRef(account);
+}
+
+std::string MemoryBudgetExceeded::message() const {
+  std::string text = "Memory budget of " + std::to_string(limitBytes()) +
+                     " bytes exceeded";
+  if (*scope_.label()) text += std::string(" by ") + scope_.label();
+  return text;
+}
+
+void MemoryUsageStats::record(const std::string &key, size_t peakBytes,
+                              bool rejected) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = entries_.find(key);
+  if (it == entries_.end()) {
+    // Method names come from clients; don't let them grow the map forever
+    it = entries_.size() < kMaxKeys ? entries_.emplace(key, Entry{}).first
+                                    : entries_.emplace("(other)", Entry{}).first;
+  }
+  Entry &entry = it->second;
+  ++entry.requests;
+  if (rejected) ++entry.rejected;
+  if (peakBytes > entry.peakBytes) entry.peakBytes = peakBytes;
+  entry.totalPeakBytes += static_cast<double>(peakBytes);
+}
+
+json MemoryUsageStats::toJson() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  json result = json::object();
+  for (const auto &[key, entry] : entries_) {
+    result[key] = {
+        {"requests", entry.requests},
+        {"rejected", entry.rejected},
+        {"peakBytes", entry.peakBytes},
+        {"avgPeakBytes",
+         static_cast<uint64_t>(entry.totalPeakBytes /
+                               static_cast<double>(entry.requests))}};
+  }
+  return result;
+}
@@ -0,0 +1,153 @@
+// Replacement global operator new/delete that charge allocations to the
+// current MemoryScope. Linked into the mcp_server executable only (see
+// MCP_MEMORY_ACCOUNTING in CMakeLists.txt): a program embedding the mcp
+// library keeps its own allocator, and scopes then count nothing.
+//
+// Every block carries a small header recording the account it was charged
+// to and its size, so it is credited back to that account wherever it is
+// freed. Outside any scope that costs one thread-local load and the header.
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include "memory_accounting.h"
+
+namespace {
+
+struct AllocationHeader {
+  MemoryAccount *account;
+  size_t bytes;
+};
+
+// Keeps the user pointer aligned like malloc's
+constexpr size_t kHeaderSize = alignof(std::max_align_t);
+static_assert(sizeof(AllocationHeader) <= kHeaderSize,
+              "AllocationHeader too big");
+
+constexpr size_t kDefaultAlignment = alignof(std::max_align_t);
+
+[[maybe_unused]] const bool hooksRegistered = [] {
+  MemoryScope::enableHooks();
+  return true;
+}();
+
+AllocationHeader *headerOf(void *ptr) {
+  return reinterpret_cast<AllocationHeader *>(static_cast<char *>(ptr) -
+                                              sizeof(AllocationHeader));
+}
+
+void *allocate(size_t size, size_t alignment, bool noThrow) {
+  size_t offset = std::max(kHeaderSize, alignment);
+  if (size > SIZE_MAX - offset) {
+    if (noThrow) return nullptr;
+    throw std::bad_alloc();
+  }
+
+  bool refused = false;
+  MemoryAccount *account =
+      MemoryScope::chargeAllocation(size, noThrow, refused);
+  if (refused) return nullptr;
+
+  for (;;) {
+    void *base = nullptr;
+    if (alignment <= kDefaultAlignment) {
+      base = std::malloc(offset + size);
+    } else if (posix_memalign(&base, alignment, offset + size) != 0) {
+      base = nullptr;
+    }
+    if (base) {
+      void *ptr = static_cast<char *>(base) + offset;
+      *headerOf(ptr) = AllocationHeader{account, size};
+      return ptr;
+    }
+
+    std::new_handler handler = std::get_new_handler();
+    try {
+      if (!handler) throw std::bad_alloc();
+      handler();
+    } catch (...) {
+      if (account) MemoryScope::releaseAllocation(account, size);
+      if (noThrow) return nullptr;
+      throw;
+    }
+  }
+}
+
+void deallocate(void *ptr, size_t alignment) noexcept {
+  if (!ptr) return;
+  AllocationHeader *header = headerOf(ptr);
+  if (header->account) {
+    MemoryScope::releaseAllocation(header->account, header->bytes);
+  }
+  std::free(static_cast<char *>(ptr) - std::max(kHeaderSize, alignment));
+}
+
+}  // namespace
+
+void *operator new(size_t size) {
+  return allocate(size, kDefaultAlignment, false);
+}
+void *operator new[](size_t size) {
+  return allocate(size, kDefaultAlignment, false);
+}
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  return allocate(size, kDefaultAlignment, true);
+}
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+  return allocate(size, kDefaultAlignment, true);
+}
+void *operator new(size_t size, std::align_val_t alignment) {
+  return allocate(size, static_cast<size_t>(alignment), false);
+}
+void *operator new[](size_t size, std::align_val_t alignment) {
+  return allocate(size, static_cast<size_t>(alignment), false);
+}
+void *operator new(size_t size, std::align_val_t alignment,
+                   const std::nothrow_t &) noexcept {
+  return allocate(size, static_cast<size_t>(alignment), true);
+}
+void *operator new[](size_t size, std::align_val_t alignment,
+                     const std::nothrow_t &) noexcept {
+  return allocate(size, static_cast<size_t>(alignment), true);
+}
+
+void operator delete(void *ptr) noexcept {
+  deallocate(ptr, kDefaultAlignment);
+}
+void operator delete[](void *ptr) noexcept {
+  deallocate(ptr, kDefaultAlignment);
+}
+void operator delete(void *ptr, size_t) noexcept {
+  deallocate(ptr, kDefaultAlignment);
+}
+void operator delete[](void *ptr, size_t) noexcept {
+  deallocate(ptr, kDefaultAlignment);
+}
+void operator delete(void *ptr, const std::nothrow_t &) noexcept {
+  deallocate(ptr, kDefaultAlignment);
+}
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept {
+  deallocate(ptr, kDefaultAlignment);
+}
+void operator delete(void *ptr, std::align_val_t alignment) noexcept {
+  deallocate(ptr, static_cast<size_t>(alignment));
+}
+void operator delete[](void *ptr, std::align_val_t alignment) noexcept {
+  deallocate(ptr, static_cast<size_t>(alignment));
+}
+void operator delete(void *ptr, size_t, std::align_val_t alignment) noexcept {
+  deallocate(ptr, static_cast<size_t>(alignment));
+}
+void operator delete[](void *ptr, size_t,
+                       std::align_val_t alignment) noexcept {
+  deallocate(ptr, static_cast<size_t>(alignment));
+}
+void operator delete(void *ptr, std::align_val_t alignment,
+                     const std::nothrow_t &) noexcept {
+  deallocate(ptr, static_cast<size_t>(alignment));
+}
+void operator delete[](void *ptr, std::align_val_t alignment,
+                       const std::nothrow_t &) noexcept {
+  deallocate(ptr, static_cast<size_t>(alignment));
+}
@@ -0,0 +1,88 @@
+#include "open_file.h"
+
+#include <cerrno>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+std::shared_ptr<OpenFile> OpenFile::open(const std::string &path) {
+  auto file = std::shared_ptr<OpenFile>(new OpenFile());
+  file->path_ = path;
+
+#ifndef _WIN32
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) throw std::runtime_error("Cannot open file: " + path);
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    ::close(fd);
+    throw std::runtime_error("Cannot stat file: " + path);
+  }
+  file->fd_ = fd;
+  file->size_ = static_cast<size_t>(st.st_size);
+  file->mtimeNs_ = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL +
+                   st.st_mtim.tv_nsec;
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#else
+  std::error_code ec;
+  file->size_ = static_cast<size_t>(std::filesystem::file_size(path, ec));
+  if (ec) throw std::runtime_error("Cannot open file: " + path);
+  auto mtime = std::filesystem::last_write_time(path, ec);
+  file->mtimeNs_ = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                       mtime.time_since_epoch())
+                       .count();
+#endif
+  return file;
+}
+
+size_t OpenFile::readAt(uint64_t offset, char *out, size_t length) const {
+  size_t done = 0;
+#ifndef _WIN32
+  while (done < length) {
+    ssize_t n = pread(fd_, out + done, length - done,
+                      static_cast<off_t>(offset + done));
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0) throw std::runtime_error("Cannot read file: " + path_);
+    if (n == 0) break;  // end of file, possibly truncated since open()
+    done += static_cast<size_t>(n);
+  }
+#else
+  // A stream per read keeps concurrent readers independent
+  std::ifstream in(path_, std::ios::binary);
+  if (!in) throw std::runtime_error("Cannot read file: " + path_);
+  in.seekg(static_cast<std::streamoff>(offset));
+  in.read(out, static_cast<std::streamsize>(length));
+  done = static_cast<size_t>(in.gcount());
+#endif
+  return done;
+}
+
+bool OpenFile::isStale() const {
+#ifndef _WIN32
+  struct stat st;
+  if (::stat(path_.c_str(), &st) != 0) return true;
+  int64_t mtime = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL +
+                  st.st_mtim.tv_nsec;
+  return static_cast<size_t>(st.st_size) != size_ || mtime != mtimeNs_;
+#else
+  std::error_code ec;
+  auto mtime = std::filesystem::last_write_time(path_, ec);
+  if (ec) return true;
+  return std::filesystem::file_size(path_, ec) != size_ ||
+         std::chrono::duration_cast<std::chrono::nanoseconds>(
+             mtime.time_since_epoch())
+                 .count() != mtimeNs_;
+#endif
+}
+
+OpenFile::~OpenFile() {
+#ifndef _WIN32
+  if (fd_ >= 0) ::close(fd_);
+#endif
+}
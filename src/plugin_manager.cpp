@@ -0,0 +1,360 @@
+#include "plugin_manager.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "mcp_logger.h"
+#include "mcp_plugin.h"
+#include "mcp_server.h"
+
+#ifdef _WIN32
+
+class PluginManager::Plugin {};
+
+PluginManager::PluginManager(McpServer& server) : server_(server) {}
+
+PluginManager::~PluginManager() = default;
+
+size_t PluginManager::loadDirectory(const std::string& dir) {
+  spdlog::warn("Tool plugins are not supported on this platform, ignoring " +
+               dir);
+  return 0;
+}
+
+#else
+
+#include <dlfcn.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Identity of a file version, used to detect replaced or rewritten libraries
+struct FileStamp {
+  dev_t dev = 0;
+  ino_t ino = 0;
+  off_t size = 0;
+  long long mtimeNs = 0;
+
+  bool operator==(const FileStamp& other) const {
+    return dev == other.dev && ino == other.ino && size == other.size &&
+           mtimeNs == other.mtimeNs;
+  }
+  bool operator!=(const FileStamp& other) const { return !(*this == other); }
+};
+
+FileStamp statFile(const std::string& path) {
+  FileStamp stamp;
+  struct stat st;
+  if (::stat(path.c_str(), &st) == 0) {
+    stamp.dev = st.st_dev;
+    stamp.ino = st.st_ino;
+    stamp.size = st.st_size;
+    stamp.mtimeNs =
+        static_cast<long long>(st.st_mtim.tv_sec) * 1000000000LL +
+        st.st_mtim.tv_nsec;
+  }
+  return stamp;
+}
+
+// One opened version of a plugin library
+class LoadedLibrary {
+ public:
+  ~LoadedLibrary() {
+    if (handle_) dlclose(handle_);
+  }
+
+  // Opens a private copy of the library. dlopen() returns the already loaded
+  // object for a path it has seen, so reloading requires a new path; the copy
+  // also protects running code from a library overwritten in place.
+  static std::shared_ptr<LoadedLibrary> open(const std::string& path) {
+    std::string copyPath =
+        (fs::temp_directory_path() / "mcp-plugin-XXXXXX").string();
+    int fd = ::mkstemp(copyPath.data());
+    if (fd < 0) throw std::runtime_error("Cannot create plugin copy: " + path);
+    ::close(fd);
+
+    std::error_code ec;
+    fs::copy_file(path, copyPath, fs::copy_options::overwrite_existing, ec);
+    if (ec) {
+      fs::remove(copyPath, ec);
+      throw std::runtime_error("Cannot copy plugin " + path);
+    }
+
+    void* handle = dlopen(copyPath.c_str(), RTLD_NOW | RTLD_LOCAL);
+    fs::remove(copyPath, ec);  // The mapping stays valid after unlink
+    if (!handle) {
+      throw std::runtime_error("dlopen failed for " + path + ": " + dlerror());
+    }
+
+    auto lib = std::shared_ptr<LoadedLibrary>(new LoadedLibrary());
+    lib->handle_ = handle;
+    lib->call_ = reinterpret_cast<McpPluginCallFn>(
+        dlsym(handle, MCP_PLUGIN_CALL_SYMBOL));
+    lib->free_ = reinterpret_cast<McpPluginFreeFn>(
+        dlsym(handle, MCP_PLUGIN_FREE_SYMBOL));
+    lib->manifest_ = reinterpret_cast<McpPluginManifestFn>(
+        dlsym(handle, MCP_PLUGIN_MANIFEST_SYMBOL));
+    if (!lib->call_ || !lib->free_) {
+      throw std::runtime_error("Plugin " + path + " does not export " +
+                               MCP_PLUGIN_CALL_SYMBOL + "/" +
+                               MCP_PLUGIN_FREE_SYMBOL);
+    }
+    return lib;
+  }
+
+  json manifest() const {
+    if (!manifest_) {
+      throw std::runtime_error("Plugin has no manifest file and does not "
+                               "export " MCP_PLUGIN_MANIFEST_SYMBOL);
+    }
+    return json::parse(manifest_());
+  }
+
+  json call(const std::string& tool, const json& arguments) const {
+    char* out = nullptr;
+    int rc = call_(tool.c_str(), arguments.dump().c_str(), &out);
+    std::string text = out ? out : "";
+    if (out) free_(out);
+
+    if (rc != 0) {
+      throw std::runtime_error(text.empty() ? "Plugin tool failed: " + tool
+                                            : text);
+    }
+    if (text.empty()) return nullptr;
+    // Plugins normally return JSON; pass anything else through as text
+    json result = json::parse(text, nullptr, false);
+    return result.is_discarded() ? json(text) : result;
+  }
+
+ private:
+  LoadedLibrary() = default;
+
+  void* handle_ = nullptr;
+  McpPluginCallFn call_ = nullptr;
+  McpPluginFreeFn free_ = nullptr;
+  McpPluginManifestFn manifest_ = nullptr;
+};
+
+}  // namespace
+
+class PluginManager::Plugin : public std::enable_shared_from_this<Plugin> {
+ public:
+  Plugin(McpServer& server, std::string libraryPath, std::string manifestPath)
+      : server_(server),
+        libraryPath_(std::move(libraryPath)),
+        manifestPath_(std::move(manifestPath)) {}
+
+  // Register the plugin's tools. Only loads the library when there is no
+  // manifest file to read the tool list from.
+  void registerTools() {
+    std::lock_guard<std::mutex> lock(reloadMutex_);
+    std::shared_ptr<LoadedLibrary> library;
+    FileStamp libraryStamp;
+    if (!fs::exists(manifestPath_)) {
+      libraryStamp = statFile(libraryPath_);
+      library = LoadedLibrary::open(libraryPath_);
+    }
+    FileStamp manifestStamp = statFile(manifestPath_);
+    syncTools(readManifest(library.get()));
+
+    libraryStamp_ = libraryStamp;
+    manifestStamp_ = manifestStamp;
+    library_.store(std::move(library), std::memory_order_release);
+  }
+
+  // Current library version. Only the first call to a plugin that was
+  // registered from its manifest opens the library here; later versions are
+  // swapped in by the manager's reload thread (see check()), so every other
+  // call is a single atomic load.
+  std::shared_ptr<LoadedLibrary> acquire() {
+    auto library = library_.load(std::memory_order_acquire);
+    if (library) return library;
+
+    std::lock_guard<std::mutex> lock(reloadMutex_);
+    // Another caller may have finished the first load while this one waited
+    library = library_.load(std::memory_order_acquire);
+    if (library) return library;
+
+    FileStamp libraryStamp = statFile(libraryPath_);
+    FileStamp manifestStamp = statFile(manifestPath_);
+    auto next = LoadedLibrary::open(libraryPath_);
+    if (manifestStamp != manifestStamp_) syncTools(readManifest(next.get()));
+    libraryStamp_ = libraryStamp;
+    manifestStamp_ = manifestStamp;
+    library_.store(next, std::memory_order_release);
+    spdlog::info("Loaded tool plugin: " + libraryPath_);
+    return next;
+  }
+
+  // Reload the library and tools if their files changed on disk. Runs on the
+  // manager's reload thread; calls keep using the version they acquired.
+  void check() {
+    std::lock_guard<std::mutex> lock(reloadMutex_);
+    auto library = library_.load(std::memory_order_acquire);
+    FileStamp libraryStamp = statFile(libraryPath_);
+    FileStamp manifestStamp = statFile(manifestPath_);
+    bool libraryChanged = library && libraryStamp != libraryStamp_;
+    if (!libraryChanged && manifestStamp == manifestStamp_) return;
+    // Retry a failed version only once the files change again
+    if (libraryStamp == failedLibraryStamp_ &&
+        manifestStamp == failedManifestStamp_) {
+      return;
+    }
+
+    try {
+      // Nothing is committed until both the library and the manifest have
+      // loaded, so a failure (e.g. a manifest caught mid-write) leaves the
+      // previous version and stamps in place. A library that was never
+      // called stays unopened; its tool list comes from the manifest file.
+      std::shared_ptr<LoadedLibrary> next;
+      if (library || !fs::exists(manifestPath_)) {
+        next = LoadedLibrary::open(libraryPath_);
+      }
+      syncTools(readManifest(next.get()));
+      libraryStamp_ = libraryStamp;
+      manifestStamp_ = manifestStamp;
+      if (next) {
+        library_.store(next, std::memory_order_release);
+        spdlog::info("Reloaded tool plugin: " + libraryPath_);
+      }
+    } catch (const std::exception& e) {
+      failedLibraryStamp_ = libraryStamp;
+      failedManifestStamp_ = manifestStamp;
+      spdlog::error(std::string("Plugin reload failed, keeping previous "
+                                "version: ") +
+                    e.what());
+    }
+  }
+
+ private:
+  // The manifest file, or else the one built into 'library'
+  json readManifest(const LoadedLibrary* library) {
+    if (fs::exists(manifestPath_)) {
+      std::ifstream in(manifestPath_);
+      return json::parse(in);
+    }
+    if (!library) throw std::runtime_error("Missing manifest " + manifestPath_);
+    return library->manifest();
+  }
+
+  // Bring the server's registry in line with the manifest, as one registry
+  // version
+  void syncTools(const json& manifest) {
+    std::vector<McpTool> tools;
+    std::set<std::string> names;
+    for (const auto& spec : manifest.at("tools")) {
+      McpTool tool;
+      tool.name = spec.at("name").get<std::string>();
+      tool.description = spec.value("description", "");
+      tool.inputSchema = spec.value(
+          "inputSchema", json{{"type", "object"}, {"properties", json::object()}});
+      tool.isolated = spec.value("isolated", false);
+      tool.maxConcurrency = spec.value("maxConcurrency", size_t{0});
+      tool.maxQueued = spec.value("maxQueued", size_t{0});
+      names.insert(tool.name);
+      tools.push_back(std::move(tool));
+    }
+
+    std::weak_ptr<Plugin> weak = weak_from_this();
+    server_.getToolRegistry().update([&](ToolSnapshot& next) {
+      for (const auto& tool : tools) {
+        std::string toolName = tool.name;
+        ToolRegistry::put(next, tool,
+                          [weak, toolName](const json& arguments) -> json {
+          auto plugin = weak.lock();
+          if (!plugin) throw std::runtime_error("Plugin unloaded: " + toolName);
+          // Holding the library for the duration of the call keeps it mapped
+          // even if another thread reloads the plugin meanwhile
+          auto library = plugin->acquire();
+          return library->call(toolName, arguments);
+        });
+      }
+      for (const auto& stale : toolNames_) {
+        if (!names.count(stale)) ToolRegistry::erase(next, stale);
+      }
+    });
+    toolNames_ = std::move(names);
+  }
+
+  McpServer& server_;
+  std::string libraryPath_;
+  std::string manifestPath_;
+
+  std::atomic<std::shared_ptr<LoadedLibrary>> library_;
+  // Serializes loads and reloads; the stamps and toolNames_ are guarded by it
+  std::mutex reloadMutex_;
+  FileStamp libraryStamp_;
+  FileStamp manifestStamp_;
+  FileStamp failedLibraryStamp_;
+  FileStamp failedManifestStamp_;
+  std::set<std::string> toolNames_;
+};
+
+PluginManager::PluginManager(McpServer& server) : server_(server) {}
+
+PluginManager::~PluginManager() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  if (reloader_.joinable()) reloader_.join();
+}
+
+void PluginManager::reloadLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (!cv_.wait_for(lock, std::chrono::milliseconds(kReloadCheckIntervalMs),
+                       [this] { return stopping_; })) {
+    auto plugins = plugins_;
+    lock.unlock();
+    for (const auto& plugin : plugins) plugin->check();
+    lock.lock();
+  }
+}
+
+size_t PluginManager::loadDirectory(const std::string& dir) {
+  std::error_code ec;
+  fs::directory_iterator it(dir, ec);
+  if (ec) {
+    spdlog::error("Cannot open plugin directory " + dir + ": " + ec.message());
+    return 0;
+  }
+
+  size_t loaded = 0;
+  for (const auto& file : it) {
+    if (!file.is_regular_file() || file.path().extension() != ".so") continue;
+
+    fs::path manifest = file.path();
+    manifest.replace_extension(".json");
+    auto plugin = std::make_shared<Plugin>(server_, file.path().string(),
+                                           manifest.string());
+    try {
+      plugin->registerTools();
+      std::lock_guard<std::mutex> lock(mutex_);
+      plugins_.push_back(plugin);
+      if (!reloader_.joinable()) {
+        reloader_ = std::thread([this] { reloadLoop(); });
+      }
+      ++loaded;
+      spdlog::info("Registered tool plugin: " + file.path().string());
+    } catch (const std::exception& e) {
+      spdlog::error("Failed to register plugin " + file.path().string() +
+                    ": " + e.what());
+    }
+  }
+  return loaded;
+}
+
+#endif
@@ -0,0 +1,142 @@
+#include "prompt_registry.h"
+
+#include <stdexcept>
+
+namespace {
+
+std::string trim(const std::string &s) {
+  size_t begin = s.find_first_not_of(" \t");
+  if (begin == std::string::npos) return "";
+  size_t end = s.find_last_not_of(" \t");
+  return s.substr(begin, end - begin + 1);
+}
+
+}  // namespace
+
+PromptTemplate PromptTemplate::compile(
+    const std::string &text, const std::vector<McpPromptArgument> &args) {
+  PromptTemplate compiled;
+  compiled.text_ = text;
+
+  size_t pos = 0;
+  while (pos < text.size()) {
+    size_t open = text.find("{{", pos);
+    if (open == std::string::npos) open = text.size();
+    if (open > pos) {
+      compiled.segments_.push_back({pos, open - pos, -1});
+      compiled.literalSize_ += open - pos;
+    }
+    if (open == text.size()) break;
+
+    size_t close = text.find("}}", open + 2);
+    if (close == std::string::npos) {
+      throw std::invalid_argument("Unterminated placeholder in prompt template");
+    }
+    std::string name = trim(text.substr(open + 2, close - open - 2));
+    int slot = -1;
+    for (size_t i = 0; i < args.size(); ++i) {
+      if (args[i].name == name) slot = static_cast<int>(i);
+    }
+    if (slot < 0) {
+      throw std::invalid_argument("Unknown placeholder in prompt template: " +
+                                  name);
+    }
+    compiled.segments_.push_back({0, 0, slot});
+    pos = close + 2;
+  }
+  return compiled;
+}
+
+std::string PromptTemplate::render(
+    const std::vector<std::string_view> &values) const {
+  size_t total = literalSize_;
+  for (const auto &segment : segments_) {
+    if (segment.slot >= 0) total += values[segment.slot].size();
+  }
+
+  std::string out;
+  out.reserve(total);
+  for (const auto &segment : segments_) {
+    if (segment.slot < 0) {
+      out.append(text_, segment.offset, segment.length);
+    } else {
+      out.append(values[segment.slot]);
+    }
+  }
+  return out;
+}
+
+void PromptRegistry::addPrompt(const McpPrompt &prompt,
+                               const std::string &templateText) {
+  auto entry = std::make_shared<const Entry>(
+      Entry{prompt, PromptTemplate::compile(templateText, prompt.arguments)});
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  prompts_[prompt.name] = std::move(entry);
+}
+
+bool PromptRegistry::empty() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return prompts_.empty();
+}
+
+json PromptRegistry::list() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  json prompts = json::array();
+  for (const auto &[name, entry] : prompts_) {
+    json args = json::array();
+    for (const auto &arg : entry->prompt.arguments) {
+      args.push_back({{"name", arg.name},
+                      {"description", arg.description},
+                      {"required", arg.required}});
+    }
+    prompts.push_back({{"name", name},
+                       {"description", entry->prompt.description},
+                       {"arguments", args}});
+  }
+  return {{"prompts", prompts}};
+}
+
+std::string PromptRegistry::render(const Entry &entry,
+                                   const json &arguments) {
+  // String arguments are used in place; only other JSON values need text
+  std::vector<std::string_view> values;
+  std::vector<std::string> dumped;
+  values.reserve(entry.prompt.arguments.size());
+  dumped.reserve(entry.prompt.arguments.size());
+  for (const auto &arg : entry.prompt.arguments) {
+    auto it = arguments.find(arg.name);
+    if (it == arguments.end() || it->is_null()) {
+      if (arg.required) {
+        throw std::invalid_argument("Missing required argument: " + arg.name);
+      }
+      values.push_back(arg.defaultValue);
+    } else if (it->is_string()) {
+      values.push_back(it->get_ref<const std::string &>());
+    } else {
+      dumped.push_back(it->dump());
+      values.push_back(dumped.back());
+    }
+  }
+  return entry.compiled.render(values);
+}
+
+json PromptRegistry::get(const std::string &name, const json &arguments) {
+  std::shared_ptr<const Entry> entry;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = prompts_.find(name);
+    if (it == prompts_.end()) {
+      throw std::invalid_argument("Prompt not found: " + name);
+    }
+    entry = it->second;
+  }
+
+  static const json kEmpty = json::object();
+  const json &values = arguments.is_object() ? arguments : kEmpty;
+  std::string text = render(*entry, values);
+  json message = {{"role", "user"},
+                  {"content", {{"type", "text"}, {"text", std::move(text)}}}};
+  return {{"description", entry->prompt.description},
+          {"messages", json::array({message})}};
+}
@@ -0,0 +1,146 @@
+#include "request_scheduler.h"
+
+#include <exception>
+
+#include "mcp_logger.h"
+
+namespace {
+
+void runTask(const RequestScheduler::Task &task) {
+  try {
+    task();
+  } catch (const std::exception &e) {
+    spdlog::error(std::string("Unhandled exception in request task: ") +
+                  e.what());
+  } catch (...) {
+    // Tasks answer their own failures; this only keeps the worker alive
+    spdlog::error("Unhandled non-standard exception in request task");
+  }
+}
+
+}  // namespace
+
+RequestScheduler::RequestScheduler(size_t workers) {
+  if (workers == 0) workers = 1;
+  for (size_t i = 0; i < workers; ++i) {
+    queues_.push_back(std::make_unique<WorkQueue>());
+  }
+  threads_.emplace_back([this] { controlLoop(); });
+  for (size_t i = 0; i < workers; ++i) {
+    threads_.emplace_back([this, i] { workerLoop(i); });
+  }
+}
+
+RequestScheduler::~RequestScheduler() { shutdown(); }
+
+void RequestScheduler::submit(Lane lane, Task task) {
+  // Counters go up before the push so a racing pop can never underflow them
+  if (lane == Lane::Control) {
+    {
+      std::lock_guard<std::mutex> lock(sleepMutex_);
+      ++pendingControl_;
+    }
+    {
+      std::lock_guard<std::mutex> lock(controlMutex_);
+      control_.push_back(std::move(task));
+    }
+    controlCv_.notify_one();
+    workCv_.notify_one();
+    return;
+  }
+
+  size_t index = nextQueue_.fetch_add(1) % queues_.size();
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex_);
+    ++pendingWork_;
+  }
+  {
+    std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+    queues_[index]->tasks.push_back(std::move(task));
+  }
+  workCv_.notify_one();
+}
+
+void RequestScheduler::shutdown() {
+  {
+    std::lock_guard<std::mutex> lock(sleepMutex_);
+    if (stopping_) return;
+    stopping_ = true;
+  }
+  workCv_.notify_all();
+  controlCv_.notify_all();
+  for (auto &thread : threads_) {
+    if (thread.joinable()) thread.join();
+  }
+}
+
+bool RequestScheduler::popControl(Task &task) {
+  {
+    std::lock_guard<std::mutex> lock(controlMutex_);
+    if (control_.empty()) return false;
+    task = std::move(control_.front());
+    control_.pop_front();
+  }
+  std::lock_guard<std::mutex> lock(sleepMutex_);
+  --pendingControl_;
+  return true;
+}
+
+bool RequestScheduler::popWork(size_t index, Task &task) {
+  bool found = false;
+  // Own queue first, oldest task first
+  {
+    WorkQueue &own = *queues_[index];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.tasks.empty()) {
+      task = std::move(own.tasks.front());
+      own.tasks.pop_front();
+      found = true;
+    }
+  }
+  // Otherwise steal the newest task from another worker
+  for (size_t i = 1; !found && i < queues_.size(); ++i) {
+    WorkQueue &victim = *queues_[(index + i) % queues_.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      task = std::move(victim.tasks.back());
+      victim.tasks.pop_back();
+      found = true;
+      stolen_.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+  if (!found) return false;
+  std::lock_guard<std::mutex> lock(sleepMutex_);
+  --pendingWork_;
+  return true;
+}
+
+void RequestScheduler::workerLoop(size_t index) {
+  Task task;
+  for (;;) {
+    if (popControl(task) || popWork(index, task)) {
+      runTask(task);
+      task = nullptr;
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(sleepMutex_);
+    workCv_.wait(lock, [this] {
+      return pendingControl_ + pendingWork_ > 0 || stopping_;
+    });
+    if (stopping_ && pendingControl_ + pendingWork_ == 0) return;
+  }
+}
+
+void RequestScheduler::controlLoop() {
+  Task task;
+  for (;;) {
+    if (popControl(task)) {
+      runTask(task);
+      task = nullptr;
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(sleepMutex_);
+    controlCv_.wait(lock, [this] { return pendingControl_ > 0 || stopping_; });
+    if (stopping_ && pendingControl_ == 0) return;
+  }
+}
@@ -0,0 +1,338 @@
+#include "resource_manager.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <stdexcept>
+#include <utility>
+
+#include "base64.h"
+#include "mcp_logger.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr char kFileScheme[] = "file://";
+
+// The first extension of a type is the one extensionFor() picks
+constexpr std::pair<const char *, const char *> kMimeTypes[] = {
+    {".txt", "text/plain"},        {".log", "text/plain"},
+    {".md", "text/markdown"},      {".csv", "text/csv"},
+    {".html", "text/html"},        {".css", "text/css"},
+    {".js", "text/javascript"},    {".c", "text/x-c"},
+    {".h", "text/x-c"},            {".cpp", "text/x-c++"},
+    {".hpp", "text/x-c++"},        {".py", "text/x-python"},
+    {".sh", "text/x-shellscript"}, {".json", "application/json"},
+    {".xml", "application/xml"},   {".yaml", "application/yaml"},
+    {".yml", "application/yaml"},  {".svg", "image/svg+xml"},
+    {".png", "image/png"},         {".jpg", "image/jpeg"},
+    {".jpeg", "image/jpeg"},       {".gif", "image/gif"},
+    {".webp", "image/webp"},       {".pdf", "application/pdf"},
+    {".zip", "application/zip"},   {".gz", "application/gzip"}};
+
+bool isTextMime(const std::string &mime) {
+  return mime.rfind("text/", 0) == 0 || mime == "application/json" ||
+         mime == "application/xml" || mime == "application/yaml" ||
+         mime == "image/svg+xml";
+}
+
+// Validates UTF-8 so text can be embedded in JSON without escaping errors
+bool isValidUtf8(const unsigned char *s, size_t n) {
+  size_t i = 0;
+  while (i < n) {
+    unsigned char c = s[i];
+    size_t extra;
+    if (c < 0x80) {
+      ++i;
+      continue;
+    } else if ((c & 0xe0) == 0xc0 && c >= 0xc2) {
+      extra = 1;
+    } else if ((c & 0xf0) == 0xe0) {
+      extra = 2;
+    } else if ((c & 0xf8) == 0xf0 && c <= 0xf4) {
+      extra = 3;
+    } else {
+      return false;
+    }
+    if (i + extra >= n) return false;
+    for (size_t k = 1; k <= extra; ++k) {
+      if ((s[i + k] & 0xc0) != 0x80) return false;
+    }
+    // Reject overlong forms, surrogates and code points above U+10FFFF
+    unsigned char next = s[i + 1];
+    if ((c == 0xe0 && next < 0xa0) || (c == 0xed && next >= 0xa0) ||
+        (c == 0xf0 && next < 0x90) || (c == 0xf4 && next >= 0x90)) {
+      return false;
+    }
+    i += extra + 1;
+  }
+  return true;
+}
+
+std::string percentDecode(const std::string &in) {
+  std::string out;
+  out.reserve(in.size());
+  for (size_t i = 0; i < in.size(); ++i) {
+    if (in[i] == '%' && i + 2 < in.size() &&
+        std::isxdigit(static_cast<unsigned char>(in[i + 1])) &&
+        std::isxdigit(static_cast<unsigned char>(in[i + 2]))) {
+      out.push_back(static_cast<char>(std::stoi(in.substr(i + 1, 2), nullptr, 16)));
+      i += 2;
+    } else {
+      out.push_back(in[i]);
+    }
+  }
+  return out;
+}
+
+// Whether 'path' lies under 'dir' (compared element by element)
+bool isWithin(const fs::path &path, const fs::path &dir) {
+  auto mismatch = std::mismatch(dir.begin(), dir.end(), path.begin(),
+                                path.end());
+  return mismatch.first == dir.end() && mismatch.second != path.end();
+}
+
+// Append the regular files under 'dir' that sort after 'after' (all of them
+// if it is empty) to 'out' in path order, until 'out' holds 'limit' paths.
+// Only directories that can hold such files are read. Paths compare element
+// by element, so a directory's files sort together and subtrees wholly
+// before 'after' are skipped unread.
+void listAfter(const fs::path &dir, const fs::path &after, size_t limit,
+               std::vector<fs::path> &out) {
+  std::error_code ec;
+  std::vector<fs::directory_entry> entries;
+  for (fs::directory_iterator it(dir, ec), end; !ec && it != end;
+       it.increment(ec)) {
+    entries.push_back(*it);
+  }
+  if (ec) {
+    spdlog::warn("Resource listing skips " + dir.string() + ": " +
+                 ec.message());
+  }
+  std::sort(entries.begin(), entries.end());
+
+  for (const auto &entry : entries) {
+    if (out.size() >= limit) return;
+    const fs::path &path = entry.path();
+    // Symlinked directories are not followed, as they may lead outside
+    if (!entry.is_symlink(ec) && entry.is_directory(ec)) {
+      if (after.empty() || !(path < after) || isWithin(after, path)) {
+        listAfter(path, after, limit, out);
+      }
+    } else if (entry.is_regular_file(ec) && (after.empty() || after < path)) {
+      out.push_back(path);
+    }
+  }
+}
+
+}  // namespace
+
+bool ResourceManager::addRoot(const std::string &dir) {
+  std::error_code ec;
+  fs::path root = fs::canonical(dir, ec);
+  if (ec || !fs::is_directory(root, ec)) {
+    spdlog::error("Resource directory not found: " + dir);
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  roots_.push_back(root.string());
+  spdlog::info("Serving resources from " + root.string());
+  return true;
+}
+
+bool ResourceManager::empty() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return roots_.empty();
+}
+
+std::string ResourceManager::uriForPath(const std::string &path) {
+  static const char kHex[] = "0123456789ABCDEF";
+  std::string uri = kFileScheme;
+  for (unsigned char c : path) {
+    if (std::isalnum(c) || c == '/' || c == '-' || c == '_' || c == '.' ||
+        c == '~') {
+      uri.push_back(static_cast<char>(c));
+    } else {
+      uri.push_back('%');
+      uri.push_back(kHex[c >> 4]);
+      uri.push_back(kHex[c & 0xf]);
+    }
+  }
+  return uri;
+}
+
+std::string ResourceManager::mimeType(const std::string &path) {
+  std::string ext = fs::path(path).extension().string();
+  std::transform(ext.begin(), ext.end(), ext.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  for (const auto &[extension, type] : kMimeTypes) {
+    if (ext == extension) return type;
+  }
+  return "application/octet-stream";
+}
+
+std::string ResourceManager::extensionFor(const std::string &mimeType) {
+  for (const auto &[extension, type] : kMimeTypes) {
+    if (mimeType == type) return extension;
+  }
+  return ".bin";
+}
+
+std::string ResourceManager::resolve(const std::string &uri) const {
+  if (uri.rfind(kFileScheme, 0) != 0) return "";
+  std::error_code ec;
+  fs::path path =
+      fs::weakly_canonical(percentDecode(uri.substr(sizeof(kFileScheme) - 1)), ec);
+  if (ec || !fs::is_regular_file(path, ec)) return "";
+
+  std::string resolved = path.string();
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto &root : roots_) {
+    if (resolved.size() > root.size() && resolved.compare(0, root.size(), root) == 0 &&
+        resolved[root.size()] == static_cast<char>(fs::path::preferred_separator)) {
+      return resolved;
+    }
+  }
+  return "";
+}
+
+json ResourceManager::list(const std::string &cursor) const {
+  std::vector<std::string> roots;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    roots = roots_;
+  }
+  std::sort(roots.begin(), roots.end(),
+            [](const std::string &a, const std::string &b) {
+              return fs::path(a) < fs::path(b);
+            });
+
+  // The cursor is the URI of the last file listed; the page resumes after
+  // it, so files added or removed meanwhile shift nothing
+  fs::path after;
+  if (!cursor.empty()) {
+    if (cursor.rfind(kFileScheme, 0) == 0) {
+      after = percentDecode(cursor.substr(sizeof(kFileScheme) - 1));
+    }
+    bool valid = std::any_of(roots.begin(), roots.end(),
+                             [&after](const std::string &root) {
+                               return isWithin(after, root);
+                             });
+    if (!valid) throw std::runtime_error("Invalid cursor: " + cursor);
+  }
+
+  // One file past the page tells whether there is a next one
+  std::vector<fs::path> files;
+  for (const auto &root : roots) {
+    if (files.size() > kPageSize) break;
+    if (after.empty() || !(fs::path(root) < after) || isWithin(after, root)) {
+      listAfter(root, after, kPageSize + 1, files);
+    }
+  }
+
+  json resources = json::array();
+  size_t end = std::min(files.size(), kPageSize);
+  for (size_t i = 0; i < end; ++i) {
+    std::error_code ec;
+    std::string path = files[i].string();
+    json entry = {{"uri", uriForPath(path)},
+                  {"name", files[i].filename().string()},
+                  {"mimeType", mimeType(path)}};
+    auto size = fs::file_size(files[i], ec);
+    if (!ec) entry["size"] = size;
+    resources.push_back(entry);
+  }
+
+  json result = {{"resources", resources}};
+  if (files.size() > kPageSize) {
+    result["nextCursor"] = resources.back()["uri"];
+  }
+  return result;
+}
+
+std::shared_ptr<OpenFile> ResourceManager::acquire(const std::string &path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = cache_.find(path);
+  if (it != cache_.end()) {
+    if (!(*it->second)->isStale()) {
+      lru_.splice(lru_.begin(), lru_, it->second);
+      return lru_.front();
+    }
+    lru_.erase(it->second);
+    cache_.erase(it);
+  }
+
+  auto file = OpenFile::open(path);
+  lru_.push_front(file);
+  cache_[path] = lru_.begin();
+  if (lru_.size() > kCacheEntries) {
+    // Readers still holding the evicted file keep it open
+    cache_.erase(lru_.back()->path());
+    lru_.pop_back();
+  }
+  return file;
+}
+
+void ResourceManager::invalidate(const std::string &path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = cache_.find(path);
+  if (it == cache_.end()) return;
+  lru_.erase(it->second);
+  cache_.erase(it);
+}
+
+json ResourceManager::read(const std::string &uri, uint64_t offset,
+                           size_t length) {
+  std::string path = resolve(uri);
+  if (path.empty()) throw std::runtime_error("Resource not found: " + uri);
+
+  auto file = acquire(path);
+  size_t size = file->size();
+  if (offset > size) {
+    throw std::runtime_error("Offset beyond end of resource: " + uri);
+  }
+  if (length == 0) length = kDefaultChunkSize;
+  length = std::min(length, kMaxChunkSize);
+  size_t begin = static_cast<size_t>(offset);
+  size_t end = begin + std::min<size_t>(length, size - begin);
+
+  // One byte past the chunk tells whether 'end' splits a UTF-8 sequence
+  std::string data(end - begin + (end < size ? 1 : 0), '\0');
+  size_t got = file->readAt(begin, data.data(), data.size());
+  if (got < data.size()) {
+    // Truncated since it was opened: serve what is left as the end of the
+    // resource, and reopen it next time
+    invalidate(path);
+    size = begin + got;
+    end = std::min(end, size);
+  }
+  const unsigned char *bytes =
+      reinterpret_cast<const unsigned char *>(data.data());
+
+  std::string mime = mimeType(path);
+  bool asText = isTextMime(mime);
+  if (asText && end < size && end - begin < got) {
+    // Do not split a multi-byte UTF-8 sequence across chunks
+    size_t cut = end - begin;
+    while (cut > 0 && (bytes[cut] & 0xc0) == 0x80) --cut;
+    if (cut > 0) end = begin + cut;
+  }
+  if (asText && !isValidUtf8(bytes, end - begin)) asText = false;
+
+  json content = {{"uri", uri}, {"mimeType", mime}};
+  if (asText) {
+    data.resize(end - begin);
+    content["text"] = std::move(data);
+  } else {
+    json blob = std::string();
+    Base64::append(blob.get_ref<std::string &>(), data.data(), end - begin);
+    content["blob"] = std::move(blob);
+  }
+  content["offset"] = begin;
+  content["length"] = end - begin;
+  content["totalSize"] = size;
+  if (end < size) content["nextOffset"] = end;
+
+  return {{"contents", json::array({content})}};
+}
@@ -0,0 +1,204 @@
+#include "resource_watcher.h"
+
+#include <filesystem>
+
+#include "mcp_logger.h"
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#endif
+
+namespace fs = std::filesystem;
+
+#ifndef __linux__
+
+ResourceWatcher::ResourceWatcher(Callback onChanged, Callback onLost)
+    : onChanged_(std::move(onChanged)), onLost_(std::move(onLost)) {}
+
+ResourceWatcher::~ResourceWatcher() = default;
+
+bool ResourceWatcher::watch(const std::string &path) {
+  spdlog::warn("Resource change notifications are not supported here: " +
+               path);
+  return false;
+}
+
+void ResourceWatcher::unwatch(const std::string &) {}
+
+void ResourceWatcher::run() {}
+
+void ResourceWatcher::readEvents(std::chrono::steady_clock::time_point) {}
+
+#else
+
+namespace {
+
+constexpr uint32_t kWatchMask = IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO |
+                                IN_CREATE | IN_DELETE | IN_MOVED_FROM |
+                                IN_ATTRIB;
+
+}  // namespace
+
+ResourceWatcher::ResourceWatcher(Callback onChanged, Callback onLost)
+    : onChanged_(std::move(onChanged)), onLost_(std::move(onLost)) {
+  inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (inotifyFd_ < 0 || wakeFd_ < 0) {
+    spdlog::error("Cannot initialize inotify; resource subscriptions disabled");
+    return;
+  }
+  thread_ = std::thread([this] { run(); });
+}
+
+ResourceWatcher::~ResourceWatcher() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  if (wakeFd_ >= 0) {
+    uint64_t one = 1;
+    (void)!::write(wakeFd_, &one, sizeof(one));
+  }
+  if (thread_.joinable()) thread_.join();
+  if (inotifyFd_ >= 0) ::close(inotifyFd_);
+  if (wakeFd_ >= 0) ::close(wakeFd_);
+}
+
+bool ResourceWatcher::watch(const std::string &path) {
+  if (inotifyFd_ < 0) return false;
+  fs::path file(path);
+  std::string dir = file.parent_path().string();
+  std::string name = file.filename().string();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!watchByDir_.count(dir)) {
+    int wd = inotify_add_watch(inotifyFd_, dir.c_str(), kWatchMask);
+    if (wd < 0) {
+      spdlog::error("inotify_add_watch failed for " + dir);
+      return false;
+    }
+    watchByDir_[dir] = wd;
+    dirsByWatch_[wd] = dir;
+  }
+  filesByDir_[dir].insert(name);
+  return true;
+}
+
+void ResourceWatcher::unwatch(const std::string &path) {
+  if (inotifyFd_ < 0) return;
+  fs::path file(path);
+  std::string dir = file.parent_path().string();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto files = filesByDir_.find(dir);
+  if (files == filesByDir_.end()) return;
+  files->second.erase(file.filename().string());
+  pending_.erase(path);
+  if (!files->second.empty()) return;
+
+  // Last subscribed file in this directory: drop the directory watch
+  filesByDir_.erase(files);
+  auto wd = watchByDir_.find(dir);
+  if (wd != watchByDir_.end()) {
+    inotify_rm_watch(inotifyFd_, wd->second);
+    dirsByWatch_.erase(wd->second);
+    watchByDir_.erase(wd);
+  }
+}
+
+void ResourceWatcher::readEvents(std::chrono::steady_clock::time_point now) {
+  alignas(struct inotify_event) char buffer[16384];
+  for (;;) {
+    ssize_t n = ::read(inotifyFd_, buffer, sizeof(buffer));
+    if (n <= 0) return;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (char *p = buffer; p < buffer + n;) {
+      auto *event = reinterpret_cast<struct inotify_event *>(p);
+      p += sizeof(struct inotify_event) + event->len;
+
+      auto dir = dirsByWatch_.find(event->wd);
+      if (dir == dirsByWatch_.end()) continue;
+      if (event->mask & IN_IGNORED) {
+        // Directory removed; its subscriptions can no longer fire, so hand
+        // them back to the owner
+        auto files = filesByDir_.find(dir->second);
+        if (files != filesByDir_.end()) {
+          for (const auto &name : files->second) {
+            std::string path = (fs::path(dir->second) / name).string();
+            pending_.erase(path);
+            lost_.push_back(std::move(path));
+          }
+          filesByDir_.erase(files);
+        }
+        watchByDir_.erase(dir->second);
+        dirsByWatch_.erase(dir);
+        continue;
+      }
+      if (event->len == 0) continue;
+
+      auto files = filesByDir_.find(dir->second);
+      if (files == filesByDir_.end() || !files->second.count(event->name)) {
+        continue;
+      }
+      if (pending_.empty()) firstEvent_ = now;
+      lastEvent_ = now;
+      pending_.insert((fs::path(dir->second) / event->name).string());
+    }
+  }
+}
+
+void ResourceWatcher::run() {
+  using namespace std::chrono;
+  for (;;) {
+    int timeoutMs = -1;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stopping_) return;
+      if (!pending_.empty()) {
+        auto due = std::min(lastEvent_ + milliseconds(kDebounceMs),
+                            firstEvent_ + milliseconds(kMaxDelayMs));
+        auto wait = duration_cast<milliseconds>(due - steady_clock::now());
+        timeoutMs = std::max<int>(0, static_cast<int>(wait.count()));
+      }
+    }
+
+    struct pollfd fds[2] = {{inotifyFd_, POLLIN, 0}, {wakeFd_, POLLIN, 0}};
+    if (poll(fds, 2, timeoutMs) < 0 && errno != EINTR) {
+      spdlog::error("Resource watcher poll failed; stopping");
+      return;
+    }
+    if (fds[1].revents & POLLIN) {
+      uint64_t value;
+      (void)!::read(wakeFd_, &value, sizeof(value));
+    }
+
+    auto now = steady_clock::now();
+    if (fds[0].revents & POLLIN) readEvents(now);
+
+    std::vector<std::string> batch;
+    std::vector<std::string> lost;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stopping_) return;
+      if (!pending_.empty() &&
+          (now - lastEvent_ >= milliseconds(kDebounceMs) ||
+           now - firstEvent_ >= milliseconds(kMaxDelayMs))) {
+        batch.assign(pending_.begin(), pending_.end());
+        pending_.clear();
+      }
+      lost.swap(lost_);
+    }
+    if (!batch.empty()) onChanged_(batch);
+    if (!lost.empty() && onLost_) onLost_(lost);
+  }
+}
+
+#endif
@@ -0,0 +1,220 @@
+#include "shm_adapter.h"
+
+#include <new>
+#include <stdexcept>
+
+#include "mcp_logger.h"
+
+#ifndef __linux__
+
+std::unique_ptr<ShmTransportSegment> ShmTransportSegment::create(
+    const std::string &name, size_t) {
+  throw std::runtime_error("Shared-memory transport is not supported: " +
+                           name);
+}
+
+std::unique_ptr<ShmTransportSegment> ShmTransportSegment::open(
+    const std::string &name) {
+  throw std::runtime_error("Shared-memory transport is not supported: " +
+                           name);
+}
+
+ShmTransportSegment::~ShmTransportSegment() = default;
+
+std::string ShmTransportSegment::defaultName() { return "/mcp_server"; }
+
+bool ShmTransportSegment::peerAlive(int32_t) { return false; }
+
+#else
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+namespace {
+
+constexpr size_t kHeaderSize = 64;  // keeps the rings cache-line aligned
+static_assert(sizeof(ShmTransportHeader) <= kHeaderSize,
+              "ShmTransportHeader too big");
+
+std::string systemError(const std::string &what, const std::string &name) {
+  return what + " " + name + ": " + std::strerror(errno);
+}
+
+// Whether the segment at 'name' was left behind by a server that has exited.
+// A segment whose creator is still initializing it (no pid yet) is live.
+bool isStale(const std::string &name) {
+  int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) return errno == ENOENT;
+  struct stat st {};
+  bool stale = false;
+  if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= kHeaderSize) {
+    void *base = mmap(nullptr, kHeaderSize, PROT_READ, MAP_SHARED, fd, 0);
+    if (base != MAP_FAILED) {
+      auto *header = static_cast<ShmTransportHeader *>(base);
+      int32_t pid = header->serverPid.load(std::memory_order_acquire);
+      stale = pid != 0 && pid != getpid() &&
+              !ShmTransportSegment::peerAlive(pid);
+      munmap(base, kHeaderSize);
+    }
+  }
+  ::close(fd);
+  return stale;
+}
+
+}  // namespace
+
+std::string ShmTransportSegment::defaultName() {
+  return "/mcp_server-" + std::to_string(getpid());
+}
+
+std::unique_ptr<ShmTransportSegment> ShmTransportSegment::create(
+    const std::string &name, size_t ringCapacity) {
+  size_t ringSize = ShmRing::regionSize(ringCapacity);
+  size_t size = kHeaderSize + 2 * ringSize;
+
+  // Never take over a live server's segment; only one left behind by a
+  // server that crashed is reclaimed
+  int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0 && errno == EEXIST) {
+    if (!isStale(name)) {
+      throw std::runtime_error("Shared-memory segment " + name +
+                               " is in use by another server");
+    }
+    spdlog::warn("Reclaiming stale shared-memory segment " + name);
+    shm_unlink(name.c_str());
+    fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  }
+  if (fd < 0) throw std::runtime_error(systemError("Cannot create", name));
+  struct stat st {};
+  if (fstat(fd, &st) != 0 ||
+      ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    std::string error = systemError("Cannot size", name);
+    ::close(fd);
+    shm_unlink(name.c_str());
+    throw std::runtime_error(error);
+  }
+  void *base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (base == MAP_FAILED) {
+    std::string error = systemError("Cannot map", name);
+    shm_unlink(name.c_str());
+    throw std::runtime_error(error);
+  }
+
+  std::unique_ptr<ShmTransportSegment> segment(new ShmTransportSegment());
+  segment->name_ = name;
+  segment->owner_ = true;
+  segment->device_ = st.st_dev;
+  segment->inode_ = st.st_ino;
+  segment->base_ = base;
+  segment->size_ = size;
+
+  char *bytes = static_cast<char *>(base);
+  segment->requests_ = ShmRing::create(bytes + kHeaderSize, ringCapacity);
+  segment->responses_ =
+      ShmRing::create(bytes + kHeaderSize + ringSize, ringCapacity);
+  auto *header = new (base) ShmTransportHeader();
+  header->version = ShmTransportHeader::kVersion;
+  header->ringCapacity = ringCapacity;
+  header->serverPid.store(getpid());
+  header->clientPid.store(0);
+  // Written last: a client only trusts the segment once the magic is there
+  __atomic_store_n(&header->magic, ShmTransportHeader::kMagic,
+                   __ATOMIC_RELEASE);
+  segment->header_ = header;
+  return segment;
+}
+
+std::unique_ptr<ShmTransportSegment> ShmTransportSegment::open(
+    const std::string &name) {
+  int fd = shm_open(name.c_str(), O_RDWR, 0);
+  if (fd < 0) throw std::runtime_error(systemError("Cannot open", name));
+  struct stat st {};
+  if (fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < kHeaderSize) {
+    ::close(fd);
+    throw std::runtime_error("Not a transport segment: " + name);
+  }
+  size_t size = static_cast<size_t>(st.st_size);
+  void *base = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (base == MAP_FAILED) {
+    throw std::runtime_error(systemError("Cannot map", name));
+  }
+
+  std::unique_ptr<ShmTransportSegment> segment(new ShmTransportSegment());
+  segment->name_ = name;
+  segment->base_ = base;
+  segment->size_ = size;
+  auto *header = static_cast<ShmTransportHeader *>(base);
+  size_t ringSize = ShmRing::regionSize(header->ringCapacity);
+  if (__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) !=
+          ShmTransportHeader::kMagic ||
+      header->version != ShmTransportHeader::kVersion ||
+      size < kHeaderSize + 2 * ringSize) {
+    throw std::runtime_error("Not a transport segment: " + name);
+  }
+  char *bytes = static_cast<char *>(base);
+  segment->header_ = header;
+  segment->requests_ = ShmRing::attach(bytes + kHeaderSize);
+  segment->responses_ = ShmRing::attach(bytes + kHeaderSize + ringSize);
+  return segment;
+}
+
+ShmTransportSegment::~ShmTransportSegment() {
+  if (base_) munmap(base_, size_);
+  if (!owner_) return;
+  // Unlink the name only while it still refers to our segment: another
+  // server may have reclaimed it after a hang was taken for a crash
+  int fd = shm_open(name_.c_str(), O_RDONLY, 0);
+  if (fd < 0) return;
+  struct stat st {};
+  bool ours = fstat(fd, &st) == 0 && st.st_dev == device_ &&
+              st.st_ino == inode_;
+  ::close(fd);
+  if (ours) shm_unlink(name_.c_str());
+}
+
+bool ShmTransportSegment::peerAlive(int32_t pid) {
+  if (pid == 0) return true;
+  return kill(pid, 0) == 0 || errno == EPERM;
+}
+
+#endif
+
+ShmAdapter::ShmAdapter(const std::string &name, size_t ringCapacity,
+                       size_t maxMessageSize)
+    : segment_(ShmTransportSegment::create(
+          name.empty() ? ShmTransportSegment::defaultName() : name,
+          ringCapacity)),
+      maxMessageSize_(maxMessageSize) {
+  spdlog::info("Shared-memory transport listening on " + segment_->name());
+}
+
+ShmAdapter::~ShmAdapter() {
+  segment_->requests().close();
+  segment_->responses().close();
+}
+
+bool ShmAdapter::clientAlive() {
+  return ShmTransportSegment::peerAlive(
+      segment_->header().clientPid.load(std::memory_order_acquire));
+}
+
+bool ShmAdapter::readMessage(std::string &message) {
+  // Ends when the client closes its ring, dies without doing so, or sends
+  // a message over the limit
+  return segment_->requests().read(
+      message, [this] { return clientAlive(); }, maxMessageSize_);
+}
+
+bool ShmAdapter::writeMessage(const std::string &message) {
+  std::lock_guard<std::mutex> lock(writeMutex_);
+  return segment_->responses().write(message,
+                                     [this] { return clientAlive(); });
+}
@@ -0,0 +1,65 @@
+#include "shm_client.h"
+
+#include <stdexcept>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+ShmClient::ShmClient(const std::string &name)
+    : segment_(ShmTransportSegment::open(name)) {
+#ifdef __linux__
+  int32_t expected = 0;
+  if (!segment_->header().clientPid.compare_exchange_strong(expected,
+                                                            getpid())) {
+    throw std::runtime_error("Another client is attached to " + name);
+  }
+#endif
+}
+
+ShmClient::~ShmClient() {
+  // Closing the request ring is the server's end of input
+  segment_->requests().close();
+  segment_->responses().close();
+}
+
+bool ShmClient::serverAlive() {
+  return ShmTransportSegment::peerAlive(
+      segment_->header().serverPid.load(std::memory_order_acquire));
+}
+
+bool ShmClient::send(const std::string &message) {
+  std::lock_guard<std::mutex> lock(sendMutex_);
+  return segment_->requests().write(message,
+                                    [this] { return serverAlive(); });
+}
+
+bool ShmClient::receive(std::string &message) {
+  return segment_->responses().read(message,
+                                    [this] { return serverAlive(); });
+}
+
+json ShmClient::call(const std::string &method, const json &params) {
+  int64_t id = ++nextId_;
+  json request = {
+      {"jsonrpc", "2.0"}, {"id", id}, {"method", method}, {"params", params}};
+  if (!send(request.dump())) {
+    throw std::runtime_error("Server disconnected");
+  }
+
+  std::string message;
+  while (receive(message)) {
+    json response = json::parse(message, nullptr, false);
+    if (response.is_discarded() || !response.contains("id") ||
+        response["id"] != id) {
+      continue;
+    }
+    if (response.contains("error")) {
+      const json &error = response["error"];
+      throw McpError(error.value("code", -32603),
+                     error.value("message", std::string("Unknown error")));
+    }
+    return response.value("result", json::object());
+  }
+  throw std::runtime_error("Server disconnected");
+}
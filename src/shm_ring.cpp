@@ -0,0 +1,213 @@
+#include "shm_ring.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <new>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "ShmRing needs lock-free 64-bit atomics in shared memory");
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+              "ShmRing needs lock-free 32-bit atomics in shared memory");
+
+namespace {
+
+constexpr size_t kHeaderSize = 64;  // keep the data area cache-line aligned
+static_assert(sizeof(ShmRingHeader) <= kHeaderSize, "ShmRingHeader too big");
+
+void futexWait(std::atomic<uint32_t> *word, uint32_t expected, int timeoutMs) {
+#ifdef __linux__
+  struct timespec ts;
+  ts.tv_sec = timeoutMs / 1000;
+  ts.tv_nsec = static_cast<long>(timeoutMs % 1000) * 1000000L;
+  // Not FUTEX_PRIVATE: the word is shared with another process
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAIT, expected,
+          &ts, nullptr, 0);
+#else
+  (void)word;
+  (void)expected;
+  (void)timeoutMs;
+#endif
+}
+
+void futexWake(std::atomic<uint32_t> *word) {
+#ifdef __linux__
+  syscall(SYS_futex, reinterpret_cast<uint32_t *>(word), FUTEX_WAKE, INT_MAX,
+          nullptr, nullptr, 0);
+#else
+  (void)word;
+#endif
+}
+
+void notify(std::atomic<uint32_t> &seq, std::atomic<uint32_t> &waiters) {
+  seq.fetch_add(1, std::memory_order_seq_cst);
+  if (waiters.load(std::memory_order_seq_cst) != 0) futexWake(&seq);
+}
+
+// Sleep on 'seq' until 'ready' holds, the ring closes or the predicate gives
+// up. Returns true if the caller should re-check the ring.
+template <typename Ready>
+bool waitFor(std::atomic<uint32_t> &seq, std::atomic<uint32_t> &waiters,
+             const std::atomic<uint32_t> &closed, Ready ready,
+             const ShmRing::WaitPredicate &keepWaiting) {
+  uint32_t observed = seq.load(std::memory_order_seq_cst);
+  waiters.fetch_add(1, std::memory_order_seq_cst);
+  if (!ready() && !closed.load(std::memory_order_acquire)) {
+    futexWait(&seq, observed, ShmRing::kWaitSliceMs);
+  }
+  waiters.fetch_sub(1, std::memory_order_seq_cst);
+  if (ready()) return true;
+  if (closed.load(std::memory_order_acquire)) return false;
+  return !keepWaiting || keepWaiting();
+}
+
+}  // namespace
+
+uint32_t ShmRing::roundCapacity(size_t capacity) {
+  uint32_t rounded = 4096;
+  while (rounded < capacity && rounded < (1u << 30)) rounded <<= 1;
+  return rounded;
+}
+
+size_t ShmRing::regionSize(size_t capacity) {
+  return kHeaderSize + roundCapacity(capacity);
+}
+
+ShmRing ShmRing::create(void *region, size_t capacity) {
+  auto *header = new (region) ShmRingHeader();
+  header->head.store(0);
+  header->tail.store(0);
+  header->dataSeq.store(0);
+  header->spaceSeq.store(0);
+  header->dataWaiters.store(0);
+  header->spaceWaiters.store(0);
+  header->closed.store(0);
+  header->capacity = roundCapacity(capacity);
+  return attach(region);
+}
+
+ShmRing ShmRing::attach(void *region) {
+  ShmRing ring;
+  ring.header_ = static_cast<ShmRingHeader *>(region);
+  ring.data_ = static_cast<char *>(region) + kHeaderSize;
+  ring.capacity_ = ring.header_->capacity;
+  return ring;
+}
+
+bool ShmRing::write(const char *data, size_t size,
+                    const WaitPredicate &keepWaiting) {
+  uint64_t length = size;
+  return writeBytes(reinterpret_cast<const char *>(&length), sizeof(length),
+                    keepWaiting) &&
+         writeBytes(data, size, keepWaiting);
+}
+
+bool ShmRing::read(std::string &message, const WaitPredicate &keepWaiting,
+                   size_t maxSize) {
+  uint64_t length = 0;
+  if (!readBytes(reinterpret_cast<char *>(&length), sizeof(length),
+                 keepWaiting)) {
+    return false;
+  }
+  if (length > maxSize) {
+    close();
+    return false;
+  }
+
+  // Grow a ring's worth at a time so a bogus length costs nothing up front
+  message.clear();
+  while (message.size() < length) {
+    size_t offset = message.size();
+    size_t chunk =
+        static_cast<size_t>(std::min<uint64_t>(length - offset, capacity_));
+    message.resize(offset + chunk);
+    if (!readBytes(message.data() + offset, chunk, keepWaiting)) return false;
+  }
+  return true;
+}
+
+bool ShmRing::writeBytes(const char *src, size_t size,
+                         const WaitPredicate &keepWaiting) {
+  ShmRingHeader &h = *header_;
+  const uint64_t capacity = capacity_;
+  while (size > 0) {
+    if (h.closed.load(std::memory_order_acquire)) return false;
+    uint64_t head = h.head.load(std::memory_order_relaxed);
+    uint64_t tail = h.tail.load(std::memory_order_acquire);
+    if (head - tail > capacity) return false;  // corrupted by the consumer
+    uint64_t space = capacity - (head - tail);
+    if (space == 0) {
+      auto ready = [&] {
+        return h.tail.load(std::memory_order_acquire) != tail;
+      };
+      if (!waitFor(h.spaceSeq, h.spaceWaiters, h.closed, ready, keepWaiting)) {
+        return false;
+      }
+      continue;
+    }
+
+    size_t chunk = static_cast<size_t>(std::min<uint64_t>(space, size));
+    size_t offset = static_cast<size_t>(head & (capacity - 1));
+    size_t first = std::min<size_t>(chunk, capacity - offset);
+    std::memcpy(data_ + offset, src, first);
+    std::memcpy(data_, src + first, chunk - first);
+    h.head.store(head + chunk, std::memory_order_release);
+    notify(h.dataSeq, h.dataWaiters);
+
+    src += chunk;
+    size -= chunk;
+  }
+  return true;
+}
+
+bool ShmRing::readBytes(char *dst, size_t size,
+                        const WaitPredicate &keepWaiting) {
+  ShmRingHeader &h = *header_;
+  const uint64_t capacity = capacity_;
+  while (size > 0) {
+    uint64_t tail = h.tail.load(std::memory_order_relaxed);
+    uint64_t head = h.head.load(std::memory_order_acquire);
+    uint64_t available = head - tail;
+    if (available > capacity) return false;  // corrupted by the producer
+    if (available == 0) {
+      auto ready = [&] {
+        return h.head.load(std::memory_order_acquire) != head;
+      };
+      if (!waitFor(h.dataSeq, h.dataWaiters, h.closed, ready, keepWaiting)) {
+        return false;
+      }
+      continue;
+    }
+
+    size_t chunk = static_cast<size_t>(std::min<uint64_t>(available, size));
+    size_t offset = static_cast<size_t>(tail & (capacity - 1));
+    size_t first = std::min<size_t>(chunk, capacity - offset);
+    std::memcpy(dst, data_ + offset, first);
+    std::memcpy(dst + first, data_, chunk - first);
+    h.tail.store(tail + chunk, std::memory_order_release);
+    notify(h.spaceSeq, h.spaceWaiters);
+
+    dst += chunk;
+    size -= chunk;
+  }
+  return true;
+}
+
+void ShmRing::close() {
+  header_->closed.store(1, std::memory_order_release);
+  notify(header_->dataSeq, header_->dataWaiters);
+  notify(header_->spaceSeq, header_->spaceWaiters);
+}
+
+void ShmRing::reset() {
+  header_->head.store(0);
+  header_->tail.store(0);
+  header_->closed.store(0);
+}
@@ -0,0 +1,294 @@
+#include "spill_store.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include "mcp_logger.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#else
+#include <chrono>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Distinct results whose hash and size collide get numbered names; more
+// than this many is certainly an attack
+constexpr int kMaxCollisions = 16;
+
+// Fresh directory only this process knows about
+std::string createPrivateDir() {
+  std::error_code ec;
+  fs::path base;
+  if (const char *runtime = std::getenv("XDG_RUNTIME_DIR")) {
+    if (*runtime && fs::is_directory(runtime, ec)) base = runtime;
+  }
+  if (base.empty()) base = fs::temp_directory_path(ec);
+  if (ec) throw std::runtime_error("No temp directory for spilled results");
+
+#ifndef _WIN32
+  std::string dir = (base / "mcp-spill-XXXXXX").string();
+  if (!mkdtemp(dir.data())) {  // mode 0700
+    throw std::runtime_error("Cannot create spill directory under " +
+                             base.string() + ": " + std::strerror(errno));
+  }
+#else
+  std::string dir =
+      (base / ("mcp-spill-" +
+               std::to_string(std::chrono::steady_clock::now()
+                                  .time_since_epoch()
+                                  .count())))
+          .string();
+  if (!fs::create_directory(dir, ec) || ec) {
+    throw std::runtime_error("Cannot create spill directory: " + dir);
+  }
+#endif
+  return dir;
+}
+
+// Refuse a directory another user could read or swap out; tighten our own
+void checkPrivateDir(const std::string &dir) {
+#ifndef _WIN32
+  struct stat st;
+  if (lstat(dir.c_str(), &st) != 0) {
+    throw std::runtime_error("Cannot stat spill directory: " + dir);
+  }
+  if (S_ISLNK(st.st_mode) || !S_ISDIR(st.st_mode)) {
+    throw std::runtime_error("Spill directory is not a directory: " + dir);
+  }
+  if (st.st_uid != geteuid()) {
+    throw std::runtime_error("Spill directory is owned by another user: " +
+                             dir);
+  }
+  if ((st.st_mode & 077) != 0 && chmod(dir.c_str(), 0700) != 0) {
+    throw std::runtime_error("Cannot restrict spill directory: " + dir);
+  }
+#else
+  (void)dir;
+#endif
+}
+
+// Create 'path' (which must not exist) holding 'data', readable only by us
+void writeNewFile(const std::string &path, std::string_view data) {
+#ifndef _WIN32
+  int fd = ::open(path.c_str(),
+                  O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0600);
+  if (fd < 0) throw std::runtime_error("Failed to create spill file: " + path);
+  size_t done = 0;
+  while (done < data.size()) {
+    ssize_t n = ::write(fd, data.data() + done, data.size() - done);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    done += static_cast<size_t>(n);
+  }
+  if (::close(fd) != 0 || done != data.size()) {
+    ::unlink(path.c_str());
+    throw std::runtime_error("Failed to write spill file: " + path);
+  }
+#else
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(data.data(), static_cast<std::streamsize>(data.size()));
+  if (!out) {
+    std::error_code ec;
+    fs::remove(path, ec);
+    throw std::runtime_error("Failed to write spill file: " + path);
+  }
+#endif
+}
+
+// Whether the file at 'path' holds exactly 'data'
+bool sameContents(const std::string &path, std::string_view data) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in) return false;
+  std::vector<char> buffer(64 << 10);
+  size_t offset = 0;
+  while (in) {
+    in.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    size_t n = static_cast<size_t>(in.gcount());
+    if (n == 0) break;
+    if (n > data.size() - offset ||
+        std::memcmp(buffer.data(), data.data() + offset, n) != 0) {
+      return false;
+    }
+    offset += n;
+  }
+  return offset == data.size();
+}
+
+}  // namespace
+
+SpillStore::SpillStore(const std::string &dir, uint64_t maxBytes)
+    : maxBytes_(maxBytes) {
+  std::error_code ec;
+  std::string path = dir;
+  if (path.empty()) {
+    path = createPrivateDir();
+    owned_ = true;
+  } else {
+    fs::create_directories(path, ec);
+    checkPrivateDir(path);
+  }
+  fs::path root = fs::canonical(path, ec);
+  if (ec || !fs::is_directory(root, ec)) {
+    throw std::runtime_error("Cannot create spill directory: " + path);
+  }
+  dir_ = root.string();
+
+  // Adopt results spilled by earlier runs, oldest first in eviction order;
+  // leftover temp files from interrupted writes are removed
+  std::vector<std::pair<fs::file_time_type, fs::path>> existing;
+  for (fs::directory_iterator it(root, ec), end; !ec && it != end;
+       it.increment(ec)) {
+    if (!it->is_regular_file(ec) || it->is_symlink(ec)) continue;
+    if (it->path().extension() == ".tmp") {
+      fs::remove(it->path(), ec);
+      continue;
+    }
+    existing.emplace_back(it->last_write_time(ec), it->path());
+  }
+  std::sort(existing.begin(), existing.end());
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto &[mtime, file] : existing) {
+    uint64_t size = fs::file_size(file, ec);
+    if (ec) continue;
+    lru_.emplace_front(file.string(), size);
+    files_[file.string()] = lru_.begin();
+    totalBytes_ += size;
+  }
+  evictLocked("");
+  spdlog::info("Spilling large tool results to " + dir_);
+}
+
+SpillStore::~SpillStore() {
+  if (!owned_) return;
+  std::error_code ec;
+  fs::remove_all(dir_, ec);
+}
+
+uint64_t SpillStore::fnv1a(const char *data, size_t size) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+std::string SpillStore::store(std::string_view data,
+                              const std::string &extension) {
+  char name[64];
+  snprintf(name, sizeof(name), "%016llx-%llu",
+           static_cast<unsigned long long>(fnv1a(data.data(), data.size())),
+           static_cast<unsigned long long>(data.size()));
+
+  // FNV-1a is easy to collide on purpose: a file with the right name is only
+  // reused when its bytes match, otherwise the next numbered name is tried
+  for (int attempt = 0; attempt < kMaxCollisions; ++attempt) {
+    std::string base = name;
+    if (attempt > 0) {
+      base += '-';
+      base += std::to_string(attempt);
+    }
+    std::string path = (fs::path(dir_) / (base + extension)).string();
+
+    bool known;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      known = files_.count(path) > 0;
+    }
+    if (known) {
+      std::error_code ec;
+      bool exists = fs::exists(path, ec);
+      if (exists && sameContents(path, data)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = files_.find(path);
+        if (it != files_.end()) lru_.splice(lru_.begin(), lru_, it->second);
+        return path;
+      }
+      if (exists) continue;  // a different result with the same name
+      // Deleted behind our back; forget it and write it again
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = files_.find(path);
+      if (it != files_.end()) {
+        totalBytes_ -= it->second->second;
+        lru_.erase(it->second);
+        files_.erase(it);
+      }
+    }
+
+    // Write to a temp file and publish it whole so readers never see a
+    // partial result
+    std::string tmp;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      tmp = path + "." + std::to_string(++sequence_) + ".tmp";
+    }
+    writeNewFile(tmp, data);
+    std::error_code ec;
+#ifndef _WIN32
+    // link() rather than rename() so a concurrent store of a colliding
+    // result is never silently replaced
+    int linked = ::link(tmp.c_str(), path.c_str());
+    int linkErrno = errno;
+    fs::remove(tmp, ec);
+    if (linked != 0 && linkErrno == EEXIST) {
+      if (!sameContents(path, data)) continue;
+    } else if (linked != 0) {
+      throw std::runtime_error("Failed to write spill file: " + path);
+    }
+#else
+    fs::rename(tmp, path, ec);
+    if (ec) {
+      fs::remove(tmp, ec);
+      throw std::runtime_error("Failed to write spill file: " + path);
+    }
+#endif
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!files_.count(path)) {
+      lru_.emplace_front(path, data.size());
+      files_[path] = lru_.begin();
+      totalBytes_ += data.size();
+    }
+    evictLocked(path);
+    return path;
+  }
+  throw std::runtime_error("Too many colliding spill files for " +
+                           std::string(name));
+}
+
+void SpillStore::evictLocked(const std::string &keep) {
+  while (totalBytes_ > maxBytes_ && !lru_.empty()) {
+    auto &[path, size] = lru_.back();
+    if (path == keep) break;  // the only file left
+    std::error_code ec;
+    fs::remove(path, ec);
+    totalBytes_ -= size;
+    files_.erase(path);
+    lru_.pop_back();
+  }
+}
+
+uint64_t SpillStore::totalBytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return totalBytes_;
+}
+
+size_t SpillStore::fileCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return files_.size();
+}
@@ -29,6 +29,7 @@ void StdioAdapter::log(const std::string& direction, const std::string& msg) {
 #else
   localtime_r(&now_c, &tm);
 #endif
+  std::lock_guard<std::mutex> lock(logMutex_);
   logFile_ << std::put_time(&tm, "%Y-%m-%d %H:%M:%S") << " [" << direction
            << "] " << msg << std::endl;
   logFile_.flush();
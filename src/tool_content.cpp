@@ -0,0 +1,111 @@
+#include "tool_content.h"
+
+#include "base64.h"
+
+namespace ToolContent {
+
+json text(std::string text) {
+  return {{"type", "text"}, {"text", std::move(text)}};
+}
+
+json image(std::vector<uint8_t> data, const std::string &mimeType) {
+  return {{"type", "image"},
+          {"data", json::binary(std::move(data))},
+          {"mimeType", mimeType}};
+}
+
+json audio(std::vector<uint8_t> data, const std::string &mimeType) {
+  return {{"type", "audio"},
+          {"data", json::binary(std::move(data))},
+          {"mimeType", mimeType}};
+}
+
+json blob(const std::string &uri, std::vector<uint8_t> data,
+          const std::string &mimeType) {
+  return {{"type", "resource"},
+          {"resource",
+           {{"uri", uri},
+            {"mimeType", mimeType},
+            {"blob", json::binary(std::move(data))}}}};
+}
+
+json resource(const std::string &uri, std::string text,
+              const std::string &mimeType) {
+  return {{"type", "resource"},
+          {"resource",
+           {{"uri", uri}, {"mimeType", mimeType}, {"text", std::move(text)}}}};
+}
+
+json result(json items, bool isError) {
+  if (!items.is_array()) items = json::array({std::move(items)});
+  json result = {{"content", std::move(items)}, {kResultMarker, true}};
+  if (isError) result["isError"] = true;
+  return result;
+}
+
+bool isResult(const json &value) {
+  if (!value.is_object()) return false;
+  auto marker = value.find(kResultMarker);
+  if (marker == value.end() || *marker != true) return false;
+  auto it = value.find("content");
+  return it != value.end() && it->is_array();
+}
+
+namespace {
+
+bool isContentItem(const json &item) {
+  if (!item.is_object()) return false;
+  auto type = item.find("type");
+  return type != item.end() &&
+         (*type == "text" || *type == "image" || *type == "audio" ||
+          *type == "resource" || *type == "resource_link");
+}
+
+// 'item' as one of the types protocol 2024-11-05 defines; 'position' (from
+// 1) names audio by its place in the result
+void downgrade(json &item, size_t position) {
+  const std::string &type = item["type"].get_ref<const std::string &>();
+  if (type == "audio") {
+    json resource = {
+        {"uri", "urn:mcp:audio:" + std::to_string(position)},
+        {"mimeType", item.value("mimeType", "application/octet-stream")},
+        {"blob", std::move(item["data"])}};
+    item = {{"type", "resource"}, {"resource", std::move(resource)}};
+  } else if (type == "resource_link") {
+    std::string uri = item.value("uri", std::string());
+    item = text(item.value("name", uri) +
+                ": read it with resources/read from " + uri);
+  }
+}
+
+}  // namespace
+
+void finishResult(json &result) {
+  result.erase(kResultMarker);
+  size_t position = 0;
+  for (auto &item : result["content"]) {
+    ++position;
+    if (!isContentItem(item)) {
+      encodeBinary(item);
+      item = text(item.dump());
+    } else {
+      downgrade(item, position);
+    }
+  }
+}
+
+void encodeBinary(json &value) {
+  if (value.is_binary()) {
+    // Encoded straight into the string's buffer, then swapped in: no
+    // temporary copy of either the bytes or the text
+    const json::binary_t &bytes = value.get_binary();
+    json encoded = std::string();
+    Base64::append(encoded.get_ref<std::string &>(), bytes.data(),
+                   bytes.size());
+    value = std::move(encoded);
+  } else if (value.is_structured()) {
+    for (auto &child : value) encodeBinary(child);
+  }
+}
+
+}  // namespace ToolContent
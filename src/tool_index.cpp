@@ -0,0 +1,241 @@
+#include "tool_index.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <functional>
+
+#include "mcp_tool.h"
+
+namespace {
+
+constexpr float kNameWeight = 3.0f;
+constexpr float kPropertyWeight = 1.5f;
+constexpr float kDescriptionWeight = 1.0f;
+
+// Fold simple plurals so "files" matches "file"
+std::string normalizeTerm(std::string term) {
+  if (term.size() > 3 && term.back() == 's' && term[term.size() - 2] != 's') {
+    term.pop_back();
+  }
+  return term;
+}
+
+void addTerms(std::unordered_map<std::string, float>& terms,
+              const std::string& text, float weight) {
+  for (const auto& term : ToolIndex::tokenize(text)) {
+    terms[term] += weight;
+  }
+}
+
+// Collect property names from a JSON schema, descending into nested objects
+// and array items
+void addSchemaTerms(std::unordered_map<std::string, float>& terms,
+                    const json& schema) {
+  if (!schema.is_object()) return;
+  auto props = schema.find("properties");
+  if (props != schema.end() && props->is_object()) {
+    for (const auto& [propName, propSchema] : props->items()) {
+      addTerms(terms, propName, kPropertyWeight);
+      addSchemaTerms(terms, propSchema);
+    }
+  }
+  auto items = schema.find("items");
+  if (items != schema.end()) addSchemaTerms(terms, *items);
+}
+
+}  // namespace
+
+std::vector<std::string> ToolIndex::tokenize(const std::string& text) {
+  std::vector<std::string> terms;
+  std::string current;
+  auto flush = [&]() {
+    if (!current.empty()) {
+      terms.push_back(normalizeTerm(std::move(current)));
+      current.clear();
+    }
+  };
+  for (size_t i = 0; i < text.size(); ++i) {
+    unsigned char c = static_cast<unsigned char>(text[i]);
+    if (!std::isalnum(c)) {
+      flush();
+      continue;
+    }
+    // camelCase boundary: lower/digit followed by upper
+    if (std::isupper(c) && !current.empty() &&
+        !std::isupper(static_cast<unsigned char>(text[i - 1]))) {
+      flush();
+    }
+    current.push_back(static_cast<char>(std::tolower(c)));
+  }
+  flush();
+  return terms;
+}
+
+size_t ToolIndex::shardOf(const std::string& key) {
+  return std::hash<std::string>{}(key) % kShards;
+}
+
+uint64_t ToolIndex::newOwner() {
+  // 0 is never an owner, so zero-initialized tags are never owned
+  static std::atomic<uint64_t> next{1};
+  return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+ToolIndex::ToolIndex(const ToolIndex& other)
+    : freeIds_(other.freeIds_),
+      nextId_(other.nextId_),
+      size_(other.size_) {
+  for (size_t i = 0; i < kShards; ++i) {
+    if (other.postings_[i]) {
+      postings_[i] = std::make_shared<PostingShard>(*other.postings_[i]);
+      postingOwners_[i] = owner_;
+    }
+    if (other.docs_[i]) {
+      docs_[i] = std::make_shared<DocShard>(*other.docs_[i]);
+      docOwners_[i] = owner_;
+    }
+  }
+  names_.reserve(other.names_.size());
+  for (const auto& chunk : other.names_) {
+    names_.push_back(chunk ? std::make_shared<NameChunk>(*chunk) : nullptr);
+  }
+  nameOwners_.assign(names_.size(), owner_);
+}
+
+ToolIndex& ToolIndex::operator=(const ToolIndex& other) {
+  if (this != &other) *this = ToolIndex(other);
+  return *this;
+}
+
+ToolIndex ToolIndex::fork() const {
+  // The fork's owner_ is fresh, so it owns none of the shards it shares
+  ToolIndex forked;
+  forked.postings_ = postings_;
+  forked.docs_ = docs_;
+  forked.names_ = names_;
+  forked.postingOwners_ = postingOwners_;
+  forked.docOwners_ = docOwners_;
+  forked.nameOwners_ = nameOwners_;
+  forked.freeIds_ = freeIds_;
+  forked.nextId_ = nextId_;
+  forked.size_ = size_;
+  return forked;
+}
+
+template <typename Shard>
+Shard& ToolIndex::writable(std::shared_ptr<Shard>& shard, uint64_t& owner) {
+  // A shard this index created or cloned is not shared with any fork taken
+  // before, so it is safe to change in place
+  if (!shard) {
+    shard = std::make_shared<Shard>();
+    owner = owner_;
+  } else if (owner != owner_) {
+    shard = std::make_shared<Shard>(*shard);
+    owner = owner_;
+  }
+  return *shard;
+}
+
+void ToolIndex::addTool(const McpTool& tool) {
+  removeTool(tool.name);
+
+  std::unordered_map<std::string, float> terms;
+  addTerms(terms, tool.name, kNameWeight);
+  addTerms(terms, tool.description, kDescriptionWeight);
+  addSchemaTerms(terms, tool.inputSchema);
+
+  uint32_t doc;
+  if (!freeIds_.empty()) {
+    doc = freeIds_.back();
+    freeIds_.pop_back();
+  } else {
+    doc = nextId_++;
+    if (doc / kNameChunk >= names_.size()) {
+      names_.emplace_back();
+      nameOwners_.push_back(0);
+    }
+  }
+  size_t chunk = doc / kNameChunk;
+  writable(names_[chunk], nameOwners_[chunk])[doc % kNameChunk] = tool.name;
+
+  size_t docShard = shardOf(tool.name);
+  Doc& entry = writable(docs_[docShard], docOwners_[docShard])[tool.name];
+  entry.id = doc;
+  entry.terms.reserve(terms.size());
+  for (const auto& [term, weight] : terms) {
+    size_t shard = shardOf(term);
+    writable(postings_[shard], postingOwners_[shard])[term].push_back(
+        {doc, weight});
+    entry.terms.push_back(term);
+  }
+  ++size_;
+}
+
+void ToolIndex::removeTool(const std::string& name) {
+  size_t docShard = shardOf(name);
+  if (!docs_[docShard] || !docs_[docShard]->count(name)) return;
+  DocShard& docs = writable(docs_[docShard], docOwners_[docShard]);
+  auto it = docs.find(name);
+  uint32_t doc = it->second.id;
+
+  for (const auto& term : it->second.terms) {
+    size_t index = shardOf(term);
+    PostingShard& shard = writable(postings_[index], postingOwners_[index]);
+    auto postingIt = shard.find(term);
+    if (postingIt == shard.end()) continue;
+    auto& list = postingIt->second;
+    list.erase(std::remove_if(list.begin(), list.end(),
+                              [doc](const Posting& p) { return p.doc == doc; }),
+               list.end());
+    if (list.empty()) shard.erase(postingIt);
+  }
+
+  size_t chunk = doc / kNameChunk;
+  writable(names_[chunk], nameOwners_[chunk])[doc % kNameChunk].clear();
+  docs.erase(it);
+  freeIds_.push_back(doc);
+  --size_;
+}
+
+std::vector<ToolIndex::Hit> ToolIndex::search(const std::string& query,
+                                              size_t limit) const {
+  std::vector<Hit> hits;
+  if (limit == 0 || size_ == 0) return hits;
+
+  auto queryTerms = tokenize(query);
+  std::sort(queryTerms.begin(), queryTerms.end());
+  queryTerms.erase(std::unique(queryTerms.begin(), queryTerms.end()),
+                   queryTerms.end());
+
+  const double docCount = static_cast<double>(size_);
+  std::unordered_map<uint32_t, double> scores;
+  for (const auto& term : queryTerms) {
+    const auto& shard = postings_[shardOf(term)];
+    if (!shard) continue;
+    auto it = shard->find(term);
+    if (it == shard->end()) continue;
+    const auto& list = it->second;
+    double idf = std::log(1.0 + docCount / static_cast<double>(list.size()));
+    for (const auto& posting : list) {
+      scores[posting.doc] += posting.weight * idf;
+    }
+  }
+
+  hits.reserve(scores.size());
+  for (const auto& [doc, score] : scores) {
+    hits.push_back({(*names_[doc / kNameChunk])[doc % kNameChunk], score});
+  }
+
+  auto better = [](const Hit& a, const Hit& b) {
+    return a.score != b.score ? a.score > b.score : a.name < b.name;
+  };
+  if (hits.size() > limit) {
+    std::partial_sort(hits.begin(), hits.begin() + limit, hits.end(), better);
+    hits.resize(limit);
+  } else {
+    std::sort(hits.begin(), hits.end(), better);
+  }
+  return hits;
+}
@@ -0,0 +1,312 @@
+#include "tool_pipeline.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
+#include <stdexcept>
+
+#include "admission_controller.h"
+#include "mcp_logger.h"
+#include "mcp_server.h"
+#include "memory_accounting.h"
+
+namespace {
+
+// Split "step/json/pointer" into the step id and the pointer ("" for whole)
+std::pair<std::string, std::string> splitRef(const std::string &ref) {
+  size_t slash = ref.find('/');
+  if (slash == std::string::npos) return {ref, ""};
+  return {ref.substr(0, slash), ref.substr(slash)};
+}
+
+bool isRef(const json &value) {
+  return value.is_object() && value.size() == 1 && value.contains("$ref") &&
+         value["$ref"].is_string();
+}
+
+void collectRefs(const json &value, std::set<std::string> &refs) {
+  if (isRef(value)) {
+    refs.insert(splitRef(value["$ref"].get<std::string>()).first);
+  } else if (value.is_structured()) {
+    for (const auto &item : value) collectRefs(item, refs);
+  }
+}
+
+}  // namespace
+
+ToolPipeline::ToolPipeline(McpServer &server) : server_(server) {}
+
+json ToolPipeline::inputSchema() {
+  json step = {
+      {"type", "object"},
+      {"properties",
+       {{"id", {{"type", "string"}, {"description", "Unique step id"}}},
+        {"tool", {{"type", "string"}, {"description", "Tool to call"}}},
+        {"arguments",
+         {{"type", "object"},
+          {"description",
+           "Tool arguments; {\"$ref\": \"<step id>[/json/pointer]\"} is "
+           "replaced by that step's result"}}},
+        {"dependsOn",
+         {{"type", "array"},
+          {"items", {{"type", "string"}}},
+          {"description", "Extra steps that must finish first"}}}}},
+      {"required", {"id", "tool"}}};
+  return {{"type", "object"},
+          {"properties",
+           {{"steps", {{"type", "array"}, {"items", step}}},
+            {"output",
+             {{"type", "string"},
+              {"enum", {"final", "all"}},
+              {"description", "Return only the final result (default) or "
+                              "every step's result"}}},
+            {"final",
+             {{"type", "string"},
+              {"description", "Step whose result is final (default: last)"}}}}},
+          {"required", {"steps"}}};
+}
+
+json ToolPipeline::resolveRefs(const json &value) const {
+  if (isRef(value)) {
+    auto [id, pointer] = splitRef(value["$ref"].get<std::string>());
+    const json &result = results_.at(id);
+    if (pointer.empty()) return result;
+    try {
+      return result.at(json::json_pointer(pointer));
+    } catch (const json::exception &) {
+      throw std::runtime_error("Pipeline reference not found: " +
+                               value["$ref"].get<std::string>());
+    }
+  }
+  if (value.is_object()) {
+    json resolved = json::object();
+    for (const auto &[key, item] : value.items()) {
+      resolved[key] = resolveRefs(item);
+    }
+    return resolved;
+  }
+  if (value.is_array()) {
+    json resolved = json::array();
+    for (const auto &item : value) resolved.push_back(resolveRefs(item));
+    return resolved;
+  }
+  return value;
+}
+
+json ToolPipeline::runStep(const Step &step) {
+  auto snapshot = server_.getToolSnapshot();
+  const ToolEntry *entry = snapshot->find(step.tool);
+  if (!entry) throw std::runtime_error("Tool not found: " + step.tool);
+  // Nested call: the pipeline already holds a global admission slot
+  return server_.invokeTool(*entry, step.arguments, true);
+}
+
+json ToolPipeline::run(const json &request) {
+  const json &stepsJson = request.at("steps");
+  if (!stepsJson.is_array() || stepsJson.empty()) {
+    throw std::runtime_error("Pipeline needs a non-empty 'steps' array");
+  }
+  if (stepsJson.size() > kMaxSteps) {
+    throw std::runtime_error("Pipeline has more than " +
+                             std::to_string(kMaxSteps) + " steps");
+  }
+
+  // Parse steps and their dependencies
+  std::vector<Step> steps;
+  std::map<std::string, size_t> indexById;
+  auto snapshot = server_.getToolSnapshot();
+  for (const auto &spec : stepsJson) {
+    Step step;
+    step.id = spec.at("id").get<std::string>();
+    step.tool = spec.at("tool").get<std::string>();
+    step.arguments = spec.value("arguments", json::object());
+    if (step.id.empty() || step.id.find('/') != std::string::npos) {
+      throw std::runtime_error("Invalid pipeline step id: '" + step.id + "'");
+    }
+    if (step.tool == kToolName) {
+      throw std::runtime_error("Pipelines cannot be nested");
+    }
+    if (!snapshot->find(step.tool)) {
+      throw std::runtime_error("Tool not found: " + step.tool);
+    }
+    if (!indexById.emplace(step.id, steps.size()).second) {
+      throw std::runtime_error("Duplicate pipeline step id: " + step.id);
+    }
+
+    std::set<std::string> deps;
+    collectRefs(step.arguments, deps);
+    for (const auto &dep : spec.value("dependsOn", json::array())) {
+      deps.insert(dep.get<std::string>());
+    }
+    step.dependsOn.assign(deps.begin(), deps.end());
+    steps.push_back(std::move(step));
+  }
+
+  std::vector<size_t> remaining(steps.size());
+  std::vector<std::vector<size_t>> dependents(steps.size());
+  for (size_t i = 0; i < steps.size(); ++i) {
+    for (const auto &dep : steps[i].dependsOn) {
+      auto it = indexById.find(dep);
+      if (it == indexById.end()) {
+        throw std::runtime_error("Step '" + steps[i].id +
+                                 "' depends on unknown step '" + dep + "'");
+      }
+      dependents[it->second].push_back(i);
+      ++remaining[i];
+    }
+  }
+
+  std::string finalId = request.value("final", steps.back().id);
+  if (!indexById.count(finalId)) {
+    throw std::runtime_error("Unknown final pipeline step: " + finalId);
+  }
+
+  // Start each step as soon as its own dependencies are done, up to
+  // kMaxParallelSteps at a time. Started steps are queued in 'state' and
+  // offered to the server's work lane. While no step is running, this thread
+  // runs a queued one itself, so a pipeline never waits on workers that are
+  // all busy, and a lone step runs right here. Only this thread touches
+  // results_ and the bookkeeping.
+  struct Finished {
+    size_t index;
+    json result;
+    std::exception_ptr error;
+  };
+  struct State {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<size_t> queued;
+    size_t running = 0;
+    std::deque<Finished> finished;
+  };
+  auto state = std::make_shared<State>();
+  // Run the oldest queued step, if any. 'steps' is only touched once a step
+  // is taken, and run() does not return while a taken step is unfinished.
+  auto runQueued = [this, &steps](State &state) {
+    size_t index;
+    {
+      std::lock_guard<std::mutex> lock(state.mutex);
+      if (state.queued.empty()) return;
+      index = state.queued.front();
+      state.queued.pop_front();
+      ++state.running;
+    }
+    Finished done{index, json(), nullptr};
+    try {
+      done.result = runStep(steps[index]);
+    } catch (...) {
+      done.error = std::current_exception();
+    }
+    {
+      std::lock_guard<std::mutex> lock(state.mutex);
+      --state.running;
+      state.finished.push_back(std::move(done));
+    }
+    state.cv.notify_one();
+  };
+
+  std::deque<size_t> ready;
+  for (size_t i = 0; i < steps.size(); ++i) {
+    if (remaining[i] == 0) ready.push_back(i);
+  }
+  size_t completed = 0;
+  size_t active = 0;
+  std::optional<Finished> failure;
+  // Keep the first failure; let the steps already running finish (they use
+  // 'steps'), but start no more
+  auto fail = [&](Finished done) {
+    if (failure) return;
+    failure = std::move(done);
+    std::lock_guard<std::mutex> lock(state->mutex);
+    active -= state->queued.size();
+    state->queued.clear();
+  };
+  for (;;) {
+    while (!failure && !ready.empty() && active < kMaxParallelSteps) {
+      size_t index = ready.front();
+      ready.pop_front();
+      try {
+        steps[index].arguments = resolveRefs(steps[index].arguments);
+      } catch (...) {
+        fail({index, json(), std::current_exception()});
+        break;
+      }
+      ++active;
+      {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->queued.push_back(index);
+      }
+      if (active == 1 && ready.empty()) break;
+      // Steps on the work lane stay charged to the request's memory scope
+      server_.submitWork([state, runQueued, memory = MemoryScope::current()] {
+        MemoryScope::Attach attach(memory);
+        runQueued(*state);
+      });
+    }
+    if (active == 0) break;
+
+    Finished done;
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->cv.wait(lock, [&] {
+          return !state->finished.empty() ||
+                 (!state->queued.empty() && state->running == 0);
+        });
+        if (!state->finished.empty()) {
+          done = std::move(state->finished.front());
+          state->finished.pop_front();
+          break;
+        }
+      }
+      // Nothing is running: no worker is free (or serve() is not running)
+      runQueued(*state);
+    }
+    --active;
+    if (done.error) {
+      fail(std::move(done));
+      continue;
+    }
+    results_[steps[done.index].id] = std::move(done.result);
+    ++completed;
+    for (size_t next : dependents[done.index]) {
+      if (--remaining[next] == 0) ready.push_back(next);
+    }
+  }
+
+  if (failure) {
+    const Step &step = steps[failure->index];
+    try {
+      std::rethrow_exception(failure->error);
+    } catch (const ServerBusyError &e) {
+      // Keep the type, and with it the error code, of budget and admission
+      // failures
+      spdlog::warn("Pipeline step '" + step.id + "' (" + step.tool +
+                   ") rejected: " + e.what());
+      throw;
+    } catch (const MemoryBudgetExceeded &e) {
+      spdlog::warn("Pipeline step '" + step.id + "' (" + step.tool +
+                   ") failed: " + e.message());
+      throw;
+    } catch (const std::exception &e) {
+      throw std::runtime_error("Pipeline step '" + step.id + "' (" +
+                               step.tool + ") failed: " + e.what());
+    }
+  }
+
+  if (completed != steps.size()) {
+    throw std::runtime_error("Pipeline steps have a dependency cycle");
+  }
+  spdlog::info("Pipeline completed: " + std::to_string(steps.size()) +
+               " steps");
+
+  if (request.value("output", "final") == "all") {
+    json all = json::object();
+    for (const auto &step : steps) all[step.id] = results_[step.id];
+    return json{{"results", all}};
+  }
+  return results_[finalId];
+}
@@ -0,0 +1,110 @@
+#include "tool_registry.h"
+
+#include <atomic>
+#include <future>
+#include <utility>
+
+namespace {
+
+std::atomic<uint64_t> nextRegistryId{1};
+
+// Snapshot this thread saw last
+struct CachedSnapshot {
+  uint64_t registry = 0;
+  uint64_t version = 0;
+  std::shared_ptr<const ToolSnapshot> snapshot;
+};
+
+thread_local CachedSnapshot tlsSnapshot;
+
+}  // namespace
+
+ToolRegistry::ToolRegistry()
+    : id_(nextRegistryId.fetch_add(1, std::memory_order_relaxed)),
+      current_(std::make_shared<const ToolSnapshot>()) {}
+
+std::shared_ptr<const ToolSnapshot> ToolRegistry::snapshot() const {
+  CachedSnapshot &cache = tlsSnapshot;
+  if (cache.registry == id_ &&
+      cache.version == version_.load(std::memory_order_acquire)) {
+    return cache.snapshot;
+  }
+
+  std::shared_ptr<const ToolSnapshot> current =
+      current_.load(std::memory_order_acquire);
+  cache.registry = id_;
+  cache.version = current->version;
+  cache.snapshot = current;
+  return current;
+}
+
+void ToolRegistry::addTool(const McpTool &tool, ToolHandler handler) {
+  update([&](ToolSnapshot &next) { put(next, tool, std::move(handler)); });
+}
+
+void ToolRegistry::addAsyncTool(const McpTool &tool, AsyncToolHandler handler) {
+  update([&](ToolSnapshot &next) { putAsync(next, tool, std::move(handler)); });
+}
+
+bool ToolRegistry::removeTool(const std::string &name) {
+  bool removed = false;
+  update([&](ToolSnapshot &next) { removed = erase(next, name); });
+  return removed;
+}
+
+void ToolRegistry::update(
+    const std::function<void(ToolSnapshot &)> &mutator) {
+  std::lock_guard<std::mutex> lock(writeMutex_);
+  // current_ only changes under writeMutex_
+  auto previous = current_.load(std::memory_order_acquire);
+  // The new version shares the entries and, through fork(), every index
+  // shard the mutator leaves alone; 'previous' is published and never
+  // changes again
+  auto next = std::make_shared<ToolSnapshot>();
+  next->entries = previous->entries;
+  next->index = previous->index.fork();
+  mutator(*next);
+  uint64_t version = previous->version + 1;
+  next->version = version;
+
+  current_.store(std::move(next), std::memory_order_release);
+  version_.store(version, std::memory_order_release);
+  // 'previous' is dropped here, after publication, so freeing the old
+  // snapshot never stalls readers
+}
+
+void ToolRegistry::put(ToolSnapshot &snapshot, const McpTool &tool,
+                       ToolHandler handler) {
+  put(snapshot, ToolEntry{tool, std::move(handler), {}});
+}
+
+void ToolRegistry::putAsync(ToolSnapshot &snapshot, const McpTool &tool,
+                            AsyncToolHandler handler) {
+  // Blocking form for synchronous callers. Must not be used from an executor
+  // thread, which would then wait on work only it could resume.
+  ToolHandler blocking = [handler](const json &arguments) -> json {
+    std::promise<json> promise;
+    auto result = promise.get_future();
+    handler(arguments).start([&promise](json value, std::exception_ptr error) {
+      if (error) {
+        promise.set_exception(error);
+      } else {
+        promise.set_value(std::move(value));
+      }
+    });
+    return result.get();
+  };
+  put(snapshot, ToolEntry{tool, std::move(blocking), std::move(handler)});
+}
+
+void ToolRegistry::put(ToolSnapshot &snapshot, ToolEntry entry) {
+  std::string name = entry.tool.name;
+  snapshot.index.addTool(entry.tool);
+  snapshot.entries[name] = std::make_shared<const ToolEntry>(std::move(entry));
+}
+
+bool ToolRegistry::erase(ToolSnapshot &snapshot, const std::string &name) {
+  if (snapshot.entries.erase(name) == 0) return false;
+  snapshot.index.removeTool(name);
+  return true;
+}
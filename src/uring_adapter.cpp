@@ -0,0 +1,569 @@
+#include "uring_adapter.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "mcp_logger.h"
+
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <cerrno>
+#endif
+
+#ifndef __linux__
+
+struct UringAdapter::Ring {};
+
+UringAdapter::UringAdapter(int readFd, int writeFd)
+    : readFd_(readFd), writeFd_(writeFd) {}
+UringAdapter::~UringAdapter() = default;
+
+bool UringAdapter::available() { return false; }
+
+bool UringAdapter::readMessage(std::string &) { return false; }
+bool UringAdapter::writeMessage(const std::string &) { return false; }
+
+#else
+
+namespace {
+
+constexpr unsigned kRingEntries = 64;
+constexpr uint64_t kReadTag = 1;
+constexpr uint64_t kWriteTag = 2;
+constexpr uint64_t kCancelTag = 3;
+// Provided buffers for multishot receives on sockets
+constexpr unsigned kProvidedBuffers = 8;  // power of two
+constexpr size_t kProvidedBufferSize = 16 * 1024;
+// Registered buffer indexes
+constexpr uint16_t kReadBufferIndex = 0;
+constexpr uint16_t kWriteBufferIndex = 1;
+// Read/write at the current file position, as read(2) and write(2) do
+constexpr uint64_t kCurrentPosition = ~0ULL;
+
+int ioUringSetup(unsigned entries, io_uring_params *params) {
+  return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+void *mapRegion(size_t size, int fd, off_t offset) {
+  int flags = fd < 0 ? MAP_PRIVATE | MAP_ANONYMOUS : MAP_SHARED | MAP_POPULATE;
+  void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, fd, offset);
+  return ptr == MAP_FAILED ? nullptr : ptr;
+}
+
+}  // namespace
+
+// Submission and completion rings mapped from the kernel, plus the buffers
+// registered with them
+struct UringAdapter::Ring {
+  int fd = -1;
+  void *sqRing = nullptr;
+  size_t sqRingSize = 0;
+  void *cqRing = nullptr;  // same mapping as sqRing with IORING_FEAT_SINGLE_MMAP
+  size_t cqRingSize = 0;
+  io_uring_sqe *sqes = nullptr;
+  size_t sqesSize = 0;
+
+  unsigned *sqHead = nullptr;
+  unsigned *sqTail = nullptr;
+  unsigned sqMask = 0;
+  unsigned sqEntries = 0;
+  unsigned *sqArray = nullptr;
+  unsigned *cqHead = nullptr;
+  unsigned *cqTail = nullptr;
+  unsigned cqMask = 0;
+  io_uring_cqe *cqes = nullptr;
+
+  // kReadBufferSize + kWriteBufferSize; registered if fixedBuffers
+  char *buffers = nullptr;
+  char *readBuffer = nullptr;
+  char *writeBuffer = nullptr;
+  bool fixedBuffers = false;
+
+  // Provided buffer ring (one page) followed by the buffers it hands out
+  char *provided = nullptr;
+  size_t providedSize = 0;
+  io_uring_buf_ring *bufRing = nullptr;
+  char *bufPool = nullptr;
+
+  // Guards filling and publishing submission queue entries
+  std::mutex sqMutex;
+
+  ~Ring() {
+    if (sqes) munmap(sqes, sqesSize);
+    if (cqRing && cqRing != sqRing) munmap(cqRing, cqRingSize);
+    if (sqRing) munmap(sqRing, sqRingSize);
+    // Closing the ring unregisters the buffers before they are unmapped
+    if (fd >= 0) ::close(fd);
+    if (buffers) munmap(buffers, kReadBufferSize + kWriteBufferSize);
+    if (provided) munmap(provided, providedSize);
+  }
+
+  bool init(unsigned entries) {
+    io_uring_params params{};
+    params.flags = IORING_SETUP_CLAMP;
+    fd = ioUringSetup(entries, &params);
+    if (fd < 0) return false;
+    // Offset -1 ("current position") is what makes pipes and ttys work
+    if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+      errno = ENOTSUP;
+      return false;
+    }
+
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool singleMap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMap) sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+    sqRing = mapRegion(sqRingSize, fd, IORING_OFF_SQ_RING);
+    if (!sqRing) return false;
+    cqRing = singleMap ? sqRing : mapRegion(cqRingSize, fd, IORING_OFF_CQ_RING);
+    if (!cqRing) return false;
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    sqes = static_cast<io_uring_sqe *>(
+        mapRegion(sqesSize, fd, static_cast<off_t>(IORING_OFF_SQES)));
+    if (!sqes) return false;
+
+    char *sq = static_cast<char *>(sqRing);
+    sqHead = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+    sqMask = *reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+    sqEntries = params.sq_entries;
+    sqArray = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+    char *cq = static_cast<char *>(cqRing);
+    cqHead = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+    cqMask = *reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+    buffers = static_cast<char *>(
+        mapRegion(kReadBufferSize + kWriteBufferSize, -1, 0));
+    if (!buffers) return false;
+    readBuffer = buffers;
+    writeBuffer = buffers + kReadBufferSize;
+    struct iovec iov[2];
+    iov[kReadBufferIndex] = {readBuffer, kReadBufferSize};
+    iov[kWriteBufferIndex] = {writeBuffer, kWriteBufferSize};
+    // Can fail under a low RLIMIT_MEMLOCK on older kernels; plain reads and
+    // writes on the same memory still work
+    fixedBuffers =
+        syscall(__NR_io_uring_register, fd, IORING_REGISTER_BUFFERS, iov, 2) ==
+        0;
+    if (!fixedBuffers) {
+      spdlog::debug(std::string("io_uring buffer registration failed: ") +
+                    std::strerror(errno));
+    }
+    return true;
+  }
+
+  // Multishot receives pick buffers from a ring the kernel shares with us
+  bool registerProvidedBuffers() {
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    providedSize = page + kProvidedBuffers * kProvidedBufferSize;
+    provided = static_cast<char *>(mapRegion(providedSize, -1, 0));
+    if (!provided) return false;
+    bufRing = reinterpret_cast<io_uring_buf_ring *>(provided);
+    bufPool = provided + page;
+
+    io_uring_buf_reg reg{};
+    reg.ring_addr = reinterpret_cast<uint64_t>(bufRing);
+    reg.ring_entries = kProvidedBuffers;
+    reg.bgid = 0;
+    if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PBUF_RING, &reg,
+                1) != 0) {
+      return false;
+    }
+    for (unsigned i = 0; i < kProvidedBuffers; ++i) recycle(i);
+    return true;
+  }
+
+  // Hand a provided buffer back to the kernel; callers hold cqMutex_
+  void recycle(unsigned bid) {
+    uint16_t tail = bufRing->tail;
+    io_uring_buf &buf = bufRing->bufs[tail & (kProvidedBuffers - 1)];
+    buf.addr = reinterpret_cast<uint64_t>(bufPool + bid * kProvidedBufferSize);
+    buf.len = kProvidedBufferSize;
+    buf.bid = static_cast<uint16_t>(bid);
+    __atomic_store_n(&bufRing->tail, static_cast<uint16_t>(tail + 1),
+                     __ATOMIC_RELEASE);
+  }
+
+  // Next free entry, zeroed; requires sqMutex. The kernel consumes entries
+  // on every enter(), so the queue only fills if submission keeps failing.
+  io_uring_sqe *prepare() {
+    unsigned tail = *sqTail;
+    if (tail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries) {
+      return nullptr;
+    }
+    io_uring_sqe *sqe = &sqes[tail & sqMask];
+    std::memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+  }
+
+  void publish() {
+    unsigned tail = *sqTail;
+    sqArray[tail & sqMask] = tail & sqMask;
+    __atomic_store_n(sqTail, tail + 1, __ATOMIC_RELEASE);
+  }
+
+  // Submit everything published so far (by any thread) and optionally wait
+  // for completions. Returns 0 or -errno.
+  int enter(unsigned waitFor) {
+    for (;;) {
+      unsigned pending = __atomic_load_n(sqTail, __ATOMIC_ACQUIRE) -
+                         __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+      if (pending == 0 && waitFor == 0) return 0;
+      unsigned flags = waitFor ? IORING_ENTER_GETEVENTS : 0;
+      long ret = syscall(__NR_io_uring_enter, fd, pending, waitFor, flags,
+                         nullptr, 0);
+      if (ret >= 0) return 0;
+      if (errno != EINTR) return -errno;
+    }
+  }
+
+  unsigned ready() const {
+    return __atomic_load_n(cqTail, __ATOMIC_ACQUIRE) - *cqHead;
+  }
+};
+
+bool UringAdapter::available() {
+  io_uring_params params{};
+  int fd = ioUringSetup(1, &params);
+  if (fd < 0) return false;
+  ::close(fd);
+  return true;
+}
+
+UringAdapter::UringAdapter(int readFd, int writeFd)
+    : readFd_(readFd), writeFd_(writeFd) {
+  auto ring = std::make_unique<Ring>();
+  if (!ring->init(kRingEntries)) {
+    spdlog::warn(std::string("io_uring unavailable (") + std::strerror(errno) +
+                 "); using blocking reads and writes");
+    return;
+  }
+  struct stat st {};
+  if (fstat(readFd_, &st) == 0 && S_ISSOCK(st.st_mode)) {
+    multishot_ = ring->registerProvidedBuffers();
+    if (!multishot_) {
+      spdlog::debug("Provided buffer rings unsupported; using single reads");
+    }
+  }
+  ring_ = std::move(ring);
+}
+
+UringAdapter::~UringAdapter() {
+  if (!ring_) return;
+  {
+    // The kernel may still write into our buffers until the read completes
+    std::lock_guard<std::mutex> lock(cqMutex_);
+    if (readArmed_) {
+      {
+        std::lock_guard<std::mutex> sqLock(ring_->sqMutex);
+        if (io_uring_sqe *sqe = ring_->prepare()) {
+          sqe->opcode = IORING_OP_ASYNC_CANCEL;
+          sqe->fd = -1;
+          sqe->addr = kReadTag;
+          sqe->user_data = kCancelTag;
+          ring_->publish();
+        }
+      }
+      while (readArmed_ && ring_->enter(1) == 0) reapLocked();
+    }
+  }
+  std::unique_lock<std::mutex> outLock(outMutex_);
+  waitForWrites(outLock, true);
+}
+
+bool UringAdapter::takeLine(std::string &message) {
+  size_t pos = input_.find('\n', scanned_);
+  if (pos == std::string::npos) {
+    scanned_ = input_.size();
+    return false;
+  }
+  message.assign(input_, inputStart_, pos - inputStart_);
+  inputStart_ = scanned_ = pos + 1;
+  if (inputStart_ == input_.size()) {
+    input_.clear();
+    inputStart_ = scanned_ = 0;
+  } else if (inputStart_ >= kReadBufferSize) {
+    // Compact once in a while rather than erasing after every message
+    input_.erase(0, inputStart_);
+    scanned_ -= inputStart_;
+    inputStart_ = 0;
+  }
+  return true;
+}
+
+bool UringAdapter::takeRemainder(std::string &message) {
+  // Like std::getline, a last line without a newline is still a message
+  if (inputStart_ >= input_.size()) return false;
+  message.assign(input_, inputStart_, std::string::npos);
+  input_.clear();
+  inputStart_ = scanned_ = 0;
+  return true;
+}
+
+bool UringAdapter::readMessage(std::string &message) {
+  if (!ring_) return fallbackRead(message);
+
+  std::unique_lock<std::mutex> lock(cqMutex_);
+  reapLocked();
+  for (;;) {
+    if (takeLine(message)) return true;
+    if (eof_) {
+      if (takeRemainder(message)) return true;
+      lock.unlock();
+      // Nobody drives completions from here on: flush what is queued and
+      // let later writes wait for themselves
+      std::unique_lock<std::mutex> outLock(outMutex_);
+      inputClosed_ = true;
+      waitForWrites(outLock, true);
+      return false;
+    }
+    if (!readArmed_ && !armReadLocked()) {
+      spdlog::error("io_uring submission queue full; closing input");
+      eof_ = true;
+      continue;
+    }
+    // One call submits the read (and any queued writes) and waits
+    int err = ring_->enter(1);
+    if (err < 0 && err != -EAGAIN && err != -EBUSY) {
+      spdlog::error(std::string("io_uring_enter failed: ") +
+                    std::strerror(-err));
+      eof_ = true;
+    }
+    reapLocked();
+  }
+}
+
+bool UringAdapter::armReadLocked() {
+  std::lock_guard<std::mutex> sqLock(ring_->sqMutex);
+  io_uring_sqe *sqe = ring_->prepare();
+  if (!sqe) return false;
+  sqe->fd = readFd_;
+  sqe->user_data = kReadTag;
+  if (multishot_) {
+    // Stays armed across completions while IORING_CQE_F_MORE is set
+    sqe->opcode = IORING_OP_RECV;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = 0;
+  } else {
+    sqe->opcode =
+        ring_->fixedBuffers ? IORING_OP_READ_FIXED : IORING_OP_READ;
+    sqe->addr = reinterpret_cast<uint64_t>(ring_->readBuffer);
+    sqe->len = kReadBufferSize;
+    sqe->off = kCurrentPosition;
+    sqe->buf_index = kReadBufferIndex;
+  }
+  ring_->publish();
+  readArmed_ = true;
+  return true;
+}
+
+void UringAdapter::reapLocked() {
+  unsigned head = *ring_->cqHead;
+  while (head != __atomic_load_n(ring_->cqTail, __ATOMIC_ACQUIRE)) {
+    const io_uring_cqe &cqe = ring_->cqes[head & ring_->cqMask];
+    uint64_t tag = cqe.user_data;
+    int32_t res = cqe.res;
+    uint32_t flags = cqe.flags;
+    __atomic_store_n(ring_->cqHead, ++head, __ATOMIC_RELEASE);
+
+    if (tag == kReadTag) {
+      onReadCompletion(res, flags);
+    } else if (tag == kWriteTag) {
+      onWriteCompletion(res);
+    }
+  }
+}
+
+void UringAdapter::onReadCompletion(int32_t res, uint32_t flags) {
+  if (!multishot_ || !(flags & IORING_CQE_F_MORE)) readArmed_ = false;
+  if (res > 0) {
+    if (flags & IORING_CQE_F_BUFFER) {
+      unsigned bid = flags >> IORING_CQE_BUFFER_SHIFT;
+      providedBuffersWork_ = true;
+      input_.append(ring_->bufPool + bid * kProvidedBufferSize,
+                    static_cast<size_t>(res));
+      ring_->recycle(bid);
+    } else {
+      input_.append(ring_->readBuffer, static_cast<size_t>(res));
+    }
+    return;
+  }
+  if (res == 0) {
+    eof_ = true;
+  } else if (multishot_ && (res == -EINVAL ||
+                            (res == -ENOBUFS && !providedBuffersWork_))) {
+    // Buffers go back as soon as they are copied, so running out before
+    // the first receive means the kernel cannot use the ring at all
+    spdlog::debug("Multishot receive unusable; using single reads");
+    multishot_ = false;
+  } else if (res == -EINTR || res == -EAGAIN || res == -ENOBUFS) {
+    // Re-armed by the next readMessage()
+  } else {
+    if (res != -ECANCELED) {
+      spdlog::error(std::string("io_uring read failed: ") +
+                    std::strerror(-res));
+    }
+    eof_ = true;
+  }
+}
+
+bool UringAdapter::tryReap(bool wait) {
+  std::unique_lock<std::mutex> lock(cqMutex_, std::try_to_lock);
+  if (!lock.owns_lock()) return false;
+  if (wait && ring_->ready() == 0) ring_->enter(1);
+  reapLocked();
+  return true;
+}
+
+bool UringAdapter::writeMessage(const std::string &message) {
+  if (!ring_) return fallbackWrite(message);
+
+  std::unique_lock<std::mutex> outLock(outMutex_);
+  if (writeFailed_) return false;
+  queued_.append(message);
+  queued_.push_back('\n');
+  submitWriteLocked();
+  if (inputClosed_) {
+    waitForWrites(outLock, true);
+  } else if (queued_.size() > kMaxQueuedOutput) {
+    waitForWrites(outLock, false);
+  } else if (writeInFlight_) {
+    // The reader may be busy elsewhere; keep completions moving
+    outLock.unlock();
+    if (ring_->ready() > 0) tryReap(false);
+    outLock.lock();
+  }
+  return !writeFailed_;
+}
+
+void UringAdapter::submitWriteLocked() {
+  if (writeInFlight_ || writeFailed_ || queued_.empty()) return;
+  // Everything queued since the last write goes out in one submission
+  inFlight_.swap(queued_);
+  queued_.clear();
+  inFlightOffset_ = 0;
+  issueWriteLocked();
+}
+
+void UringAdapter::issueWriteLocked() {
+  size_t remaining = inFlight_.size() - inFlightOffset_;
+  const char *data = inFlight_.data() + inFlightOffset_;
+  bool fixed = ring_->fixedBuffers && remaining <= kWriteBufferSize;
+  if (fixed) {
+    std::memcpy(ring_->writeBuffer, data, remaining);
+    data = ring_->writeBuffer;
+  }
+  {
+    std::lock_guard<std::mutex> sqLock(ring_->sqMutex);
+    io_uring_sqe *sqe = ring_->prepare();
+    if (!sqe) {
+      spdlog::error("io_uring submission queue full; dropping output");
+      writeFailed_ = true;
+      writeInFlight_ = false;
+      writeDone_.notify_all();
+      return;
+    }
+    sqe->opcode = fixed ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+    sqe->fd = writeFd_;
+    sqe->addr = reinterpret_cast<uint64_t>(data);
+    sqe->len = static_cast<uint32_t>(std::min<size_t>(remaining, 1u << 30));
+    sqe->off = kCurrentPosition;
+    sqe->buf_index = fixed ? kWriteBufferIndex : 0;
+    sqe->user_data = kWriteTag;
+    ring_->publish();
+  }
+  writeInFlight_ = true;
+  ring_->enter(0);
+}
+
+void UringAdapter::onWriteCompletion(int32_t res) {
+  std::lock_guard<std::mutex> outLock(outMutex_);
+  // A request is cancelled when the thread that submitted it exits, as
+  // writers (e.g. scheduler workers) may right after writeMessage(); only
+  // reads are ever cancelled on purpose, so the write is simply issued
+  // again, by this thread
+  if (res == -EINTR || res == -EAGAIN || res == -ECANCELED) {
+    issueWriteLocked();
+    return;
+  }
+  if (res <= 0) {
+    spdlog::error(std::string("io_uring write failed: ") +
+                  std::strerror(res == 0 ? EPIPE : -res));
+    writeFailed_ = true;
+    writeInFlight_ = false;
+    inFlight_.clear();
+    queued_.clear();
+    writeDone_.notify_all();
+    return;
+  }
+  inFlightOffset_ += static_cast<size_t>(res);
+  if (inFlightOffset_ < inFlight_.size()) {
+    issueWriteLocked();  // short write
+    return;
+  }
+  writeInFlight_ = false;
+  inFlight_.clear();
+  submitWriteLocked();
+  writeDone_.notify_all();
+}
+
+void UringAdapter::waitForWrites(std::unique_lock<std::mutex> &outLock,
+                                 bool all) {
+  auto pending = [&] {
+    return writeInFlight_ && !writeFailed_ &&
+           (all || queued_.size() > kMaxQueuedOutput);
+  };
+  while (pending()) {
+    outLock.unlock();
+    bool reaped = tryReap(true);
+    outLock.lock();
+    // Otherwise the reader (or another writer) is reaping; the timeout
+    // covers it giving up the ring between our check and the wait
+    if (!reaped && pending()) {
+      writeDone_.wait_for(outLock, std::chrono::milliseconds(10));
+    }
+  }
+}
+
+bool UringAdapter::fallbackRead(std::string &message) {
+  std::lock_guard<std::mutex> lock(cqMutex_);
+  for (;;) {
+    if (takeLine(message)) return true;
+    if (eof_) return takeRemainder(message);
+    size_t size = input_.size();
+    input_.resize(size + kReadBufferSize);
+    ssize_t n = ::read(readFd_, &input_[size], kReadBufferSize);
+    input_.resize(size + static_cast<size_t>(std::max<ssize_t>(n, 0)));
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) eof_ = true;
+  }
+}
+
+bool UringAdapter::fallbackWrite(const std::string &message) {
+  std::lock_guard<std::mutex> lock(outMutex_);
+  if (writeFailed_) return false;
+  std::string line = message + '\n';
+  size_t offset = 0;
+  while (offset < line.size()) {
+    ssize_t n = ::write(writeFd_, line.data() + offset, line.size() - offset);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) {
+      writeFailed_ = true;
+      return false;
+    }
+    offset += static_cast<size_t>(n);
+  }
+  return true;
+}
+
+#endif
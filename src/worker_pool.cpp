@@ -0,0 +1,464 @@
+#include "worker_pool.h"
+
+#include <cerrno>
+#include <chrono>
+#include <stdexcept>
+
+#include "admission_controller.h"
+#include "mcp_logger.h"
+#include "shm_ring.h"
+
+#ifdef _WIN32
+
+struct WorkerPool::Worker {};
+
+WorkerPool::WorkerPool(Executor executor, const WorkerPoolOptions &options)
+    : executor_(std::move(executor)), options_(options) {
+  throw std::runtime_error("Tool worker pool is not supported on Windows");
+}
+
+WorkerPool::~WorkerPool() = default;
+
+json WorkerPool::call(const std::string &tool, const json &) {
+  throw std::runtime_error("Tool worker pool is not supported: " + tool);
+}
+
+size_t WorkerPool::respawnCount() const { return 0; }
+
+void WorkerPool::spawn(Worker &) {}
+void WorkerPool::retire(Worker &) {}
+bool WorkerPool::alive(Worker &) { return false; }
+
+#else
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#endif
+
+struct WorkerPool::Worker {
+  pid_t pid = -1;
+  int pidFd = -1;  // readable once the worker exits; -1 if unsupported
+  void *region = nullptr;
+  size_t regionSize = 0;
+  ShmRing requests;   // server -> worker
+  ShmRing responses;  // worker -> server
+};
+
+namespace {
+
+void applyLimits(const WorkerPoolOptions &options) {
+  if (options.memoryLimitBytes > 0) {
+    struct rlimit limit;
+    limit.rlim_cur = limit.rlim_max = options.memoryLimitBytes;
+    setrlimit(RLIMIT_AS, &limit);
+  }
+}
+
+// RLIMIT_CPU counts the worker's whole lifetime, so before each call move
+// the soft limit to the CPU time used so far plus the per-call budget. The
+// hard limit is left alone: an unprivileged process can never raise it
+// again. SIGXCPU kills the worker at the soft limit; a tool that catches it
+// is still stopped by the call timeout.
+void startCpuBudget(const WorkerPoolOptions &options) {
+  if (options.cpuLimitSeconds == 0) return;
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) return;
+  // Rounded up, so a call always gets at least its budget
+  int64_t usedUs = (static_cast<int64_t>(usage.ru_utime.tv_sec) +
+                    usage.ru_stime.tv_sec) *
+                       1000000 +
+                   usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+  rlim_t used = static_cast<rlim_t>((usedUs + 999999) / 1000000);
+  struct rlimit limit;
+  if (getrlimit(RLIMIT_CPU, &limit) != 0) return;
+  limit.rlim_cur = used + options.cpuLimitSeconds;
+  if (limit.rlim_max != RLIM_INFINITY && limit.rlim_cur > limit.rlim_max) {
+    limit.rlim_cur = limit.rlim_max;
+  }
+  setrlimit(RLIMIT_CPU, &limit);
+}
+
+// Replies go back as CBOR so binary tool output (json::binary) crosses the
+// ring as raw bytes instead of a JSON array of numbers
+std::string encodeReply(const json &reply) {
+  std::vector<uint8_t> bytes = json::to_cbor(reply);
+  return std::string(bytes.begin(), bytes.end());
+}
+
+// Body of a worker process. Never returns.
+[[noreturn]] void runWorker(ShmRing requests, ShmRing responses,
+                            const WorkerPool::Executor &executor,
+                            const WorkerPoolOptions &options, pid_t parent) {
+#ifdef __linux__
+  prctl(PR_SET_PDEATHSIG, SIGKILL);
+#endif
+  if (getppid() != parent) _exit(0);
+
+  // stdout carries the protocol; a tool printing to it must not corrupt it
+  int devNull = open("/dev/null", O_RDWR);
+  if (devNull >= 0) {
+    dup2(devNull, STDIN_FILENO);
+    dup2(devNull, STDOUT_FILENO);
+    close(devNull);
+  }
+  applyLimits(options);
+
+  auto parentAlive = [parent] { return getppid() == parent; };
+  std::string message;
+  while (requests.read(message, parentAlive)) {
+    std::string reply;
+    try {
+      json request = json::parse(message);
+      startCpuBudget(options);
+      json result = executor(request.at("tool").get<std::string>(),
+                             request.at("arguments"));
+      reply = encodeReply(json{{"ok", true}, {"result", std::move(result)}});
+    } catch (const std::exception &e) {
+      reply = encodeReply(json{{"ok", false}, {"error", e.what()}});
+    }
+    if (!responses.write(reply, parentAlive)) break;
+  }
+  _exit(0);
+}
+
+// pidfd for 'pid', or -1 where the kernel or libc lacks them. The worker
+// is the zygote's child and stays a zombie until the zygote reaps it, so
+// its pid cannot be reused before the pidfd is opened.
+int openPidFd(pid_t pid) {
+#if defined(__linux__) && defined(SYS_pidfd_open)
+  return static_cast<int>(::syscall(SYS_pidfd_open, pid, 0));
+#else
+  (void)pid;
+  return -1;
+#endif
+}
+
+std::string describeExit(int status) {
+  if (WIFSIGNALED(status)) {
+    int sig = WTERMSIG(status);
+    if (sig == SIGXCPU) return "exceeded its CPU limit";
+    return "was killed by signal " + std::to_string(sig);
+  }
+  return "exited with status " + std::to_string(WEXITSTATUS(status));
+}
+
+// Requests to the zygote. It replies to each with one ZygoteReply.
+enum ZygoteOp : int32_t {
+  kZygoteSpawn = 1,  // fork a worker on 'worker's rings; reply pid or -errno
+  kZygotePoll = 2,   // reply pid 0 while 'pid' runs, else its exit 'status'
+  kZygoteReap = 3,   // SIGKILL 'pid' if needed and wait for it
+};
+
+struct ZygoteRequest {
+  int32_t op;
+  int32_t worker;
+  int32_t pid;
+};
+
+struct ZygoteReply {
+  int32_t pid;
+  int32_t status;
+};
+
+bool readFull(int fd, void *data, size_t size) {
+  char *bytes = static_cast<char *>(data);
+  while (size > 0) {
+    ssize_t n = ::read(fd, bytes, size);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    bytes += n;
+    size -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+bool writeFull(int fd, const void *data, size_t size) {
+  const char *bytes = static_cast<const char *>(data);
+  while (size > 0) {
+    ssize_t n = ::write(fd, bytes, size);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    bytes += n;
+    size -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+// Body of the zygote process: a single-threaded copy of the server taken when
+// the pool started, which forks workers on request. Workers forked from the
+// multithreaded server could inherit locks (allocator, logger, registry)
+// held by threads that do not exist in the child and deadlock on them.
+// Exits when the server closes the socket. Never returns.
+[[noreturn]] void runZygote(int fd,
+                            const std::vector<std::unique_ptr<
+                                WorkerPool::Worker>> &workers,
+                            const WorkerPool::Executor &executor,
+                            const WorkerPoolOptions &options, pid_t server) {
+#ifdef __linux__
+  prctl(PR_SET_PDEATHSIG, SIGKILL);
+#endif
+  if (getppid() != server) _exit(0);
+  size_t ringSize = ShmRing::regionSize(options.ringCapacity);
+
+  ZygoteRequest request;
+  while (readFull(fd, &request, sizeof(request))) {
+    ZygoteReply reply{0, 0};
+    if (request.op == kZygoteSpawn && request.worker >= 0 &&
+        static_cast<size_t>(request.worker) < workers.size()) {
+      char *base = static_cast<char *>(workers[request.worker]->region);
+      pid_t zygote = getpid();
+      pid_t pid = fork();
+      if (pid == 0) {
+        ::close(fd);
+        runWorker(ShmRing::attach(base), ShmRing::attach(base + ringSize),
+                  executor, options, zygote);
+      }
+      reply.pid = pid < 0 ? -errno : pid;
+    } else if (request.op == kZygotePoll) {
+      int status = 0;
+      pid_t done = waitpid(request.pid, &status, WNOHANG);
+      reply.pid = done;
+      reply.status = status;
+    } else if (request.op == kZygoteReap) {
+      int status = 0;
+      kill(request.pid, SIGKILL);
+      reply.pid = waitpid(request.pid, &status, 0);
+      reply.status = status;
+    } else {
+      reply.pid = -EINVAL;
+    }
+    if (!writeFull(fd, &reply, sizeof(reply))) break;
+  }
+  _exit(0);
+}
+
+}  // namespace
+
+WorkerPool::WorkerPool(Executor executor, const WorkerPoolOptions &options)
+    : executor_(std::move(executor)), options_(options) {
+  if (options_.workers == 0) options_.workers = 1;
+  for (size_t i = 0; i < options_.workers; ++i) {
+    auto worker = std::make_unique<Worker>();
+    size_t ringSize = ShmRing::regionSize(options_.ringCapacity);
+    worker->regionSize = 2 * ringSize;
+    worker->region = mmap(nullptr, worker->regionSize, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (worker->region == MAP_FAILED) {
+      throw std::runtime_error("Cannot map worker shared memory");
+    }
+    workers_.push_back(std::move(worker));
+  }
+
+  // The zygote must see every worker's region, so map them all first
+  startZygote();
+  for (auto &worker : workers_) {
+    spawn(*worker);
+    idle_.push_back(worker.get());
+  }
+  spdlog::info("Tool worker pool started with " +
+               std::to_string(workers_.size()) + " workers");
+}
+
+WorkerPool::~WorkerPool() {
+  for (auto &worker : workers_) {
+    if (worker->pid > 0) {
+      worker->requests.close();
+      worker->responses.close();
+    }
+    try {
+      retire(*worker);
+    } catch (const std::exception &) {
+      // Zygote gone; it took its workers with it
+    }
+    munmap(worker->region, worker->regionSize);
+  }
+  if (zygoteFd_ >= 0) ::close(zygoteFd_);  // the zygote exits on EOF
+  if (zygotePid_ > 0) waitpid(zygotePid_, nullptr, 0);
+}
+
+void WorkerPool::startZygote() {
+  int fds[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds) != 0) {
+    throw std::runtime_error("Cannot create tool worker zygote socket");
+  }
+  pid_t server = getpid();
+  pid_t pid = fork();
+  if (pid < 0) {
+    ::close(fds[0]);
+    ::close(fds[1]);
+    throw std::runtime_error("Cannot fork tool worker zygote");
+  }
+  if (pid == 0) {
+    ::close(fds[0]);
+    // stdout carries the protocol; neither the zygote nor its workers may
+    // write to it
+    int devNull = open("/dev/null", O_RDWR);
+    if (devNull >= 0) {
+      dup2(devNull, STDIN_FILENO);
+      dup2(devNull, STDOUT_FILENO);
+      close(devNull);
+    }
+    runZygote(fds[1], workers_, executor_, options_, server);
+  }
+  ::close(fds[1]);
+  zygoteFd_ = fds[0];
+  zygotePid_ = pid;
+}
+
+int WorkerPool::zygoteCall(int op, size_t index, int pid, int *status) {
+  std::lock_guard<std::mutex> lock(zygoteMutex_);
+  ZygoteRequest request{op, static_cast<int32_t>(index), pid};
+  ZygoteReply reply{};
+  if (zygoteFd_ < 0 || !writeFull(zygoteFd_, &request, sizeof(request)) ||
+      !readFull(zygoteFd_, &reply, sizeof(reply))) {
+    throw std::runtime_error("Tool worker zygote is gone");
+  }
+  if (status) *status = reply.status;
+  return reply.pid;
+}
+
+void WorkerPool::spawn(Worker &worker) {
+  size_t ringSize = ShmRing::regionSize(options_.ringCapacity);
+  char *base = static_cast<char *>(worker.region);
+  worker.requests = ShmRing::create(base, options_.ringCapacity);
+  worker.responses = ShmRing::create(base + ringSize, options_.ringCapacity);
+
+  size_t index = 0;
+  while (workers_[index].get() != &worker) ++index;
+  int pid = zygoteCall(kZygoteSpawn, index, 0, nullptr);
+  if (pid < 0) throw std::runtime_error("Cannot fork tool worker");
+  worker.pid = pid;
+  worker.pidFd = openPidFd(pid);
+}
+
+void WorkerPool::retire(Worker &worker) {
+  if (worker.pidFd >= 0) {
+    ::close(worker.pidFd);
+    worker.pidFd = -1;
+  }
+  if (worker.pid <= 0) return;
+  int pid = worker.pid;
+  worker.pid = -1;
+  zygoteCall(kZygoteReap, 0, pid, nullptr);
+}
+
+bool WorkerPool::alive(Worker &worker) {
+  if (worker.pid <= 0) return false;
+  if (worker.pidFd >= 0) {
+    // Called every ShmRing wait slice by each call in flight: keep it to a
+    // syscall, and off the mutex every call to the zygote takes
+    struct pollfd exited {};
+    exited.fd = worker.pidFd;
+    exited.events = POLLIN;
+    if (::poll(&exited, 1, 0) == 0) return true;
+  }
+  int status = 0;
+  try {
+    if (zygoteCall(kZygotePoll, 0, worker.pid, &status) == 0) return true;
+  } catch (const std::exception &e) {
+    // Workers die with their zygote
+    spdlog::error(e.what());
+    worker.pid = -1;
+    return false;
+  }
+  spdlog::warn("Tool worker " + std::to_string(worker.pid) + " " +
+               describeExit(status));
+  worker.pid = -1;
+  return false;
+}
+
+size_t WorkerPool::respawnCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return respawns_;
+}
+
+json WorkerPool::call(const std::string &tool, const json &arguments) {
+  Worker *worker;
+  {
+    // Calls beyond the pool size hold their caller's thread while they
+    // wait, so give up after the call timeout rather than block forever
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto idle = [this] { return !idle_.empty(); };
+    if (options_.callTimeoutMs > 0) {
+      if (!idleCv_.wait_for(lock,
+                            std::chrono::milliseconds(options_.callTimeoutMs),
+                            idle)) {
+        throw ServerBusyError("Server busy: no tool worker free for " + tool);
+      }
+    } else {
+      idleCv_.wait(lock, idle);
+    }
+    worker = idle_.back();
+    idle_.pop_back();
+  }
+
+  // Return the worker to the idle list, replacing it first if it was lost
+  auto release = [this, worker](bool replace) {
+    if (replace) {
+      try {
+        retire(*worker);
+        spawn(*worker);
+      } catch (const std::exception &e) {
+        // Leave it dead; the next call on this worker retries the spawn
+        spdlog::error(std::string("Tool worker respawn failed: ") + e.what());
+      }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (replace) ++respawns_;
+    idle_.push_back(worker);
+    idleCv_.notify_one();
+  };
+
+  if (!alive(*worker)) {
+    try {
+      retire(*worker);
+      spawn(*worker);
+    } catch (...) {
+      release(false);
+      throw;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    ++respawns_;
+  }
+
+  auto deadline = std::chrono::steady_clock::now() +
+                  std::chrono::milliseconds(options_.callTimeoutMs);
+  bool timedOut = false;
+  auto keepWaiting = [&] {
+    if (!alive(*worker)) return false;
+    if (options_.callTimeoutMs > 0 &&
+        std::chrono::steady_clock::now() >= deadline) {
+      timedOut = true;
+      return false;
+    }
+    return true;
+  };
+
+  json request = {{"tool", tool}, {"arguments", arguments}};
+  std::string reply;
+  if (!worker->requests.write(request.dump(), keepWaiting) ||
+      !worker->responses.read(reply, keepWaiting)) {
+    release(true);
+    throw std::runtime_error(
+        timedOut ? "Tool worker timed out running " + tool
+                 : "Tool worker crashed running " + tool);
+  }
+  release(false);
+
+  json response = json::from_cbor(reply);
+  if (!response.value("ok", false)) {
+    throw std::runtime_error(response.value("error", "Tool failed: " + tool));
+  }
+  return response["result"];
+}
+
+#endif
@@ -0,0 +1,195 @@
+// Admission control: queue bounds and counters, parked calls resumed in
+// arrival order, a global queue bound that only counts calls held back by
+// the global limit, the cap on blocked threads, and - through serve() - that a
+// flood of calls to one capped tool leaves workers for every other tool.
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "admission_controller.h"
+#include "check.h"
+#include "mcp_logger.h"
+#include "mcp_server.h"
+#include "queue_transport.h"
+
+namespace {
+
+void controllerLimits() {
+  AdmissionController admission;
+  AdmissionLimits limits;
+  limits.maxConcurrency = 1;
+  limits.maxQueued = 2;
+
+  AdmissionController::Ticket first = admission.admit("t", limits);
+
+  // Two calls fit in the queue, the third is rejected
+  std::vector<int> order;
+  std::vector<AdmissionController::Ticket> resumed;
+  for (int i = 0; i < 2; ++i) {
+    AdmissionController::Ticket ticket;
+    bool admitted = admission.tryAdmit(
+        "t", limits, ticket, [&, i](AdmissionController::Ticket granted) {
+          order.push_back(i);
+          resumed.push_back(std::move(granted));
+        });
+    CHECK(!admitted);
+  }
+  bool rejected = false;
+  try {
+    AdmissionController::Ticket ticket;
+    admission.tryAdmit("t", limits, ticket,
+                       [](AdmissionController::Ticket) {});
+  } catch (const ServerBusyError &) {
+    rejected = true;
+  }
+  CHECK(rejected);
+
+  json stats = admission.stats();
+  CHECK_EQ(stats["tools"]["t"]["waiting"], json(2));
+  CHECK_EQ(stats["tools"]["t"]["rejected"], json(1));
+
+  // Each release hands the slot to the oldest parked call
+  first.release();
+  CHECK_EQ(order.size(), size_t{1});
+  resumed.front().release();
+  CHECK_EQ(order.size(), size_t{2});
+  CHECK(order == std::vector<int>({0, 1}));
+  resumed.clear();
+
+  stats = admission.stats();
+  CHECK_EQ(stats["tools"]["t"]["admitted"], json(3));
+  CHECK_EQ(stats["tools"]["t"]["queued"], json(2));
+  CHECK_EQ(stats["tools"]["t"]["inFlight"], json(0));
+  CHECK_EQ(stats["tools"]["t"]["peakInFlight"], json(1));
+
+  // No thread may block: a call that would have to wait is rejected
+  admission.setBlockingWaitLimit(0);
+  AdmissionController::Ticket held = admission.admit("t", limits);
+  rejected = false;
+  try {
+    admission.admit("t", limits);
+  } catch (const ServerBusyError &) {
+    rejected = true;
+  }
+  CHECK(rejected);
+}
+
+void globalQueueBound() {
+  AdmissionController admission;
+  admission.setGlobalLimits(2, 1);
+  AdmissionLimits capped;
+  capped.maxConcurrency = 1;
+  capped.maxQueued = 4;
+  std::vector<AdmissionController::Ticket> resumed;
+  auto park = [&](const std::string &tool, const AdmissionLimits &limits,
+                  bool countGlobal) {
+    AdmissionController::Ticket ticket;
+    try {
+      return admission.tryAdmit(
+                 tool, limits, ticket,
+                 [&](AdmissionController::Ticket granted) {
+                   resumed.push_back(std::move(granted));
+                 },
+                 countGlobal)
+                 ? 1
+                 : 0;
+    } catch (const ServerBusyError &) {
+      return -1;
+    }
+  };
+
+  // Calls waiting on the per-tool cap alone, top-level or nested, leave the
+  // global queue empty
+  AdmissionController::Ticket first = admission.admit("capped", capped);
+  CHECK_EQ(park("capped", capped, true), 0);
+  CHECK_EQ(park("capped", capped, false), 0);
+  json stats = admission.stats();
+  CHECK_EQ(stats["waiting"], json(2));
+  CHECK_EQ(stats["globalWaiting"], json(0));
+
+  // With every global slot taken, one call fits in the global queue
+  AdmissionController::Ticket second = admission.admit("free", {});
+  CHECK_EQ(park("free", {}, true), 0);
+  CHECK_EQ(park("free", {}, true), -1);
+  // A nested call needs no global slot and is not bounded by that queue
+  CHECK_EQ(park("free", {}, false), 1);
+  stats = admission.stats();
+  CHECK_EQ(stats["globalWaiting"], json(1));
+
+  // The freed global slot goes to the globally queued call
+  second.release();
+  stats = admission.stats();
+  CHECK_EQ(stats["globalWaiting"], json(0));
+  CHECK_EQ(stats["tools"]["free"]["inFlight"], json(1));
+
+  // Releasing a ticket may admit (and append) the next parked call
+  first.release();
+  while (!resumed.empty()) {
+    AdmissionController::Ticket ticket = std::move(resumed.back());
+    resumed.pop_back();
+  }
+  stats = admission.stats();
+  CHECK_EQ(stats["waiting"], json(0));
+  CHECK_EQ(stats["inFlight"], json(0));
+}
+
+void floodLeavesWorkers() {
+  McpServer server("admission_test", "1.0");
+  server.initialize();
+
+  McpTool slow;
+  slow.name = "slow";
+  slow.inputSchema = {{"type", "object"}};
+  slow.maxConcurrency = 1;
+  slow.maxQueued = 16;  // well above the worker count
+  server.addTool(slow, [](const json &) -> json {
+    std::this_thread::sleep_for(std::chrono::milliseconds(150));
+    return "slow";
+  });
+
+  QueueTransport transport;
+  std::thread serving([&] { server.serve(transport, 2); });
+
+  constexpr int kSlowCalls = 6;
+  for (int id = 1; id <= kSlowCalls; ++id) {
+    transport.push(toolCall(id, "slow", json::object()));
+  }
+  // Give the workers time to pick up the flood, then ask another tool
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  auto asked = QueueTransport::Clock::now();
+  transport.push(toolCall(100, "echo", {{"message", "hi"}}));
+
+  auto echo = transport.waitFor(100, std::chrono::seconds(5));
+  CHECK(echo.has_value());
+  if (echo) {
+    // Queued slow calls hold no worker, so echo does not wait for them
+    auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(
+        echo->second - asked);
+    CHECK(waited.count() < 100);
+    CHECK(!echo->first.contains("error"));
+  }
+
+  // Every queued call still runs, one at a time
+  for (int id = 1; id <= kSlowCalls; ++id) {
+    auto response = transport.waitFor(id, std::chrono::seconds(5));
+    CHECK(response.has_value());
+    if (response) CHECK(!response->first.contains("error"));
+  }
+  json stats = server.getAdmissionController().stats();
+  CHECK_EQ(stats["tools"]["slow"]["peakInFlight"], json(1));
+  CHECK(stats["tools"]["slow"]["queued"].get<int>() >= kSlowCalls - 2);
+
+  transport.close();
+  serving.join();
+}
+
+}  // namespace
+
+int main() {
+  spdlog::set_level(spdlog::level::off);
+  controllerLimits();
+  globalQueueBound();
+  floodLeavesWorkers();
+  return checkExitCode();
+}
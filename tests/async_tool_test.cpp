@@ -0,0 +1,110 @@
+// Coroutine tool handlers: results and errors of async tools, and admission
+// for them - calls queued behind a concurrency cap stay suspended instead of
+// holding a scheduler worker, and a full queue is still rejected.
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "check.h"
+#include "io_executor.h"
+#include "mcp_logger.h"
+#include "mcp_server.h"
+#include "queue_transport.h"
+
+namespace {
+
+json callAsync(McpServer &server, const std::string &name,
+               const json &arguments) {
+  std::string response;
+  server.processRequestAsync(toolCall(1, name, arguments),
+                             [&response](const std::string &answer) {
+                               response = answer;
+                             });
+  server.waitForAsyncCalls();
+  return json::parse(response);
+}
+
+int errorCode(const json &response) {
+  return response.contains("error") ? response["error"].value("code", 0) : 0;
+}
+
+}  // namespace
+
+int main() {
+  spdlog::set_level(spdlog::level::off);
+  McpServer server("async_tool_test", "1.0");
+  server.initialize();
+
+  constexpr int kQueued = 8;
+  McpTool tool;
+  tool.inputSchema = {{"type", "object"}};
+
+  tool.name = "nap";
+  tool.maxConcurrency = 1;
+  tool.maxQueued = kQueued;
+  server.addAsyncTool(tool, [&server](json arguments) -> ToolTask {
+    co_await server.getIoExecutor().sleepFor(
+        std::chrono::milliseconds(arguments.value("ms", 0)));
+    co_return json(arguments.value("ms", 0));
+  });
+
+  tool.name = "broken";
+  tool.maxConcurrency = 0;
+  server.addAsyncTool(tool, [&server](json) -> ToolTask {
+    co_await server.getIoExecutor().schedule();
+    throw std::runtime_error("broken");
+  });
+
+  // Result and error of a coroutine, through processRequestAsync
+  json napped = callAsync(server, "nap", {{"ms", 5}});
+  CHECK_EQ(errorCode(napped), 0);
+  CHECK_EQ(napped["result"]["content"][0]["text"], json("5"));
+  CHECK_EQ(errorCode(callAsync(server, "broken", json::object())), -32603);
+
+  // One worker thread: queued 'nap' calls must not hold it, so 'echo' is
+  // answered while they wait
+  QueueTransport transport;
+  std::thread serving([&] { server.serve(transport, 1); });
+
+  constexpr int kNaps = 4;
+  for (int id = 1; id <= kNaps; ++id) {
+    transport.push(toolCall(id, "nap", {{"ms", 100}}));
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(30));
+  auto asked = QueueTransport::Clock::now();
+  transport.push(toolCall(100, "echo", {{"message", "hi"}}));
+
+  auto echo = transport.waitFor(100, std::chrono::seconds(5));
+  CHECK(echo.has_value());
+  if (echo) {
+    auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(
+        echo->second - asked);
+    CHECK(waited.count() < 80);
+  }
+  for (int id = 1; id <= kNaps; ++id) {
+    auto response = transport.waitFor(id, std::chrono::seconds(5));
+    CHECK(response.has_value());
+    if (response) CHECK_EQ(errorCode(response->first), 0);
+  }
+  json stats = server.getAdmissionController().stats();
+  CHECK_EQ(stats["tools"]["nap"]["peakInFlight"], json(1));
+  CHECK_EQ(stats["tools"]["nap"]["queued"], json(kNaps - 1));
+
+  // More calls than the cap and the queue hold: the rest are rejected
+  constexpr int kFlood = 12;
+  for (int id = 200; id < 200 + kFlood; ++id) {
+    transport.push(toolCall(id, "nap", {{"ms", 50}}));
+  }
+  int rejected = 0;
+  for (int id = 200; id < 200 + kFlood; ++id) {
+    auto response = transport.waitFor(id, std::chrono::seconds(5));
+    CHECK(response.has_value());
+    if (response && errorCode(response->first) == -32001) ++rejected;
+  }
+  CHECK(rejected >= kFlood - 1 - kQueued);
+
+  transport.close();
+  serving.join();
+  return checkExitCode();
+}
@@ -0,0 +1,68 @@
+// Base64: RFC 4648 vectors, and the SIMD encoder against the scalar one for
+// every length around the vector widths and at unaligned offsets.
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "base64.h"
+#include "check.h"
+
+namespace {
+
+std::string encodeString(const std::string &text) {
+  return Base64::encode(text.data(), text.size());
+}
+
+void testVectors() {
+  CHECK_EQ(encodeString(""), std::string(""));
+  CHECK_EQ(encodeString("f"), std::string("Zg=="));
+  CHECK_EQ(encodeString("fo"), std::string("Zm8="));
+  CHECK_EQ(encodeString("foo"), std::string("Zm9v"));
+  CHECK_EQ(encodeString("foob"), std::string("Zm9vYg=="));
+  CHECK_EQ(encodeString("fooba"), std::string("Zm9vYmE="));
+  CHECK_EQ(encodeString("foobar"), std::string("Zm9vYmFy"));
+}
+
+void testMatchesScalar() {
+  std::vector<uint8_t> bytes(4096 + 64);
+  uint32_t state = 12345;
+  for (auto &byte : bytes) {
+    state = state * 1103515245 + 12345;
+    byte = static_cast<uint8_t>(state >> 16);
+  }
+  // Every value of every byte position goes through the alphabet
+  for (size_t i = 0; i < 256; ++i) bytes[i] = static_cast<uint8_t>(i);
+
+  for (size_t offset = 0; offset < 4; ++offset) {
+    for (size_t size = 0; size <= 4096; size += size < 200 ? 1 : 61) {
+      const uint8_t *data = bytes.data() + offset;
+      std::string expected(Base64::encodedSize(size), '\0');
+      Base64::encodeScalar(data, size, expected.data());
+      std::string actual(Base64::encodedSize(size), '\0');
+      Base64::encode(data, size, actual.data());
+      if (actual != expected) {
+        std::cerr << "size " << size << " offset " << offset << ": "
+                  << Base64::implementation() << " differs from scalar"
+                  << std::endl;
+        ++checkFailures();
+      }
+    }
+  }
+
+  std::string appended = "prefix:";
+  Base64::append(appended, bytes.data(), 100);
+  std::string expected(Base64::encodedSize(100), '\0');
+  Base64::encodeScalar(bytes.data(), 100, expected.data());
+  CHECK(appended == "prefix:" + expected);
+}
+
+}  // namespace
+
+int main() {
+  std::cout << "base64 encoder: " << Base64::implementation() << std::endl;
+  testVectors();
+  testMatchesScalar();
+  return checkExitCode();
+}
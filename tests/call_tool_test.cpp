@@ -0,0 +1,109 @@
+// tools/call through McpServer::processRequest: malformed params must get a
+// JSON-RPC error for their id instead of throwing out of the handler, on the
+// async path (processRequestAsync) as much as on the synchronous one. Ids
+// wider than an int are answered and cancelled exactly.
+#include <stdexcept>
+#include <string>
+
+#include "check.h"
+#include "mcp_logger.h"
+#include "mcp_server.h"
+
+namespace {
+
+json call(McpServer &server, const std::string &params) {
+  std::string response;
+  server.processRequest(
+      R"({"jsonrpc":"2.0","id":7,"method":"tools/call","params":)" + params +
+          "}",
+      response);
+  return json::parse(response);
+}
+
+json callAsync(McpServer &server, const std::string &params) {
+  std::string response;
+  server.processRequestAsync(
+      R"({"jsonrpc":"2.0","id":8,"method":"tools/call","params":)" + params +
+          "}",
+      [&response](const std::string &answer) { response = answer; });
+  server.waitForAsyncCalls();
+  return json::parse(response);
+}
+
+std::string send(McpServer &server, const json &message) {
+  std::string response;
+  server.processRequest(message.dump(), response);
+  return response;
+}
+
+json echoCall(const json &id) {
+  return {{"jsonrpc", "2.0"},
+          {"id", id},
+          {"method", "tools/call"},
+          {"params", {{"name", "echo"}, {"arguments", {{"message", "x"}}}}}};
+}
+
+int errorCode(const json &response) {
+  return response.contains("error") ? response["error"].value("code", 0) : 0;
+}
+
+}  // namespace
+
+int main() {
+  spdlog::set_level(spdlog::level::off);
+  McpServer server("call_tool_test", "1.0");
+  server.initialize();
+
+  McpTool thrower;
+  thrower.name = "thrower";
+  thrower.inputSchema = {{"type", "object"}};
+  server.addTool(thrower, [](const json &) -> json { throw 42; });
+
+  // Invalid params
+  CHECK_EQ(errorCode(call(server, "{}")), -32602);
+  CHECK_EQ(errorCode(call(server, R"({"name":5})")), -32602);
+  CHECK_EQ(errorCode(call(server, R"({"name":null})")), -32602);
+  CHECK_EQ(errorCode(call(server, R"({"name":["echo"]})")), -32602);
+  CHECK_EQ(errorCode(call(server, R"({"name":"echo","arguments":[1]})")),
+           -32602);
+  CHECK_EQ(errorCode(call(server, R"({"name":"echo","arguments":"x"})")),
+           -32602);
+  json invalid = call(server, "{}");
+  CHECK_EQ(invalid["id"], json(7));
+
+  // 'sleep' is an async tool: its params are checked before the coroutine
+  // is started
+  CHECK_EQ(errorCode(callAsync(server, R"({"name":"sleep","arguments":[1]})")),
+           -32602);
+  CHECK_EQ(errorCode(callAsync(server, R"({"name":5})")), -32602);
+  json slept = callAsync(server, R"({"name":"sleep","arguments":{"ms":1}})");
+  CHECK_EQ(errorCode(slept), 0);
+  CHECK_EQ(slept["id"], json(8));
+
+  // Unknown tool, a handler throwing a non-std exception, and a good call
+  CHECK_EQ(errorCode(call(server, R"({"name":"missing"})")), -32601);
+  CHECK_EQ(errorCode(call(server, R"({"name":"thrower"})")), -32603);
+  json ok = call(server, R"({"name":"echo","arguments":{"message":"hi"}})");
+  CHECK_EQ(errorCode(ok), 0);
+  CHECK_EQ(ok["result"]["content"][0]["text"], json("Echo: hi"));
+
+  // 64-bit and fractional ids come back unchanged, on errors too
+  const json wide = int64_t{5000000001};
+  json wideAnswer = json::parse(send(server, echoCall(wide)));
+  CHECK_EQ(wideAnswer["id"], wide);
+  json fractional = json::parse(send(server, echoCall(2.5)));
+  CHECK_EQ(fractional["id"], json(2.5));
+  json wideError = json::parse(send(
+      server, {{"jsonrpc", "2.0"}, {"id", wide}, {"method", "tools/call"}}));
+  CHECK_EQ(wideError["id"], wide);
+
+  // Cancelling 2^32 + 1 skips exactly that request, not id 1
+  const json cancelled = int64_t{4294967297};
+  send(server, {{"jsonrpc", "2.0"},
+                {"method", "notifications/cancelled"},
+                {"params", {{"requestId", cancelled}}}});
+  CHECK(!send(server, echoCall(1)).empty());
+  CHECK(send(server, echoCall(cancelled)).empty());
+
+  return checkExitCode();
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// Minimal assertions for the unit tests. A failed check prints where it
+// failed and the test keeps going; checkExitCode() makes the process (and so
+// the CTest case) fail if any check did.
+inline int &checkFailures() {
+  static int failures = 0;
+  return failures;
+}
+
+#define CHECK(condition)                                                  \
+  do {                                                                    \
+    if (!(condition)) {                                                   \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition  \
+                << ") failed" << std::endl;                               \
+      ++checkFailures();                                                  \
+    }                                                                     \
+  } while (0)
+
+#define CHECK_EQ(actual, expected)                                        \
+  do {                                                                    \
+    const auto &actualValue = (actual);                                   \
+    const auto &expectedValue = (expected);                               \
+    if (!(actualValue == expectedValue)) {                                \
+      std::ostringstream message;                                         \
+      message << __FILE__ << ":" << __LINE__ << ": " #actual " is "       \
+              << actualValue << ", expected " << expectedValue;           \
+      std::cerr << message.str() << std::endl;                            \
+      ++checkFailures();                                                  \
+    }                                                                     \
+  } while (0)
+
+inline int checkExitCode() {
+  if (checkFailures() == 0) return 0;
+  std::cerr << checkFailures() << " check(s) failed" << std::endl;
+  return 1;
+}
@@ -0,0 +1,183 @@
+// Log forwarding: the client level filters records, the token bucket and
+// the drop notice bound what is sent, long messages are cut on a UTF-8
+// boundary, payload traces are never forwarded, and stopping (or destroying
+// the server) removes the forwarder and restores the logger's level.
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <spdlog/sinks/null_sink.h>
+
+#include "check.h"
+#include "log_forwarder.h"
+#include "mcp_logger.h"
+#include "mcp_server.h"
+
+namespace {
+
+// Collects what the forwarder sends
+struct Client {
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<json> received;
+
+  void send(const json &params) {
+    std::lock_guard<std::mutex> lock(mutex);
+    received.push_back(params);
+    cv.notify_all();
+  }
+
+  // Everything received once 'count' messages have arrived (or after a
+  // timeout), waiting a little longer for any that should not arrive
+  std::vector<json> waitFor(size_t count) {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait_for(lock, std::chrono::seconds(2),
+                [&] { return received.size() >= count; });
+    lock.unlock();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    lock.lock();
+    return received;
+  }
+};
+
+// A logger shaped like setup_logger()'s: a leveled sink plus a forward sink
+std::shared_ptr<spdlog::logger> makeLogger(const std::string &name) {
+  auto sink = std::make_shared<spdlog::sinks::null_sink_mt>();
+  sink->set_level(spdlog::level::info);
+  auto logger = std::make_shared<spdlog::logger>(
+      name, spdlog::sinks_init_list{
+                sink, std::make_shared<spdlog::sinks::dist_sink_mt>()});
+  logger->set_level(spdlog::level::info);
+  return logger;
+}
+
+void attach(LogForwarder &forwarder,
+            const std::shared_ptr<spdlog::logger> &logger) {
+  forwarder.attach(logger, McpLogging::forward_sink(logger));
+}
+
+void levels() {
+  Client client;
+  auto forwarder = std::make_shared<LogForwarder>(
+      [&](const json &params) { client.send(params); });
+  auto logger = makeLogger("levels");
+  attach(*forwarder, logger);
+
+  CHECK_EQ(forwarder->level(), std::string("warning"));
+  logger->info("not sent");
+  logger->warn("sent");
+  CHECK(!forwarder->setLevel("verbose"));
+  CHECK(forwarder->setLevel("debug"));
+  // Below the logger's own level, yet forwarded at the client's request
+  logger->debug("debug sent");
+
+  auto received = client.waitFor(2);
+  CHECK_EQ(received.size(), size_t{2});
+  if (received.size() == 2) {
+    CHECK_EQ(received[0]["level"], json("warning"));
+    CHECK_EQ(received[0]["data"], json("sent"));
+    CHECK_EQ(received[0]["logger"], json("levels"));
+    CHECK_EQ(received[1]["level"], json("debug"));
+  }
+  CHECK_EQ(logger->level(), spdlog::level::debug);
+  forwarder->stop();
+
+  // Detached, with the logger as it was
+  CHECK(McpLogging::forward_sink(logger)->sinks().empty());
+  CHECK_EQ(logger->level(), spdlog::level::info);
+}
+
+void serverDetaches() {
+  McpLogging::setup_logger("log_forwarder_test", spdlog::level::info, "",
+                           false);
+  auto logger = spdlog::default_logger();
+  auto hub = McpLogging::forward_sink(logger);
+  CHECK(hub != nullptr);
+  {
+    McpServer server("log_forwarder_test", "1.0");
+    server.enableLogForwarding();
+    CHECK_EQ(hub->sinks().size(), size_t{1});
+    std::string response;
+    server.processRequest(
+        R"({"jsonrpc":"2.0","id":1,"method":"logging/setLevel",)"
+        R"("params":{"level":"debug"}})",
+        response);
+    CHECK_EQ(logger->level(), spdlog::level::debug);
+  }
+  CHECK(hub->sinks().empty());
+  CHECK_EQ(logger->level(), spdlog::level::info);
+}
+
+void rateLimit() {
+  Client client;
+  LogForwarderOptions options;
+  options.ratePerSecond = 0.001;
+  options.burst = 5;
+  options.dropReportIntervalMs = 20;
+  auto forwarder = std::make_shared<LogForwarder>(
+      [&](const json &params) { client.send(params); }, options);
+  auto logger = makeLogger("rate");
+  attach(*forwarder, logger);
+
+  for (int i = 0; i < 20; ++i) logger->error("flood " + std::to_string(i));
+  // The burst, then notices (usually one) for the rest
+  size_t sent = 0, dropped = 0;
+  for (size_t expected = 6; dropped < 15 && expected < 10; ++expected) {
+    sent = dropped = 0;
+    for (const auto &params : client.waitFor(expected)) {
+      if (params.value("logger", "") == "log_forwarder") {
+        dropped += std::stoul(params["data"].get<std::string>());
+      } else {
+        ++sent;
+      }
+    }
+  }
+  CHECK_EQ(sent, size_t{5});
+  CHECK_EQ(dropped, size_t{15});
+  json stats = forwarder->stats();
+  CHECK_EQ(stats["forwarded"], json(5));
+  CHECK_EQ(stats["droppedRateLimited"], json(15));
+  forwarder->stop();
+
+  // Stopped: nothing more is queued
+  logger->error("after stop");
+  stats = forwarder->stats();
+  CHECK_EQ(stats["queued"], json(0));
+}
+
+void truncation() {
+  Client client;
+  LogForwarderOptions options;
+  options.maxMessageBytes = 6;
+  auto forwarder = std::make_shared<LogForwarder>(
+      [&](const json &params) { client.send(params); }, options);
+  auto logger = makeLogger("truncation");
+  attach(*forwarder, logger);
+
+  // The cut at byte 6 falls inside the second euro sign
+  logger->warn("ab\xe2\x82\xac\xe2\x82\xac");
+  auto payload = makeLogger(McpLogging::kPayloadLoggerName);
+  attach(*forwarder, payload);
+  payload->warn("[IN] secret");
+
+  auto received = client.waitFor(1);
+  CHECK_EQ(received.size(), size_t{1});
+  if (!received.empty()) {
+    CHECK_EQ(received[0]["data"], json("ab\xe2\x82\xac"));
+  }
+  forwarder->stop();
+}
+
+}  // namespace
+
+int main() {
+  levels();
+  rateLimit();
+  truncation();
+  serverDetaches();
+  return checkExitCode();
+}
@@ -0,0 +1,108 @@
+// In-process client: tool calls with plain json values (async tools
+// included), typed results with base64 only in callToolResult, and the
+// JSON-RPC error codes McpError carries for unknown tools, a busy server,
+// resources and prompts.
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "check.h"
+#include "io_executor.h"
+#include "mcp_client.h"
+#include "mcp_logger.h"
+#include "mcp_server.h"
+#include "tool_content.h"
+
+namespace {
+
+int errorCode(const std::function<void()> &call) {
+  try {
+    call();
+  } catch (const McpError &e) {
+    return e.code();
+  }
+  return 0;
+}
+
+}  // namespace
+
+int main() {
+  spdlog::set_level(spdlog::level::off);
+  McpServer server("mcp_client_test", "1.0");
+  server.initialize();
+  McpClient client(server);
+
+  McpTool tool;
+  tool.inputSchema = {{"type", "object"}};
+  tool.name = "pixel";
+  server.addTool(tool, [](const json &) -> json {
+    return ToolContent::result({ToolContent::image({0xff, 0, 0}, "image/png")});
+  });
+  tool.name = "later";
+  server.addAsyncTool(tool, [&server](json arguments) -> ToolTask {
+    co_await server.getIoExecutor().schedule();
+    co_return arguments.value("n", 0) * 2;
+  });
+
+  // Gate the "held" tool waits on, to keep its one slot busy
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool entered = false, release = false;
+  tool.name = "held";
+  tool.maxConcurrency = 1;
+  tool.maxQueued = 0;
+  server.addTool(tool, [&](const json &) -> json {
+    std::unique_lock<std::mutex> lock(mutex);
+    entered = true;
+    cv.notify_all();
+    cv.wait(lock, [&] { return release; });
+    return "held";
+  });
+
+  auto tools = client.listTools();
+  CHECK(std::any_of(tools.begin(), tools.end(),
+                    [](const McpTool &t) { return t.name == "echo"; }));
+
+  CHECK_EQ(client.callTool("echo", {{"message", "hi"}}), json("Echo: hi"));
+  json echoed = client.callToolResult("echo", {{"message", "hi"}});
+  CHECK_EQ(echoed["content"][0]["text"], json("Echo: hi"));
+  CHECK_EQ(client.callTool("later", {{"n", 21}}), json(42));
+
+  // Binary stays binary until the MCP result is built
+  json raw = client.callTool("pixel");
+  CHECK(raw["content"][0]["data"].is_binary());
+  json encoded = client.callToolResult("pixel");
+  CHECK_EQ(encoded["content"][0]["data"], json("/wAA"));
+
+  CHECK_EQ(errorCode([&] { client.callTool("missing"); }), -32601);
+
+  std::thread holder([&] { client.callTool("held"); });
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&] { return entered; });
+  }
+  CHECK_EQ(errorCode([&] { client.callTool("held"); }), kServerBusyError);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    release = true;
+  }
+  cv.notify_all();
+  holder.join();
+
+  CHECK_EQ(errorCode([&] { client.readResource("file:///nowhere"); }),
+           -32002);
+  CHECK_EQ(errorCode([&] { client.listResources("not a cursor"); }), -32602);
+
+  McpPrompt prompt;
+  prompt.name = "greet";
+  prompt.arguments = {{"who", "", true, ""}};
+  server.addPrompt(prompt, "Hello {{who}}");
+  json greeting = client.getPrompt("greet", {{"who", "you"}});
+  CHECK_EQ(greeting["messages"][0]["content"]["text"], json("Hello you"));
+  CHECK_EQ(errorCode([&] { client.getPrompt("greet"); }), -32602);
+  CHECK(!client.listPrompts()["prompts"].empty());
+  return checkExitCode();
+}
@@ -0,0 +1,145 @@
+// Memory budgets: scope accounting (nesting, frees on another thread, the
+// nothrow refusal) and, through McpServer, requests and tool calls over
+// their budget answered with kMemoryBudgetError while others still succeed.
+// Needs the counting operator new of memory_hooks.cpp; without it there is
+// nothing to check.
+#include <cstdio>
+#include <memory>
+#include <new>
+#include <string>
+#include <thread>
+
+#include "check.h"
+#include "io_executor.h"
+#include "mcp_logger.h"
+#include "mcp_server.h"
+#include "memory_accounting.h"
+#include "queue_transport.h"
+
+namespace {
+
+constexpr size_t kBlock = 1 << 20;
+
+// Keeps allocations observable so they are not optimized away
+char *volatile sink = nullptr;
+
+std::unique_ptr<char[]> allocate(size_t bytes) {
+  std::unique_ptr<char[]> block(new char[bytes]);
+  block[bytes - 1] = 1;
+  sink = block.get();
+  return block;
+}
+
+void scopes() {
+  std::unique_ptr<char[]> elsewhere;
+  {
+    MemoryScope outer(0, "outer");
+    {
+      MemoryScope inner(kBlock / 2, "inner");
+      auto block = allocate(kBlock);
+      CHECK(inner.exceeded());
+      CHECK(!outer.exceeded());
+      // Counted against both scopes
+      CHECK(inner.peakBytes() >= kBlock);
+      CHECK(outer.peakBytes() >= kBlock);
+
+      bool thrown = false;
+      try {
+        MemoryScope::checkpoint();
+      } catch (const MemoryBudgetExceeded &e) {
+        thrown = true;
+        CHECK(e.message().find("inner") != std::string::npos);
+      }
+      CHECK(thrown);
+
+      // The nothrow form refuses instead of going over the limit
+      char *refused = new (std::nothrow) char[kBlock];
+      CHECK(refused == nullptr);
+      delete[] refused;
+    }
+
+    // Freed on another thread, the block is still credited to this scope
+    int64_t before = outer.currentBytes();
+    elsewhere = allocate(kBlock);
+    CHECK(outer.currentBytes() >= before + int64_t(kBlock));
+    std::thread([&] { elsewhere.reset(); }).join();
+    CHECK(outer.currentBytes() < before + int64_t(kBlock));
+    MemoryScope::checkpoint();
+  }
+}
+
+json call(McpServer &server, const std::string &name) {
+  std::string response;
+  server.processRequest(toolCall(1, name, json::object()), response);
+  return json::parse(response);
+}
+
+json callAsync(McpServer &server, const std::string &name) {
+  std::string response;
+  server.processRequestAsync(toolCall(1, name, json::object()),
+                             [&response](const std::string &answer) {
+                               response = answer;
+                             });
+  server.waitForAsyncCalls();
+  return json::parse(response);
+}
+
+int errorCode(const json &response) {
+  return response.contains("error") ? response["error"].value("code", 0) : 0;
+}
+
+void serverBudgets() {
+  McpServer server("memory_budget_test", "1.0");
+  server.initialize();
+
+  McpTool tool;
+  tool.inputSchema = {{"type", "object"}};
+  tool.name = "hog";
+  server.addTool(tool, [](const json &) -> json {
+    auto block = allocate(kBlock);
+    return "done";
+  });
+  tool.name = "frugal";
+  server.addTool(tool, [](const json &) -> json { return "done"; });
+  tool.name = "async_hog";
+  tool.memoryBudget = kBlock / 2;
+  server.addAsyncTool(tool, [&server](json) -> ToolTask {
+    auto block = allocate(kBlock);
+    // The budget is checked when the coroutine resumes
+    co_await server.getIoExecutor().schedule();
+    co_return "done";
+  });
+
+  // No budgets yet
+  CHECK_EQ(errorCode(call(server, "hog")), 0);
+
+  // A tool's own budget, even though its handler never checks it
+  CHECK(server.setToolMemoryBudget("hog", kBlock / 2));
+  json over = call(server, "hog");
+  CHECK_EQ(errorCode(over), kMemoryBudgetError);
+  CHECK(over["error"].value("message", "").find("tool hog") !=
+        std::string::npos);
+  CHECK_EQ(errorCode(call(server, "frugal")), 0);
+  CHECK_EQ(errorCode(callAsync(server, "async_hog")), kMemoryBudgetError);
+
+  // The request budget covers tools without one of their own
+  CHECK(server.setToolMemoryBudget("hog", 0));
+  server.setMemoryBudget(kBlock / 2);
+  CHECK_EQ(errorCode(call(server, "hog")), kMemoryBudgetError);
+  CHECK_EQ(errorCode(call(server, "frugal")), 0);
+  server.setMemoryBudget(0);
+  CHECK_EQ(errorCode(call(server, "hog")), 0);
+}
+
+}  // namespace
+
+int main() {
+  spdlog::set_level(spdlog::level::off);
+  if (!MemoryScope::supported()) {
+    std::printf("memory accounting not linked in, skipped\n");
+    return 0;
+  }
+  scopes();
+  serverBudgets();
+  return checkExitCode();
+}
@@ -0,0 +1,89 @@
+// Tool plugins: tools registered from a library's own manifest, results and
+// errors through tools/call, broken libraries skipped, and a library
+// replaced on disk reloaded on a later call. The two builds of
+// test_plugin.cpp are passed in as TEST_PLUGIN_V1 and TEST_PLUGIN_V2.
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <thread>
+
+#include "check.h"
+#include "mcp_logger.h"
+#include "mcp_server.h"
+#include "plugin_manager.h"
+#include "queue_transport.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+json call(McpServer &server, const std::string &tool, const json &arguments) {
+  std::string response;
+  server.processRequest(toolCall(1, tool, arguments), response);
+  return json::parse(response);
+}
+
+std::string resultText(const json &response) {
+  if (!response.contains("result")) return "<error>";
+  return response["result"]["content"][0].value("text", "");
+}
+
+// Replace 'target' the way an install does: a new file renamed over it
+void install(const fs::path &library, const fs::path &target) {
+  fs::path temporary = target;
+  temporary += ".tmp";
+  fs::copy_file(library, temporary, fs::copy_options::overwrite_existing);
+  fs::rename(temporary, target);
+}
+
+}  // namespace
+
+int main() {
+  spdlog::set_level(spdlog::level::off);
+  std::string name = "plugin_test_";
+  name += std::to_string(std::random_device()());
+  fs::path dir = fs::temp_directory_path() / name;
+  fs::create_directories(dir);
+  fs::path library = dir / "libtest.so";
+  install(TEST_PLUGIN_V1, library);
+  std::ofstream(dir / "broken.so") << "not a library";
+
+  McpServer server("plugin_test", "1.0");
+  server.initialize();
+  CHECK_EQ(server.loadPlugins(dir.string()), size_t{1});
+
+  auto snapshot = server.getToolSnapshot();
+  CHECK(snapshot->find("plugin_version") != nullptr);
+  CHECK(snapshot->find("plugin_echo") != nullptr);
+
+  CHECK_EQ(resultText(call(server, "plugin_version", json::object())),
+           std::string("1"));
+  CHECK_EQ(resultText(call(server, "plugin_echo", {{"x", 1}})),
+           std::string(R"({"x":1})"));
+
+  // A non-zero return is a tool error carrying the plugin's message
+  json failed = call(server, "plugin_missing", json::object());
+  CHECK(failed.contains("error"));
+  if (failed.contains("error")) {
+    CHECK(failed["error"].value("message", "").find("no such tool") !=
+          std::string::npos);
+  }
+
+  // Replaced on disk: a call after the check interval uses the new build
+  install(TEST_PLUGIN_V2, library);
+  std::string version;
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (version != "2" && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(PluginManager::kReloadCheckIntervalMs / 5));
+    version = resultText(call(server, "plugin_version", json::object()));
+  }
+  CHECK_EQ(version, std::string("2"));
+  CHECK_EQ(resultText(call(server, "plugin_echo", {{"y", 2}})),
+           std::string(R"({"y":2})"));
+
+  fs::remove_all(dir);
+  return checkExitCode();
+}
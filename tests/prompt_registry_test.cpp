@@ -0,0 +1,83 @@
+// Prompt templates: placeholders filled from string and non-string
+// arguments, defaults for omitted optional ones, literals kept verbatim
+// around empty values, and errors for bad templates, unknown prompts and
+// missing required arguments.
+#include <stdexcept>
+#include <string>
+
+#include "check.h"
+#include "prompt_registry.h"
+
+namespace {
+
+std::string text(const json &result) {
+  return result["messages"][0]["content"].value("text", "");
+}
+
+template <typename F>
+bool invalid(F &&f) {
+  try {
+    f();
+  } catch (const std::invalid_argument &) {
+    return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+int main() {
+  PromptRegistry prompts;
+  CHECK(prompts.empty());
+
+  McpPrompt review;
+  review.name = "review";
+  review.description = "Review code";
+  review.arguments = {{"code", "Code to review", true, ""},
+                      {"language", "Its language", false, ""},
+                      {"focus", "What to look at", false, "correctness"}};
+  prompts.addPrompt(review,
+                    "Review this code for {{ focus }}:\n{{code}}\n({{language}})");
+  CHECK(!prompts.empty());
+
+  CHECK_EQ(text(prompts.get("review", {{"code", "x = 1"},
+                                       {"language", "Python"},
+                                       {"focus", "style"}})),
+           std::string("Review this code for style:\nx = 1\n(Python)"));
+  // Defaults; an empty value leaves the literals around it as they are
+  CHECK_EQ(text(prompts.get("review", {{"code", "x = 1"}})),
+           std::string("Review this code for correctness:\nx = 1\n()"));
+  // Non-string values are rendered as JSON; null counts as omitted
+  CHECK_EQ(text(prompts.get("review", {{"code", json::array({1, 2})},
+                                       {"focus", nullptr}})),
+           std::string("Review this code for correctness:\n[1,2]\n()"));
+
+  json result = prompts.get("review", {{"code", "y"}});
+  CHECK_EQ(result["description"], json("Review code"));
+  CHECK_EQ(result["messages"][0]["role"], json("user"));
+
+  json listed = prompts.list()["prompts"];
+  CHECK_EQ(listed.size(), size_t{1});
+  CHECK_EQ(listed[0]["arguments"].size(), size_t{3});
+  CHECK_EQ(listed[0]["arguments"][0]["required"], json(true));
+
+  CHECK(invalid([&] { prompts.get("review", json::object()); }));
+  CHECK(invalid([&] { prompts.get("missing", json::object()); }));
+  CHECK(invalid([&] { prompts.addPrompt(review, "{{code"); }));
+  CHECK(invalid([&] { prompts.addPrompt(review, "{{unknown}}"); }));
+  // A failed registration leaves the previous template in place
+  CHECK_EQ(text(prompts.get("review", {{"code", "z"}})),
+           std::string("Review this code for correctness:\nz\n()"));
+
+  // Spaces around an empty value are not touched
+  McpPrompt spaced = review;
+  spaced.name = "spaced";
+  prompts.addPrompt(spaced, "a {{language}} b{{code}}");
+  CHECK_EQ(text(prompts.get("spaced", {{"code", " c"}})),
+           std::string("a  b c"));
+
+  // Replacing a prompt
+  prompts.addPrompt(review, "{{code}}!");
+  CHECK_EQ(text(prompts.get("review", {{"code", "z"}})), std::string("z!"));
+  return checkExitCode();
+}
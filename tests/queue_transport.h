@@ -0,0 +1,81 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <nlohmann/json.hpp>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "transport_adapter.h"
+
+using json = nlohmann::json;
+
+// In-memory transport for tests that drive McpServer::serve(): the test
+// pushes requests and waits for responses, which are recorded with the time
+// they were written
+class QueueTransport : public ITransportAdapter {
+ public:
+  using Clock = std::chrono::steady_clock;
+  // A response and when it was written
+  using Response = std::pair<json, Clock::time_point>;
+
+  void push(const std::string &message) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    incoming_.push_back(message);
+    cv_.notify_all();
+  }
+  void close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    cv_.notify_all();
+  }
+
+  bool readMessage(std::string &message) override {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return closed_ || !incoming_.empty(); });
+    if (incoming_.empty()) return false;
+    message = std::move(incoming_.front());
+    incoming_.pop_front();
+    return true;
+  }
+  bool writeMessage(const std::string &message) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    json parsed = json::parse(message);
+    if (parsed.contains("id")) responses_.push_back({parsed, Clock::now()});
+    cv_.notify_all();
+    return true;
+  }
+
+  // Wait for the response to 'id'
+  std::optional<Response> waitFor(int id, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::optional<Response> found;
+    cv_.wait_for(lock, timeout, [&] {
+      for (const auto &response : responses_) {
+        if (response.first["id"] == id) found = response;
+      }
+      return found.has_value();
+    });
+    return found;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::string> incoming_;
+  std::vector<Response> responses_;
+  bool closed_ = false;
+};
+
+// A 'tools/call' request
+inline std::string toolCall(int id, const std::string &name,
+                            const json &arguments) {
+  return json{{"jsonrpc", "2.0"},
+              {"id", id},
+              {"method", "tools/call"},
+              {"params", {{"name", name}, {"arguments", arguments}}}}
+      .dump();
+}
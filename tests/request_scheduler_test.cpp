@@ -0,0 +1,97 @@
+// Request scheduler: control tasks run while every worker is busy with tool
+// work, queued work is stolen by idle workers, and shutdown() runs whatever
+// was already submitted.
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "check.h"
+#include "request_scheduler.h"
+
+namespace {
+
+using Lane = RequestScheduler::Lane;
+using namespace std::chrono_literals;
+
+// Gate the work tasks wait on until the test opens it
+struct Gate {
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool open = false;
+
+  void wait() {
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [&] { return open; });
+  }
+  void release() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      open = true;
+    }
+    cv.notify_all();
+  }
+};
+
+void controlBypassesWork() {
+  RequestScheduler scheduler(2);
+  Gate gate;
+  std::atomic<int> started{0};
+  for (size_t i = 0; i < scheduler.workerCount() + 2; ++i) {
+    scheduler.submit(Lane::Work, [&] {
+      ++started;
+      gate.wait();
+    });
+  }
+
+  // Every worker is blocked, yet a control task still runs
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool pinged = false;
+  scheduler.submit(Lane::Control, [&] {
+    std::lock_guard<std::mutex> lock(mutex);
+    pinged = true;
+    cv.notify_all();
+  });
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    CHECK(cv.wait_for(lock, 2s, [&] { return pinged; }));
+  }
+  CHECK(started.load() <= int(scheduler.workerCount()));
+
+  gate.release();
+  scheduler.shutdown();
+  CHECK_EQ(started.load(), int(scheduler.workerCount()) + 2);
+}
+
+void idleWorkersSteal() {
+  RequestScheduler scheduler(4);
+  Gate gate;
+  std::atomic<int> done{0};
+  // One long task, and short ones spread round-robin behind it
+  scheduler.submit(Lane::Work, [&] { gate.wait(); });
+  for (int i = 0; i < 40; ++i) {
+    scheduler.submit(Lane::Work, [&] {
+      std::this_thread::sleep_for(1ms);
+      ++done;
+    });
+  }
+  // The short tasks queued behind the long one must not wait for it
+  auto deadline = std::chrono::steady_clock::now() + 2s;
+  while (done.load() < 40 && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(1ms);
+  }
+  CHECK_EQ(done.load(), 40);
+  CHECK(scheduler.stolenCount() > 0);
+  gate.release();
+  scheduler.shutdown();
+}
+
+}  // namespace
+
+int main() {
+  controlBypassesWork();
+  idleWorkersSteal();
+  return checkExitCode();
+}
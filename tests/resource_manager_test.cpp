@@ -0,0 +1,181 @@
+// Resources: chunked reads that never split a UTF-8 sequence, binary files
+// as base64 blobs, reads after a file shrinks, paths outside the roots, and
+// list paging that neither skips nor repeats files removed between pages.
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+
+#include "base64.h"
+#include "check.h"
+#include "mcp_logger.h"
+#include "resource_manager.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+void writeFile(const fs::path &path, const std::string &data) {
+  std::ofstream out(path, std::ios::binary);
+  out << data;
+}
+
+bool throws(ResourceManager &resources, const std::string &uri) {
+  try {
+    resources.read(uri, 0, 0);
+  } catch (const std::runtime_error &) {
+    return true;
+  }
+  return false;
+}
+
+void chunkedReads(ResourceManager &resources, const fs::path &dir) {
+  // Two-, three- and four-byte sequences, so small chunks land inside them
+  std::string text;
+  for (int i = 0; i < 20; ++i) text += "a\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80";
+  writeFile(dir / "text.txt", text);
+  std::string uri = ResourceManager::uriForPath((dir / "text.txt").string());
+
+  // (A chunk shorter than a sequence cannot avoid splitting it)
+  for (size_t length : {4, 5, 6, 7, 64}) {
+    std::string joined;
+    uint64_t offset = 0;
+    for (int reads = 0; reads < 1000; ++reads) {
+      json content = resources.read(uri, offset, length)["contents"][0];
+      CHECK(content.contains("text"));
+      CHECK_EQ(content["totalSize"], json(text.size()));
+      joined += content.value("text", "");
+      if (!content.contains("nextOffset")) break;
+      uint64_t next = content["nextOffset"];
+      CHECK(next > offset);
+      offset = next;
+    }
+    CHECK(joined == text);
+  }
+
+  // Past the end
+  CHECK(resources.read(uri, text.size(), 0)["contents"][0].value("text", "x")
+            .empty());
+  bool beyond = false;
+  try {
+    resources.read(uri, text.size() + 1, 0);
+  } catch (const std::runtime_error &) {
+    beyond = true;
+  }
+  CHECK(beyond);
+
+  // A file that shrinks after it was opened (and cached) reads as shorter
+  writeFile(dir / "text.txt", "short");
+  json shrunk = resources.read(uri, 0, 0)["contents"][0];
+  CHECK_EQ(shrunk["text"], json("short"));
+  CHECK(!shrunk.contains("nextOffset"));
+}
+
+void binaryReads(ResourceManager &resources, const fs::path &dir) {
+  std::string bytes("\x00\x01\xff\xfe", 4);
+  writeFile(dir / "data.bin", bytes);
+  json content = resources.read(
+      ResourceManager::uriForPath((dir / "data.bin").string()), 0,
+      0)["contents"][0];
+  CHECK_EQ(content["mimeType"], json("application/octet-stream"));
+  CHECK(!content.contains("text"));
+  std::string encoded;
+  Base64::append(encoded, reinterpret_cast<const uint8_t *>(bytes.data()),
+                 bytes.size());
+  CHECK_EQ(content["blob"], json(encoded));
+
+  // Invalid UTF-8 in a text file is sent as a blob too
+  writeFile(dir / "broken.txt", "ok\xff");
+  json broken = resources.read(
+      ResourceManager::uriForPath((dir / "broken.txt").string()), 0,
+      0)["contents"][0];
+  CHECK(broken.contains("blob"));
+}
+
+void outsideRoots(ResourceManager &resources, const fs::path &dir,
+                  const fs::path &outside) {
+  writeFile(outside / "secret.txt", "secret");
+  CHECK(throws(resources,
+               ResourceManager::uriForPath((outside / "secret.txt").string())));
+  fs::path escaped = dir / ".." / "outside" / "secret.txt";
+  CHECK(throws(resources, ResourceManager::uriForPath(escaped.string())));
+  CHECK(throws(resources, "http://example.com/text.txt"));
+  CHECK(throws(resources, ResourceManager::uriForPath(
+                              (dir / "missing.txt").string())));
+  // A link inside a root to a file outside it (where links can be made)
+  std::error_code ec;
+  fs::create_symlink(outside / "secret.txt", dir / "link.txt", ec);
+  if (!ec) {
+    CHECK(throws(resources,
+                 ResourceManager::uriForPath((dir / "link.txt").string())));
+    fs::remove(dir / "link.txt");
+  }
+}
+
+void listPaging(ResourceManager &resources, const fs::path &dir) {
+  fs::create_directory(dir / "many");
+  for (size_t i = 0; i < ResourceManager::kPageSize + 10; ++i) {
+    writeFile(dir / "many" / (std::to_string(i) + ".txt"), "x");
+  }
+  size_t files = 0;
+  for (const auto &entry : fs::recursive_directory_iterator(dir)) {
+    if (entry.is_regular_file() && !entry.is_symlink()) ++files;
+  }
+  std::set<std::string> listed;
+  size_t entries = 0;
+  std::string cursor;
+  int pages = 0;
+  do {
+    json page = resources.list(cursor);
+    for (const auto &resource : page["resources"]) {
+      listed.insert(resource["uri"].get<std::string>());
+      ++entries;
+    }
+    CHECK(page["resources"].size() <= ResourceManager::kPageSize);
+    // Files removed after the first page shift nothing
+    if (pages == 0) {
+      const json &first = page["resources"][0];
+      fs::remove(first["uri"].get<std::string>().substr(7));
+    }
+    cursor = page.value("nextCursor", "");
+    ++pages;
+  } while (!cursor.empty() && pages < 10);
+  CHECK_EQ(pages, 2);
+  CHECK_EQ(entries, listed.size());
+  CHECK_EQ(listed.size(), files);
+
+  bool rejected = false;
+  try {
+    resources.list("file:///elsewhere/x.txt");
+  } catch (const std::runtime_error &) {
+    rejected = true;
+  }
+  CHECK(rejected);
+}
+
+}  // namespace
+
+int main() {
+  spdlog::set_level(spdlog::level::off);
+  std::string name = "resource_manager_test_";
+  name += std::to_string(std::random_device()());
+  fs::path base = fs::temp_directory_path() / name;
+  fs::path dir = base / "root";
+  fs::path outside = base / "outside";
+  fs::create_directories(dir);
+  fs::create_directories(outside);
+
+  ResourceManager resources;
+  CHECK(!resources.addRoot((base / "none").string()));
+  CHECK(resources.addRoot(dir.string()));
+
+  chunkedReads(resources, dir);
+  binaryReads(resources, dir);
+  outsideRoots(resources, dir, outside);
+  listPaging(resources, dir);
+
+  fs::remove_all(base);
+  return checkExitCode();
+}
@@ -0,0 +1,113 @@
+// Resource watcher: in-place writes and rename-over saves of a watched file
+// are reported in one debounced batch, unwatched files are not, and a
+// deleted directory reports its files as lost. Linux only (inotify).
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+#include "mcp_logger.h"
+#include "resource_watcher.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Batches {
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::vector<std::vector<std::string>> changed;
+  std::vector<std::string> lost;
+
+  void add(const std::vector<std::string> &paths) {
+    std::lock_guard<std::mutex> lock(mutex);
+    changed.push_back(paths);
+    cv.notify_all();
+  }
+  void addLost(const std::vector<std::string> &paths) {
+    std::lock_guard<std::mutex> lock(mutex);
+    lost.insert(lost.end(), paths.begin(), paths.end());
+    cv.notify_all();
+  }
+  // Paths of the batches received from now until one arrives
+  std::set<std::string> next() {
+    std::unique_lock<std::mutex> lock(mutex);
+    size_t seen = changed.size();
+    cv.wait_for(lock, std::chrono::seconds(2),
+                [&] { return changed.size() > seen; });
+    std::set<std::string> paths;
+    for (size_t i = seen; i < changed.size(); ++i) {
+      paths.insert(changed[i].begin(), changed[i].end());
+    }
+    return paths;
+  }
+};
+
+void writeFile(const fs::path &path, const std::string &data) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out << data;
+}
+
+}  // namespace
+
+int main() {
+  spdlog::set_level(spdlog::level::off);
+  std::string name = "resource_watcher_test_";
+  name += std::to_string(std::random_device()());
+  fs::path dir = fs::temp_directory_path() / name;
+  fs::create_directories(dir / "sub");
+  writeFile(dir / "a.txt", "a");
+  writeFile(dir / "b.txt", "b");
+  writeFile(dir / "sub" / "c.txt", "c");
+  dir = fs::canonical(dir);
+  std::string a = (dir / "a.txt").string();
+  std::string c = (dir / "sub" / "c.txt").string();
+
+  Batches batches;
+  ResourceWatcher watcher(
+      [&](const std::vector<std::string> &paths) { batches.add(paths); },
+      [&](const std::vector<std::string> &paths) { batches.addLost(paths); });
+  if (!watcher.watch(a)) {
+    std::printf("inotify not available, skipped\n");
+    fs::remove_all(dir);
+    return 0;
+  }
+  CHECK(watcher.watch(c));
+
+  // Several quick writes, one batch; b.txt shares the directory but is not
+  // watched
+  for (int i = 0; i < 5; ++i) writeFile(dir / "a.txt", std::to_string(i));
+  writeFile(dir / "b.txt", "changed");
+  CHECK(batches.next() == std::set<std::string>({a}));
+
+  // Saved by renaming a new file over it
+  writeFile(dir / "a.txt.tmp", "renamed");
+  fs::rename(dir / "a.txt.tmp", dir / "a.txt");
+  CHECK(batches.next().count(a) == 1);
+
+  // Unwatched: no longer reported
+  watcher.unwatch(a);
+  writeFile(dir / "a.txt", "quiet");
+  writeFile(c, "loud");
+  CHECK(batches.next() == std::set<std::string>({c}));
+
+  // Deleting the directory loses its files
+  fs::remove_all(dir / "sub");
+  {
+    std::unique_lock<std::mutex> lock(batches.mutex);
+    batches.cv.wait_for(lock, std::chrono::seconds(2),
+                        [&] { return !batches.lost.empty(); });
+    CHECK(batches.lost == std::vector<std::string>({c}));
+  }
+
+  fs::remove_all(dir);
+  return checkExitCode();
+}
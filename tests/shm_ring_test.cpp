@@ -0,0 +1,132 @@
+// ShmRing: wraparound, messages larger than the ring, close semantics and
+// hostile length prefixes. Both ends live in this process.
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+#include "shm_ring.h"
+
+namespace {
+
+// Ring region with the alignment shared memory would have
+struct Region {
+  explicit Region(size_t capacity)
+      : words((ShmRing::regionSize(capacity) + 7) / 8) {}
+  void *data() { return words.data(); }
+  std::vector<uint64_t> words;
+};
+
+std::string pattern(size_t size, unsigned seed) {
+  std::string text(size, '\0');
+  for (size_t i = 0; i < size; ++i) {
+    text[i] = static_cast<char>('a' + (i * 7 + seed) % 26);
+  }
+  return text;
+}
+
+void testWraparound() {
+  Region region(4096);
+  ShmRing writer = ShmRing::create(region.data(), 4096);
+  ShmRing reader = ShmRing::attach(region.data());
+
+  // Sizes that do not divide the capacity, so messages and their length
+  // prefixes straddle the end of the ring many times
+  std::string message;
+  for (unsigned i = 0; i < 500; ++i) {
+    std::string sent = pattern(1 + (i * 131) % 3000, i);
+    CHECK(writer.write(sent));
+    CHECK(reader.read(message));
+    CHECK(message == sent);
+  }
+  CHECK(writer.write(std::string()));
+  CHECK(reader.read(message));
+  CHECK(message.empty());
+}
+
+void testLargerThanRing() {
+  Region region(4096);
+  ShmRing writer = ShmRing::create(region.data(), 4096);
+  ShmRing reader = ShmRing::attach(region.data());
+
+  std::string sent = pattern(1 << 20, 3);
+  std::string received;
+  bool readOk = false;
+  std::thread consumer([&] { readOk = reader.read(received); });
+  CHECK(writer.write(sent));
+  consumer.join();
+  CHECK(readOk);
+  CHECK(received == sent);
+}
+
+void testClose() {
+  Region region(4096);
+  ShmRing writer = ShmRing::create(region.data(), 4096);
+  ShmRing reader = ShmRing::attach(region.data());
+
+  // Messages written before close() are still delivered, then reads fail
+  CHECK(writer.write(std::string("first")));
+  CHECK(writer.write(std::string("second")));
+  writer.close();
+  CHECK(!writer.write(std::string("late")));
+  std::string message;
+  CHECK(reader.read(message));
+  CHECK_EQ(message, std::string("first"));
+  CHECK(reader.read(message));
+  CHECK_EQ(message, std::string("second"));
+  CHECK(!reader.read(message));
+
+  // close() wakes a reader blocked on an empty ring
+  reader.reset();
+  bool readOk = true;
+  std::thread blocked([&] { readOk = reader.read(message); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  writer.close();
+  blocked.join();
+  CHECK(!readOk);
+
+  // ...and a writer blocked on a full ring
+  reader.reset();
+  bool writeOk = true;
+  std::thread full([&] { writeOk = writer.write(pattern(16384, 1)); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  reader.close();
+  full.join();
+  CHECK(!writeOk);
+}
+
+void testPredicateGivesUp() {
+  Region region(4096);
+  ShmRing reader = ShmRing::create(region.data(), 4096);
+  std::string message;
+  int calls = 0;
+  CHECK(!reader.read(message, [&calls] { return ++calls < 2; }));
+  CHECK_EQ(calls, 2);
+}
+
+void testOversizedLength() {
+  Region region(4096);
+  ShmRing writer = ShmRing::create(region.data(), 4096);
+  ShmRing reader = ShmRing::attach(region.data());
+
+  // A peer announcing more than maxSize closes the ring instead of making
+  // the reader allocate it
+  CHECK(writer.write(pattern(100, 0)));
+  std::string message;
+  CHECK(!reader.read(message, {}, 10));
+  CHECK(!writer.write(std::string("after")));
+  CHECK(message.empty());
+}
+
+}  // namespace
+
+int main() {
+  testWraparound();
+  testLargerThanRing();
+  testClose();
+  testPredicateGivesUp();
+  testOversizedLength();
+  return checkExitCode();
+}
@@ -0,0 +1,73 @@
+// Shared-memory transport end to end: a client talks to serve() through an
+// ShmAdapter, with messages larger than the rings; a second client or a
+// second server on the same segment is refused; and serve() ends when the
+// client goes away.
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "check.h"
+#include "mcp_client.h"
+#include "mcp_logger.h"
+#include "mcp_server.h"
+#include "shm_adapter.h"
+#include "shm_client.h"
+
+namespace {
+
+template <typename F>
+bool refused(F &&f) {
+  try {
+    f();
+  } catch (const std::runtime_error &) {
+    return true;
+  }
+  return false;
+}
+
+}  // namespace
+
+int main() {
+  spdlog::set_level(spdlog::level::off);
+  constexpr size_t kRingCapacity = 4096;
+  std::string name = ShmTransportSegment::defaultName() + "_test";
+
+  McpServer server("shm_transport_test", "1.0");
+  server.initialize();
+  ShmAdapter adapter(name, kRingCapacity);
+  CHECK(refused([&] { ShmAdapter second(name, kRingCapacity); }));
+  std::thread serving([&] { server.serve(adapter, 2); });
+
+  {
+    ShmClient client(name);
+    CHECK(refused([&] { ShmClient second(name); }));
+
+    json tools = client.call("tools/list");
+    CHECK(tools.contains("tools") && !tools["tools"].empty());
+
+    // Several times the ring size in each direction
+    std::string large(kRingCapacity * 5, 'z');
+    json echoed = client.call(
+        "tools/call", {{"name", "echo"}, {"arguments", {{"message", large}}}});
+    CHECK_EQ(echoed["content"][0]["text"], json("Echo: " + large));
+
+    bool failed = false;
+    try {
+      client.call("no/such/method");
+    } catch (const McpError &e) {
+      failed = e.code() == -32601;
+    }
+    CHECK(failed);
+
+    // Raw JSON-RPC text
+    CHECK(client.send(R"({"jsonrpc":"2.0","id":"raw","method":"ping"})"));
+    std::string response;
+    CHECK(client.receive(response));
+    json pong = json::parse(response);
+    CHECK_EQ(pong["id"], json("raw"));
+  }
+
+  // The client is gone: serve() returns
+  serving.join();
+  return checkExitCode();
+}
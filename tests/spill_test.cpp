@@ -0,0 +1,115 @@
+// Result spilling: results over the threshold are stored and named by URI
+// instead of inlined, read back through resources/read, shared when
+// identical and evicted past the store's bound.
+#include <cstdint>
+#include <string>
+
+#include "check.h"
+#include "mcp_logger.h"
+#include "mcp_server.h"
+#include "spill_store.h"
+
+namespace {
+
+json request(McpServer &server, const std::string &method, const json &params) {
+  std::string response;
+  server.processRequest(
+      json{{"jsonrpc", "2.0"},
+           {"id", 1},
+           {"method", method},
+           {"params", params}}
+          .dump(),
+      response);
+  return json::parse(response);
+}
+
+json callContent(McpServer &server, const std::string &tool,
+                 const json &arguments) {
+  json response =
+      request(server, "tools/call", {{"name", tool}, {"arguments", arguments}});
+  CHECK(!response.contains("error"));
+  return response["result"].value("content", json::array());
+}
+
+// URI named by the spill note in 'content', "" if there is none
+std::string spilledUri(const json &content) {
+  const std::string marker = "read it with resources/read from ";
+  for (const auto &item : content) {
+    std::string text = item.value("text", "");
+    size_t at = text.find(marker);
+    if (item.value("type", "") == "text" && at != std::string::npos) {
+      return text.substr(at + marker.size());
+    }
+  }
+  return "";
+}
+
+// Whole contents of 'uri', following nextOffset
+std::string readAll(McpServer &server, const std::string &uri) {
+  std::string data;
+  uint64_t offset = 0;
+  for (;;) {
+    json response =
+        request(server, "resources/read",
+                {{"uri", uri}, {"offset", offset}, {"length", 100}});
+    if (!response.contains("result")) return data + "<error>";
+    const json &content = response["result"]["contents"][0];
+    data += content.value("text", "");
+    if (!content.contains("nextOffset")) return data;
+    offset = content["nextOffset"].get<uint64_t>();
+  }
+}
+
+void setup(McpServer &server) {
+  server.initialize();
+  CHECK(server.enableResultSpill("", 64, 4096));
+
+  McpTool repeat;
+  repeat.name = "repeat";
+  repeat.inputSchema = {{"type", "object"}};
+  server.addTool(repeat, [](const json &arguments) -> json {
+    return std::string(arguments.value("count", size_t{0}),
+                       arguments.value("char", std::string("x"))[0]);
+  });
+}
+
+void spilledResults() {
+  McpServer server("spill_test", "1.0");
+  setup(server);
+
+  // Under the threshold: inline text
+  json small = callContent(server, "repeat", {{"count", 10}});
+  CHECK_EQ(small.size(), size_t{1});
+  CHECK_EQ(small[0]["text"], json(std::string(10, 'x')));
+
+  // Over it: a single note naming the stored result
+  json large = callContent(server, "repeat", {{"count", 1000}});
+  CHECK_EQ(large.size(), size_t{1});
+  std::string uri = spilledUri(large);
+  CHECK(!uri.empty());
+  CHECK(large[0].value("text", "").find("1000 bytes") != std::string::npos);
+  CHECK_EQ(readAll(server, uri), std::string(1000, 'x'));
+
+  // Identical results share a file
+  SpillStore *store = server.getSpillStore();
+  size_t files = store->fileCount();
+  json again = callContent(server, "repeat", {{"count", 1000}});
+  CHECK_EQ(store->fileCount(), files);
+  CHECK_EQ(spilledUri(again), uri);
+
+  // The store stays within its bound
+  for (char c = 'a'; c <= 'h'; ++c) {
+    callContent(server, "repeat",
+                {{"count", 1000}, {"char", std::string(1, c)}});
+  }
+  CHECK(store->totalBytes() <= 4096);
+  CHECK(store->fileCount() < 9);
+}
+
+}  // namespace
+
+int main() {
+  spdlog::set_level(spdlog::level::off);
+  spilledResults();
+  return checkExitCode();
+}
@@ -0,0 +1,47 @@
+// Plugin built twice for plugin_test: TEST_PLUGIN_VERSION tells the builds
+// apart, so the test can swap one for the other and see the reload.
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "mcp_plugin.h"
+
+namespace {
+
+char *copy(const std::string &text) {
+  char *buffer = static_cast<char *>(std::malloc(text.size() + 1));
+  std::memcpy(buffer, text.c_str(), text.size() + 1);
+  return buffer;
+}
+
+}  // namespace
+
+extern "C" {
+
+int mcp_plugin_call(const char *tool, const char *arguments_json,
+                    char **result_json) {
+  if (std::strcmp(tool, "plugin_version") == 0) {
+    *result_json = copy(std::to_string(TEST_PLUGIN_VERSION));
+    return 0;
+  }
+  if (std::strcmp(tool, "plugin_echo") == 0) {
+    *result_json = copy(arguments_json);
+    return 0;
+  }
+  *result_json = copy(std::string("no such tool: ") + tool);
+  return 1;
+}
+
+void mcp_plugin_free(char *result_json) { std::free(result_json); }
+
+const char *mcp_plugin_manifest(void) {
+  return R"({"tools": [
+    {"name": "plugin_version", "description": "Build of this plugin",
+     "inputSchema": {"type": "object"}},
+    {"name": "plugin_echo", "description": "Returns its arguments",
+     "inputSchema": {"type": "object"}},
+    {"name": "plugin_missing", "description": "Not implemented",
+     "inputSchema": {"type": "object"}}]})";
+}
+
+}  // extern "C"
@@ -0,0 +1,64 @@
+// Typed tool results: only values built by ToolContent::result() count,
+// unknown items become text, audio and resource links are turned into types
+// protocol 2024-11-05 has, binary data is base64 encoded wherever it sits,
+// and buildCallResult keeps typed items while plain values become text.
+#include <string>
+
+#include "check.h"
+#include "mcp_logger.h"
+#include "mcp_server.h"
+#include "tool_content.h"
+
+int main() {
+  spdlog::set_level(spdlog::level::off);
+
+  json typed = ToolContent::result(
+      {ToolContent::text("hi"), ToolContent::image({1, 2, 3}, "image/png"),
+       json{{"not", "content"}}, 42,
+       ToolContent::audio({1, 2, 3, 4}, "audio/wav"),
+       json{{"type", "resource_link"}, {"uri", "file:///a.txt"},
+            {"name", "a.txt"}}},
+      true);
+  CHECK(ToolContent::isResult(typed));
+  CHECK(!ToolContent::isResult(json{{"content", json::array()}}));
+  CHECK(!ToolContent::isResult("text"));
+  CHECK(ToolContent::isResult(ToolContent::result(ToolContent::text("one"))));
+
+  ToolContent::finishResult(typed);
+  CHECK(!typed.contains(ToolContent::kResultMarker));
+  CHECK_EQ(typed["isError"], json(true));
+  CHECK_EQ(typed["content"][1]["type"], json("image"));
+  CHECK(typed["content"][1]["data"].is_binary());
+  CHECK_EQ(typed["content"][2], ToolContent::text(R"({"not":"content"})"));
+  CHECK_EQ(typed["content"][3], ToolContent::text("42"));
+  json sound = typed["content"][4];
+  CHECK_EQ(sound["type"], json("resource"));
+  CHECK_EQ(sound["resource"]["uri"], json("urn:mcp:audio:5"));
+  CHECK_EQ(sound["resource"]["mimeType"], json("audio/wav"));
+  CHECK_EQ(typed["content"][5],
+           ToolContent::text(
+               "a.txt: read it with resources/read from file:///a.txt"));
+
+  ToolContent::encodeBinary(typed);
+  CHECK_EQ(typed["content"][1]["data"], json("AQID"));
+  json soundBytes = typed["content"][4]["resource"]["blob"];
+  CHECK_EQ(soundBytes, json("AQIDBA=="));
+
+  json nested = {{"a", {json::binary({0xff}), {{"b", json::binary({})}}}}};
+  ToolContent::encodeBinary(nested);
+  CHECK_EQ(nested["a"][0], json("/w=="));
+  CHECK_EQ(nested["a"][1]["b"], json(""));
+
+  McpServer server("tool_content_test", "1.0");
+  json built = server.buildCallResult(ToolContent::result(
+      {ToolContent::blob("mem://x", {0, 1}, "application/octet-stream")}));
+  CHECK_EQ(built["content"][0]["resource"]["blob"], json("AAE="));
+  CHECK(!built.contains(ToolContent::kResultMarker));
+
+  // A plain value that merely looks like a result is sent as text
+  json lookalike = {{"content", json::array({ToolContent::text("x")})}};
+  json plain = server.buildCallResult(lookalike);
+  CHECK_EQ(plain["content"].size(), size_t{1});
+  CHECK_EQ(plain["content"][0]["text"], json(lookalike.dump()));
+  return checkExitCode();
+}
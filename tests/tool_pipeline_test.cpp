@@ -0,0 +1,217 @@
+// run_pipeline: a failing step's error code must reach the client unchanged
+// (-32001 busy, -32003 memory budget), other failures name the step, steps
+// start as soon as their own dependencies are done (on serve()'s work lane,
+// or one after another without it), and $ref arguments pass earlier results
+// (or parts of them) along.
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "check.h"
+#include "mcp_logger.h"
+#include "mcp_server.h"
+#include "memory_accounting.h"
+#include "queue_transport.h"
+
+namespace {
+
+// Through serve(), so steps can run on the work lane
+json runPipeline(QueueTransport &transport, const json &arguments) {
+  static int id = 0;
+  transport.push(toolCall(++id, "run_pipeline", arguments));
+  auto response = transport.waitFor(id, std::chrono::seconds(10));
+  CHECK(response.has_value());
+  return response ? response->first : json::object();
+}
+
+// Straight through processRequest, with no scheduler to hand steps to
+json runDirect(McpServer &server, const json &arguments) {
+  std::string response;
+  server.processRequest(toolCall(1, "run_pipeline", arguments), response);
+  return json::parse(response);
+}
+
+// The pipeline's own result, sent as JSON text
+json resultOf(const json &response) {
+  if (!response.contains("result")) return nullptr;
+  return json::parse(
+      response["result"]["content"][0].value("text", std::string("null")));
+}
+
+std::string errorMessage(const json &response) {
+  return response.contains("error") ? response["error"].value("message", "")
+                                    : std::string();
+}
+
+int errorCode(const json &response) {
+  return response.contains("error") ? response["error"].value("code", 0) : 0;
+}
+
+json step(const std::string &id, const std::string &tool,
+          json arguments = json::object(), json dependsOn = json::array()) {
+  return {{"id", id},
+          {"tool", tool},
+          {"arguments", std::move(arguments)},
+          {"dependsOn", std::move(dependsOn)}};
+}
+
+}  // namespace
+
+int main() {
+  spdlog::set_level(spdlog::level::off);
+  McpServer server("tool_pipeline_test", "1.0");
+  server.initialize();
+
+  McpTool tool;
+  tool.inputSchema = {{"type", "object"}};
+
+  // One call at a time and no queue: a second parallel step is rejected
+  tool.name = "single";
+  tool.maxConcurrency = 1;
+  tool.maxQueued = 0;
+  server.addTool(tool, [](const json &arguments) -> json {
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(arguments.value("ms", 100)));
+    return "done";
+  });
+  tool.maxConcurrency = 0;
+
+  tool.name = "nap";
+  server.addTool(tool, [](const json &arguments) -> json {
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(arguments.value("ms", 0)));
+    return arguments.value("ms", 0);
+  });
+
+  tool.name = "fail";
+  server.addTool(tool, [](const json &) -> json {
+    throw std::runtime_error("broken");
+  });
+
+  tool.name = "hog";
+  tool.memoryBudget = 1 << 16;
+  server.addTool(tool, [](const json &) -> json {
+    return std::string(1 << 20, 'x').size();
+  });
+
+  QueueTransport transport;
+  std::thread serving([&] { server.serve(transport, 4); });
+
+  json busy = runPipeline(
+      transport, {{"steps", {step("a", "single", {{"ms", 300}}),
+                          step("b", "single", {{"ms", 300}})}}});
+  CHECK_EQ(errorCode(busy), -32001);
+
+  json failed = runPipeline(
+      transport, {{"steps", {step("ok", "nap"), step("bad", "fail")}}});
+  CHECK_EQ(errorCode(failed), -32603);
+  CHECK(failed["error"]["message"].get<std::string>().find("'bad'") !=
+        std::string::npos);
+
+  // Counting needs the allocator hooks, which only some builds link
+  if (MemoryScope::supported()) {
+    json hog = runPipeline(
+        transport, {{"steps", {step("ok", "nap"), step("big", "hog")}}});
+    CHECK_EQ(errorCode(hog), -32003);
+  }
+
+  // a(100) -> b(300) beside c(300) -> d(100): scheduled by dependency this
+  // takes about 400 ms, in waves 600 ms
+  auto start = std::chrono::steady_clock::now();
+  json dag = runPipeline(
+      transport,
+      {{"output", "all"},
+       {"steps",
+        {step("a", "nap", {{"ms", 100}}),
+         step("c", "nap", {{"ms", 300}}),
+         step("b", "nap", {{"ms", 300}}, {"a"}),
+         step("d", "nap", {{"ms", 100}}, {"c"})}}});
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - start)
+                     .count();
+  CHECK_EQ(errorCode(dag), 0);
+  CHECK(elapsed < 550);
+
+  tool.name = "make";
+  tool.memoryBudget = 0;
+  server.addTool(tool, [](const json &) -> json {
+    return {{"list", {10, 20, 30}}, {"name", "x"}};
+  });
+  tool.name = "args";
+  server.addTool(tool, [](const json &arguments) -> json { return arguments; });
+
+  // Whole results and JSON pointers into them; dependencies come from the
+  // references alone
+  json refs = runPipeline(
+      transport,
+      {{"steps",
+        {step("a", "make"),
+         step("b", "args",
+              {{"second", {{"$ref", "a/list/1"}}},
+               {"nested", {{{"$ref", "a/name"}}, 1}},
+               {"whole", {{"$ref", "a"}}}})}}});
+  json expected = {{"second", 20},
+                   {"nested", {"x", 1}},
+                   {"whole", {{"list", {10, 20, 30}}, {"name", "x"}}}};
+  CHECK_EQ(resultOf(refs), expected);
+
+  json chosen = runPipeline(
+      transport,
+      {{"final", "a"}, {"steps", {step("a", "make"), step("b", "args")}}});
+  json made = resultOf(chosen);
+  CHECK_EQ(made["name"], json("x"));
+
+  // Rejected before anything runs, or when a pointer does not resolve
+  json unknown = runPipeline(
+      transport, {{"steps", {step("b", "args", {{"v", {{"$ref", "zz"}}}})}}});
+  CHECK(errorMessage(unknown).find("unknown step 'zz'") != std::string::npos);
+  json cycle = runPipeline(
+      transport, {{"steps", {step("a", "args", json::object(), {"b"}),
+                          step("b", "args", json::object(), {"a"})}}});
+  CHECK(errorMessage(cycle).find("cycle") != std::string::npos);
+  json duplicate =
+      runPipeline(transport, {{"steps", {step("a", "make"), step("a", "make")}}});
+  CHECK(errorMessage(duplicate).find("Duplicate") != std::string::npos);
+  json nested = runPipeline(
+      transport,
+      {{"steps", {step("p", "run_pipeline", {{"steps", json::array()}})}}});
+  CHECK(errorMessage(nested).find("nested") != std::string::npos);
+  json missing = runPipeline(
+      transport, {{"steps", {step("a", "make"),
+                          step("b", "args", {{"v", {{"$ref", "a/nope"}}}})}}});
+  CHECK(errorMessage(missing).find("reference not found") !=
+        std::string::npos);
+  transport.close();
+  serving.join();
+
+  // Without serve() the same steps run one after another on this thread
+  json direct = runDirect(
+      server, {{"output", "all"},
+               {"steps", {step("a", "nap", {{"ms", 1}}),
+                          step("b", "nap", {{"ms", 2}}),
+                          step("c", "nap", {{"ms", 3}}, {"a", "b"})}}});
+  json directResults = resultOf(direct);
+  CHECK_EQ(directResults["results"]["c"], json(3));
+
+  // With a single worker, busy running the pipeline itself, its steps still
+  // run (on that worker)
+  McpServer single("tool_pipeline_test", "1.0");
+  single.initialize();
+  tool.name = "nap";
+  tool.memoryBudget = 0;
+  single.addTool(tool, [](const json &arguments) -> json {
+    return arguments.value("ms", 0);
+  });
+  QueueTransport singleTransport;
+  std::thread singleServing([&] { single.serve(singleTransport, 1); });
+  json lone = runPipeline(
+      singleTransport,
+      {{"steps", {step("a", "nap", {{"ms", 1}}), step("b", "nap", {{"ms", 2}}),
+                  step("c", "nap", {{"ms", 3}}, {"a", "b"})}}});
+  CHECK_EQ(resultOf(lone), json(3));
+  singleTransport.close();
+  singleServing.join();
+
+  return checkExitCode();
+}
@@ -0,0 +1,148 @@
+// Tool registry snapshots and their search index: copies and forks never see
+// each other's changes (copies in either direction), and readers searching
+// old snapshots are unaffected by a writer publishing new ones.
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+#include "mcp_logger.h"
+#include "tool_index.h"
+#include "tool_registry.h"
+
+namespace {
+
+McpTool makeTool(const std::string &name, const std::string &description) {
+  McpTool tool;
+  tool.name = name;
+  tool.description = description;
+  tool.inputSchema = {{"type", "object"}};
+  return tool;
+}
+
+bool finds(const ToolIndex &index, const std::string &query,
+           const std::string &name) {
+  for (const auto &hit : index.search(query, 10)) {
+    if (hit.name == name) return true;
+  }
+  return false;
+}
+
+void copiesAreIndependent() {
+  ToolIndex original;
+  original.addTool(makeTool("read_file", "Read a file from disk"));
+  original.addTool(makeTool("list_dir", "List a directory"));
+
+  ToolIndex copy(original);
+  copy.addTool(makeTool("write_file", "Write a file to disk"));
+  copy.removeTool("list_dir");
+  CHECK(finds(copy, "file", "write_file"));
+  CHECK(!finds(copy, "directory", "list_dir"));
+  CHECK_EQ(copy.size(), size_t{2});
+
+  // The source is untouched by the copy's changes...
+  CHECK(!finds(original, "write", "write_file"));
+  CHECK(finds(original, "directory", "list_dir"));
+  CHECK_EQ(original.size(), size_t{2});
+
+  // ...and the copy by the source's, made after the copy was taken
+  original.removeTool("read_file");
+  original.addTool(makeTool("grep", "Search file contents"));
+  CHECK(finds(copy, "read", "read_file"));
+  CHECK(!finds(copy, "search", "grep"));
+  CHECK(finds(original, "search", "grep"));
+
+  ToolIndex assigned;
+  assigned = copy;
+  assigned.removeTool("read_file");
+  CHECK(finds(copy, "read", "read_file"));
+  CHECK(!finds(assigned, "read", "read_file"));
+}
+
+void forksCloneOnWrite() {
+  ToolIndex source;
+  source.addTool(makeTool("read_file", "Read a file from disk"));
+  const ToolIndex &published = source;
+
+  ToolIndex first = published.fork();
+  ToolIndex second = published.fork();
+  first.addTool(makeTool("write_file", "Write a file to disk"));
+  first.removeTool("read_file");
+  second.addTool(makeTool("grep", "Search file contents"));
+
+  CHECK(finds(source, "read", "read_file"));
+  CHECK(!finds(source, "write", "write_file"));
+  CHECK(!finds(source, "search", "grep"));
+  CHECK_EQ(source.size(), size_t{1});
+  CHECK(!finds(first, "read", "read_file"));
+  CHECK(!finds(first, "search", "grep"));
+  CHECK(finds(second, "read", "read_file"));
+  CHECK(!finds(second, "write", "write_file"));
+
+  // A fork of a fork, after the first one changed
+  ToolIndex third = first.fork();
+  third.addTool(makeTool("list_dir", "List a directory"));
+  CHECK(!finds(first, "directory", "list_dir"));
+  CHECK(finds(third, "write", "write_file"));
+}
+
+void snapshotsSurviveUpdates() {
+  ToolRegistry registry;
+  auto handler = [](const json &) -> json { return "ok"; };
+  registry.addTool(makeTool("alpha", "First tool"), handler);
+  auto before = registry.snapshot();
+
+  registry.addTool(makeTool("beta", "Second tool"), handler);
+  registry.removeTool("alpha");
+  auto after = registry.snapshot();
+
+  CHECK(before->find("alpha") != nullptr);
+  CHECK(before->find("beta") == nullptr);
+  CHECK(finds(before->index, "first", "alpha"));
+  CHECK(!finds(before->index, "second", "beta"));
+  CHECK(after->find("alpha") == nullptr);
+  CHECK(!finds(after->index, "first", "alpha"));
+  CHECK(finds(after->index, "second", "beta"));
+  CHECK(after->version > before->version);
+}
+
+void readersDuringUpdates() {
+  ToolRegistry registry;
+  auto handler = [](const json &) -> json { return "ok"; };
+  registry.addTool(makeTool("stable", "Always registered"), handler);
+
+  std::atomic<bool> stop{false};
+  std::atomic<int> misses{0};
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; ++i) {
+    readers.emplace_back([&] {
+      while (!stop.load()) {
+        // Searching a snapshot while newer ones are built from it, and
+        // dropping it while the writer may be cloning its shards
+        auto snapshot = registry.snapshot();
+        if (!finds(snapshot->index, "always", "stable")) ++misses;
+      }
+    });
+  }
+  for (int i = 0; i < 500; ++i) {
+    std::string name = "tool_" + std::to_string(i % 20);
+    registry.addTool(makeTool(name, "Churn tool " + std::to_string(i)),
+                     handler);
+    if (i % 3 == 0) registry.removeTool(name);
+  }
+  stop = true;
+  for (auto &reader : readers) reader.join();
+  CHECK_EQ(misses.load(), 0);
+}
+
+}  // namespace
+
+int main() {
+  spdlog::set_level(spdlog::level::off);
+  copiesAreIndependent();
+  forksCloneOnWrite();
+  snapshotsSurviveUpdates();
+  readersDuringUpdates();
+  return checkExitCode();
+}
@@ -0,0 +1,94 @@
+// search_tools: matches on names (split at camelCase and underscores),
+// descriptions and argument names, best match first, within the limit, and
+// follows tools as they are added and removed.
+#include <string>
+#include <vector>
+
+#include "check.h"
+#include "mcp_logger.h"
+#include "mcp_server.h"
+#include "queue_transport.h"
+#include "tool_index.h"
+
+namespace {
+
+json search(McpServer &server, const json &arguments) {
+  std::string response;
+  server.processRequest(toolCall(1, "search_tools", arguments), response);
+  json parsed = json::parse(response);
+  CHECK(!parsed.contains("error"));
+  return json::parse(
+      parsed["result"]["content"][0].value("text", std::string("{}")))
+      .value("results", json::array());
+}
+
+std::vector<std::string> names(const json &results) {
+  std::vector<std::string> found;
+  for (const auto &result : results) found.push_back(result["name"]);
+  return found;
+}
+
+void addTool(McpServer &server, const std::string &name,
+             const std::string &description, const json &properties) {
+  McpTool tool;
+  tool.name = name;
+  tool.description = description;
+  tool.inputSchema = {{"type", "object"}, {"properties", properties}};
+  server.addTool(tool, [](const json &) -> json { return "ok"; });
+}
+
+}  // namespace
+
+int main() {
+  spdlog::set_level(spdlog::level::off);
+
+  CHECK(ToolIndex::tokenize("readFile_v2") ==
+        std::vector<std::string>({"read", "file", "v2"}));
+
+  McpServer server("tool_search_test", "1.0");
+  server.initialize();
+  addTool(server, "readFile", "Read a file from disk",
+          {{"path", {{"type", "string"}}}});
+  addTool(server, "weather_forecast", "Forecast for a city",
+          {{"city", {{"type", "string"}}}});
+  addTool(server, "translate", "Translate text between languages",
+          {{"targetLanguage", {{"type", "string"}}}});
+
+  // Name parts, description words and argument names all match
+  json byName = search(server, {{"query", "read file"}});
+  CHECK(!byName.empty() && byName[0]["name"] == "readFile");
+  CHECK(names(search(server, {{"query", "forecast"}})) ==
+        std::vector<std::string>({"weather_forecast"}));
+  json byArgument = search(server, {{"query", "city"}});
+  CHECK(!byArgument.empty() && byArgument[0]["name"] == "weather_forecast");
+  CHECK(!search(server, {{"query", "language"}}).empty());
+  CHECK(search(server, {{"query", "nonexistent"}}).empty());
+
+  // Best match first, and scores never increase down the list
+  json ranked = search(server, {{"query", "file text"}, {"limit", 10}});
+  for (size_t i = 1; i < ranked.size(); ++i) {
+    CHECK(ranked[i]["score"].get<double>() <=
+          ranked[i - 1]["score"].get<double>());
+  }
+
+  // Limit and schema
+  for (int i = 0; i < 20; ++i) {
+    addTool(server, "bulk_" + std::to_string(i), "Bulk widget tool",
+            json::object());
+  }
+  CHECK_EQ(search(server, {{"query", "widget"}, {"limit", 5}}).size(),
+           size_t{5});
+  CHECK_EQ(search(server, {{"query", "widget"}}).size(), size_t{10});
+  json withSchema =
+      search(server, {{"query", "translate"}, {"includeSchema", true}});
+  CHECK(!withSchema.empty() && withSchema[0].contains("inputSchema"));
+  json withoutSchema = search(server, {{"query", "translate"}});
+  CHECK(!withoutSchema.empty() && !withoutSchema[0].contains("inputSchema"));
+
+  // Removed tools drop out of the index
+  CHECK(server.removeTool("translate"));
+  for (const auto &name : names(search(server, {{"query", "translate"}}))) {
+    CHECK(name != "translate");
+  }
+  return checkExitCode();
+}
@@ -0,0 +1,119 @@
+// UringAdapter over a pipe and a socket pair, with io_uring where the
+// kernel allows it and the read()/write() fallback otherwise: lines split
+// across writes, lines longer than the read buffer, empty lines and a final
+// line without a newline come back as getline() would return them, and
+// messages written from threads that exit right after writing all arrive.
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+#include "mcp_logger.h"
+#include "uring_adapter.h"
+
+namespace {
+
+void writeAll(int fd, const std::string &data) {
+  size_t done = 0;
+  while (done < data.size()) {
+    ssize_t n = write(fd, data.data() + done, data.size() - done);
+    if (n <= 0) return;
+    done += static_cast<size_t>(n);
+  }
+}
+
+std::string readAll(int fd) {
+  std::string data;
+  char buffer[4096];
+  ssize_t n;
+  while ((n = read(fd, buffer, sizeof(buffer))) > 0) data.append(buffer, n);
+  return data;
+}
+
+// Reads through the adapter from 'in' while the test feeds the other end
+void reading(int in, int feed) {
+  UringAdapter adapter(in, -1);
+  std::string longLine(UringAdapter::kReadBufferSize * 3 + 7, 'x');
+  std::thread writer([&] {
+    writeAll(feed, "{\"a\":");
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    writeAll(feed, "1}\n{\"b\":2}\n\n" + longLine + "\nlast");
+    close(feed);
+  });
+
+  std::vector<std::string> messages;
+  std::string message;
+  while (adapter.readMessage(message)) messages.push_back(message);
+  writer.join();
+
+  CHECK_EQ(messages.size(), size_t{5});
+  if (messages.size() == 5) {
+    CHECK_EQ(messages[0], std::string("{\"a\":1}"));
+    CHECK_EQ(messages[1], std::string("{\"b\":2}"));
+    CHECK(messages[2].empty());
+    CHECK(messages[3] == longLine);
+    CHECK_EQ(messages[4], std::string("last"));
+  }
+}
+
+void writing(int out, int drain) {
+  constexpr int kThreads = 4;
+  constexpr int kMessages = 200;
+  std::string received;
+  std::thread reader([&] { received = readAll(drain); });
+  {
+    UringAdapter adapter(-1, out);
+    std::vector<std::thread> writers;
+    for (int t = 0; t < kThreads; ++t) {
+      writers.emplace_back([&, t] {
+        for (int i = 0; i < kMessages; ++i) {
+          adapter.writeMessage(std::to_string(t) + ":" + std::to_string(i) +
+                               std::string(100, 'y'));
+        }
+      });
+    }
+    // Their last writes may still be in flight when they exit
+    for (auto &writer : writers) writer.join();
+  }
+  close(out);
+  reader.join();
+
+  std::set<std::string> lines;
+  size_t start = 0, end;
+  while ((end = received.find('\n', start)) != std::string::npos) {
+    lines.insert(received.substr(start, end - start));
+    start = end + 1;
+  }
+  CHECK_EQ(lines.size(), size_t{kThreads * kMessages});
+  CHECK(lines.count("3:199" + std::string(100, 'y')) == 1);
+}
+
+}  // namespace
+
+int main() {
+  spdlog::set_level(spdlog::level::off);
+  std::printf("io_uring %s\n",
+              UringAdapter::available() ? "available" : "not available");
+
+  int fds[2];
+  CHECK(pipe(fds) == 0);
+  reading(fds[0], fds[1]);
+  close(fds[0]);
+  CHECK(pipe(fds) == 0);
+  writing(fds[1], fds[0]);
+  close(fds[0]);
+
+  // Sockets take the multishot receive path where it is supported
+  CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+  reading(fds[0], fds[1]);
+  close(fds[0]);
+  CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+  writing(fds[1], fds[0]);
+  close(fds[0]);
+  return checkExitCode();
+}
@@ -0,0 +1,86 @@
+// Out-of-process tool workers: results come back from the worker, a crash
+// or a timeout fails only that call and the worker is replaced, and calls
+// beyond the pool size wait at most the call timeout before being rejected.
+#include <chrono>
+#include <cstdlib>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "admission_controller.h"
+#include "check.h"
+#include "mcp_logger.h"
+#include "worker_pool.h"
+
+namespace {
+
+// Runs in the worker process
+json runTool(const std::string &tool, const json &arguments) {
+  if (tool == "nap") {
+    std::this_thread::sleep_for(
+        std::chrono::milliseconds(arguments.value("ms", 0)));
+    return arguments.value("ms", 0);
+  }
+  if (tool == "crash") std::abort();
+  if (tool == "fail") throw std::runtime_error("failed in worker");
+  return json(getpid());
+}
+
+template <typename Call>
+std::string errorOf(Call call) {
+  try {
+    call();
+  } catch (const ServerBusyError &) {
+    return "busy";
+  } catch (const std::exception &e) {
+    return e.what();
+  }
+  return "";
+}
+
+}  // namespace
+
+int main() {
+  spdlog::set_level(spdlog::level::off);
+  WorkerPoolOptions options;
+  options.workers = 1;
+  options.callTimeoutMs = 1000;
+  // Forked before any other thread exists
+  WorkerPool pool(runTool, options);
+
+  // Runs out of process, and reports tool errors as exceptions
+  CHECK(pool.call("pid", json::object()).get<int>() != getpid());
+  CHECK_EQ(errorOf([&] { pool.call("fail", json::object()); }),
+           std::string("failed in worker"));
+
+  // A crash fails the call and the worker is respawned for the next one
+  std::string crashed = errorOf([&] { pool.call("crash", json::object()); });
+  CHECK(crashed.find("crashed") != std::string::npos);
+  CHECK_EQ(pool.respawnCount(), size_t{1});
+  CHECK_EQ(pool.call("nap", {{"ms", 1}}), json(1));
+
+  // Past the call timeout the worker is killed
+  std::string slow = errorOf([&] { pool.call("nap", {{"ms", 3000}}); });
+  CHECK(slow.find("timed out") != std::string::npos);
+  CHECK_EQ(pool.respawnCount(), size_t{2});
+
+  // One worker, three calls of 700 ms: the second gets the worker once the
+  // first is done, the third gives up waiting after the call timeout
+  auto first = std::async(std::launch::async,
+                          [&] { return pool.call("nap", {{"ms", 700}}); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  auto second = std::async(std::launch::async,
+                           [&] { return pool.call("nap", {{"ms", 700}}); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  auto start = std::chrono::steady_clock::now();
+  std::string third = errorOf([&] { pool.call("nap", {{"ms", 700}}); });
+  auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+  CHECK_EQ(third, std::string("busy"));
+  CHECK(waited.count() >= 900 && waited.count() < 1500);
+  CHECK_EQ(first.get(), json(700));
+  CHECK_EQ(second.get(), json(700));
+
+  return checkExitCode();
+}